@@ -113,7 +113,7 @@ double Aeolus::masterTuning() const
 //   play
 //---------------------------------------------------------
 
-void Aeolus::play(const Event& event)
+void Aeolus::play(const ChannelEvent& event)
       {
       int ch   = event.channel();
       int type = event.type();
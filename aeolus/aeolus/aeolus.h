@@ -22,7 +22,7 @@
 #define __AEOLUS_H__
 
 struct MidiPatch;
-class Event;
+struct ChannelEvent;
 
 #include "stdint.h"
 #include "msynth/synti.h"
@@ -103,7 +103,7 @@ class Aeolus : public Synth {
       virtual QStringList soundFonts() const { return QStringList(); }
 
       virtual void process(unsigned, float*, float);
-      virtual void play(const Event&);
+      virtual void play(const ChannelEvent&);
 
       virtual const QList<MidiPatch*>& getPatchInfo() const;
 
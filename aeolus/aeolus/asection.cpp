@@ -18,6 +18,7 @@
 
 
 #include "asection.h"
+#include "v4sf.h"
 
 extern float exp2ap (float);
 
@@ -118,18 +119,7 @@ void Asection::process (float vol, float *W, float *X, float *Y, float *R)
       float* p = _base + _offs0;
       float gr = 0.5f * _apar [REVERB].fval();
 
-      for (int i = 0; i < PERIOD; i++) {
-            float t0 = p [0 * N];
-            float t1 = p [1 * N];
-            float t2 = p [2 * N];
-            float t3 = p [3 * N];
-            p++;
-            s = t0 + t1 + t2 + t3;
-            R [i] += gr * s;
-            W [i] += gw * s;
-            x [i] = gx1 * (t3 + t0) + gx2 * (t2 + t1);
-            y [i] = gy1 * (t3 - t0) + gy2 * (t2 - t1);
-            }
+      matrix4 (p, N, PERIOD, gr, gw, gx1, gx2, gy1, gy2, R, W, x, y);
 
       gr = vol * _apar [REFLECT].fval();
       p = _base;
@@ -152,10 +142,7 @@ void Asection::process (float vol, float *W, float *X, float *Y, float *R)
       g = 6.283184f * _apar [AZIMUTH].fval();
       gx1 = cosf (g);
       gy1 = sinf (g);
-      for (int i = 0; i < PERIOD; i++) {
-            X [i] += gx1 * x [i] + gy1 * y [i];
-            Y [i] += gx1 * y [i] - gy1 * x [i];
-            }
+      rotate4 (X, Y, x, y, PERIOD, gx1, gy1);
       _offs0 = (_offs0 + PERIOD) & (N - 1);
       for (int i = 0; i < 16; i++)
             _offs [i] = ((_offs [i] + PERIOD) & (N - 1)) + (i >> 2) * N;
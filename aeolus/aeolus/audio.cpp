@@ -19,6 +19,7 @@
 
 #include "messages.h"
 #include "aeolus.h"
+#include "v4sf.h"
 
 //---------------------------------------------------------
 //   start
@@ -190,10 +191,12 @@ void Aeolus::process(unsigned nframes, float* out, float gain)
 
                   _reverb.process(PERIOD, gain, R, W, X, Y);
 
-                  float stposit = _audiopar[STPOSIT].fval();
-                  for (int j = 0; j < PERIOD; j++) {
-                        loutb[j] = W[j] + stposit * X[j] + Y[j];
-                        routb[j] = W[j] + stposit * X[j] - Y[j];
+                  const v4sf stposit = splat4(_audiopar[STPOSIT].fval());
+                  for (int j = 0; j < PERIOD; j += 4) {
+                        v4sf m = load4(W + j) + stposit * load4(X + j);
+                        v4sf y = load4(Y + j);
+                        store4(loutb + j, m + y);
+                        store4(routb + j, m - y);
                         }
                   nout = PERIOD;
                   k += PERIOD;
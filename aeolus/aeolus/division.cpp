@@ -18,6 +18,7 @@
 
 
 #include "division.h"
+#include "v4sf.h"
 
 //---------------------------------------------------------
 //   Division
@@ -77,19 +78,14 @@ void Division::process()
             g = t;
 
       float d  = (g - _gain) / PERIOD;
-      g        = _gain;
       float* p = _buff;
       float* q = _asect->get_wptr ();
 
-      for (int i = 0; i < PERIOD; i++) {
-            g += d;
-            q [0 * PERIOD * MIXLEN] += p [0 * PERIOD] * g;
-            q [1 * PERIOD * MIXLEN] += p [1 * PERIOD] * g;
-            q [2 * PERIOD * MIXLEN] += p [2 * PERIOD] * g;
-            q [3 * PERIOD * MIXLEN] += p [3 * PERIOD] * g;
-            p++;
-            q++;
-            }
+      // mix the four channels into the section, ramping the gain
+      // from the last period's value to the new one
+
+      for (int c = 0; c < NCHANN; c++)
+            add_ramp (q + c * PERIOD * MIXLEN, p + c * PERIOD, PERIOD, _gain + d, -d);
       _gain = g;
       }
 
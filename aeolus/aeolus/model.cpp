@@ -413,60 +413,120 @@ void Model::init_iface()
       set_mconf (0, _chconf[0]._bits);
       }
 
+//---------------------------------------------------------
+//   init_ranks
+//    The wavetables of all ranks are loaded or generated
+//    in parallel and then handed to the divisions.
+//---------------------------------------------------------
+
 void Model::init_ranks (int comm)
       {
       _count++;
       _ready = false;
 //WS      send_event (TO_IFACE, new M_ifc_retune (_fbase, _itemp));
 
+      QList<M_def_rank*> ml;
       for (int g = 0; g < _ngroup; g++) {
             Group* G = _group + g;
-            for (int i = 0; i < G->_nifelm; i++)
-                  proc_rank (g, i, comm);
+            for (int i = 0; i < G->_nifelm; i++) {
+                  if (comm == MT_SAVE_RANK)
+                        proc_rank (g, i, comm);
+                  else {
+                        M_def_rank* M = def_rank (g, i, comm);
+                        if (M)
+                              ml.append (M);
+                        }
+                  }
             }
+      QtConcurrent::blockingMap (ml, make_rank);
+      foreach (M_def_rank* M, ml)
+            set_rank (M);
       _ready = true;
       }
 
+//---------------------------------------------------------
+//   proc_rank
+//---------------------------------------------------------
 
 void Model::proc_rank (int g, int i, int comm)
       {
-      Ifelm* I = _group [g]._ifelms + i;
-      if ((I->_type == Ifelm::DIVRANK) || (I->_type == Ifelm::KBDRANK)) {
-            int d = (I->_action0 >> 16) & 255;
-            int r = (I->_action0 >>  8) & 255;
-            Rank* R = _divis [d]._ranks + r;
-            if (comm == MT_SAVE_RANK) {
-                  if (R->_wave->modif ()) {
-                        R->_wave->save(_waves, R->_sdef, _aeolus->_fsamp,
-                           _fbase, scales[_itemp]._data);
-                        }
+      if (comm == MT_SAVE_RANK) {
+            Rank* R = find_rank (g, i);
+            if (R && R->_wave->modif ()) {
+                  R->_wave->save(_waves, R->_sdef, _aeolus->_fsamp,
+                     _fbase, scales[_itemp]._data);
                   }
-            else if (R->_count != _count) {
-                  R->_count = _count;
-                  M_def_rank* M = new M_def_rank (comm);
-                  M->_divis = d;
-                  M->_rank  = r;
-                  M->_group = g;
-                  M->_ifelm = i;
-                  M->_fsamp = _aeolus->_fsamp;
-                  M->_fbase = _fbase;
-                  M->_scale = scales [_itemp]._data;
-                  M->_sdef  = R->_sdef;
-                  M->_wave  = R->_wave;
-                  M->_path  = _waves;
+            }
+      else {
+            M_def_rank* M = def_rank (g, i, comm);
+            if (M) {
+                  make_rank (M);
+                  set_rank (M);
+                  }
+            }
+      }
 
+//---------------------------------------------------------
+//   def_rank
+//    describe the wavetable needed for rank element i of
+//    group g; returns 0 if it is not a rank or was already
+//    handled in this pass
+//---------------------------------------------------------
+
+M_def_rank* Model::def_rank (int g, int i, int comm)
+      {
+      Ifelm* I = _group [g]._ifelms + i;
+      if ((I->_type != Ifelm::DIVRANK) && (I->_type != Ifelm::KBDRANK))
+            return 0;
+      int d = (I->_action0 >> 16) & 255;
+      int r = (I->_action0 >>  8) & 255;
+      Rank* R = _divis [d]._ranks + r;
+      if (R->_count == _count)
+            return 0;
+      R->_count = _count;
+      M_def_rank* M = new M_def_rank (comm);
+      M->_divis = d;
+      M->_rank  = r;
+      M->_group = g;
+      M->_ifelm = i;
+      M->_fsamp = _aeolus->_fsamp;
+      M->_fbase = _fbase;
+      M->_scale = scales [_itemp]._data;
+      M->_sdef  = R->_sdef;
+      M->_wave  = 0;
+      M->_path  = _waves;
 //WS                  send_event(TO_IFACE, new M_ifc_ifelm (MT_IFC_ELATT, M->_group, M->_ifelm));
+      return M;
+      }
 
-                  M->_wave = new Rankwave (M->_sdef->_n0, M->_sdef->_n1);
-                  if (M->_wave->load (M->_path, M->_sdef, M->_fsamp, M->_fbase, M->_scale))
-                        M->_wave->gen_waves (M->_sdef, M->_fsamp, M->_fbase, M->_scale);
+//---------------------------------------------------------
+//   make_rank
+//    called from QtConcurrent worker threads; the waves
+//    are taken from the cache if possible, otherwise they
+//    are generated and written to the cache
+//---------------------------------------------------------
 
-                  _aeolus->_divisp [M->_divis]->set_rank (M->_rank, M->_wave,  M->_sdef->_pan, M->_sdef->_del);
-                  _divis [M->_divis]._ranks [M->_rank]._wave = M->_wave;
-                  }
+void Model::make_rank (M_def_rank*& M)
+      {
+      M->_wave = new Rankwave (M->_sdef->_n0, M->_sdef->_n1);
+      if (M->_wave->load (M->_path, M->_sdef, M->_fsamp, M->_fbase, M->_scale)) {
+            M->_wave->gen_waves (M->_sdef, M->_fsamp, M->_fbase, M->_scale);
+            M->_wave->save (M->_path, M->_sdef, M->_fsamp, M->_fbase, M->_scale);
             }
       }
 
+//---------------------------------------------------------
+//   set_rank
+//    hand the new wavetable to its division
+//---------------------------------------------------------
+
+void Model::set_rank (M_def_rank* M)
+      {
+      _aeolus->_divisp [M->_divis]->set_rank (M->_rank, M->_wave,  M->_sdef->_pan, M->_sdef->_del);
+      _divis [M->_divis]._ranks [M->_rank]._wave = M->_wave;
+      delete M;
+      }
+
 //---------------------------------------------------------
 //   set_ifelm
 //    Set, reset or toggle a stop.
@@ -171,6 +171,9 @@ class Model
       void init_iface();
       void init_ranks(int comm);
       void proc_rank(int g, int i, int comm);
+      M_def_rank* def_rank(int g, int i, int comm);
+      static void make_rank(M_def_rank*& M);
+      void set_rank(M_def_rank* M);
       void set_aupar(int s, int a, int p, float v);
       void set_dipar(int s, int d, int p, float v);
       void set_mconf(int i, uint16_t *d);
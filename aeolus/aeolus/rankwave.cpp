@@ -17,6 +17,7 @@
 */
 
 #include "rankwave.h"
+#include "v4sf.h"
 
 #define DEBUG
 
@@ -24,20 +25,6 @@ extern float exp2ap (float);
 
 
 Rngen   Pipewave::_rgen;
-float  *Pipewave::_arg = 0;
-float  *Pipewave::_att = 0;
-
-
-void Pipewave::initstatic (float fsamp)
-{
-    int k;
-
-    if (_arg) return;
-    k = (int)(fsamp);
-    _arg = new float [k];
-    k = (int)(0.5f * fsamp);
-    _att = new float [k];
-}
 
 
 void Pipewave::play (void)
@@ -81,11 +68,8 @@ void Pipewave::play (void)
 
         if (r < _p1)
         {
-            while (k1--)
-            {
-	        *q++ += g * *r++;
-                g -= dg;
-            }
+            g = add_ramp (q, r, PERIOD, g, dg);
+            r += PERIOD;
         }
         else
 	{
@@ -107,13 +91,8 @@ void Pipewave::play (void)
                     k2 = (int)(-y / dy);
 	        }
                 k1 -= k2;
-                while (k2--)
-       	        {
-                    *q++ += g * (r [0] + y * (r [1] - r [0]));
-                    g -= dg;
-                    y += dy;
-                    r += _k_s;
-	        }
+                r = add_interp (q, r, k2, _k_s, y, dy, g, dg);
+                q += k2;
                 y -= d;
                 r += d;
 	    }
@@ -135,10 +114,8 @@ void Pipewave::play (void)
         q = _out;
         if (p < _p1)
         {
-            while (k1--)
-            {
-		*q++ += *p++;
-	    }
+            add4 (q, p, PERIOD);
+            p += PERIOD;
         }
         else
 	{
@@ -161,12 +138,9 @@ void Pipewave::play (void)
                     k2 = (int)(-y / dy);
 	        }
                 k1 -= k2;
-                while (k2--)
-       	        {
-                    *q++ += p [0] + y * (p [1] - p [0]);
-                    y += dy;
-                    p += _k_s;
-	        }
+                g = 1.0f;
+                p = add_interp (q, p, k2, _k_s, y, dy, g, 0.0f);
+                q += k2;
                 y -= d;
                 p += d;
 	    }
@@ -180,7 +154,7 @@ void Pipewave::play (void)
 }
 
 
-void Pipewave::genwave (Addsynth *D, int n, float fsamp, float fpipe)
+void Pipewave::genwave (Addsynth *D, int n, float fsamp, float fpipe, Rngen& rgen, float *arg, float *att)
 {
     int    h, i, k, nc;
     float  f0, f1, f, m, t, v, v0;
@@ -194,7 +168,7 @@ void Pipewave::genwave (Addsynth *D, int n, float fsamp, float fpipe)
     _l0 = (int)(fsamp * m + 0.5);
     _l0 = (_l0 + PERIOD - 1) & ~(PERIOD - 1);
 
-    f1 = (fpipe + D->_n_off.vi (n) + D->_n_ran.vi (n) * (2 * _rgen.urand () - 1)) / fsamp;
+    f1 = (fpipe + D->_n_off.vi (n) + D->_n_ran.vi (n) * (2 * rgen.urand () - 1)) / fsamp;
     f0 = f1 * exp2ap (D->_n_atd.vi (n) / 1200.0f);
 
     for (h = N_HARM - 1; h >= 0; h--)
@@ -231,14 +205,14 @@ void Pipewave::genwave (Addsynth *D, int n, float fsamp, float fpipe)
     k = (int)(fsamp * D->_n_att.vi (n) + 0.5);
     for (i = 0; i <= _l0; i++)
     {
-        _arg [i] = t - floorf (t + 0.5);
+        arg [i] = t - floorf (t + 0.5);
 	t += (i < k) ? (((k - i) * f0 + i * f1) / k) : f1;
     }
 
     for (i = 1; i < _l1; i++)
     {
-	t = _arg [_l0]+ (float) i * nc / _l1;
-        _arg [i + _l0] = t - floorf (t + 0.5);
+	t = arg [_l0]+ (float) i * nc / _l1;
+        arg [i + _l0] = t - floorf (t + 0.5);
     }
 
     v0 = exp2ap (0.1661 * D->_n_vol.vi (n));
@@ -248,16 +222,16 @@ void Pipewave::genwave (Addsynth *D, int n, float fsamp, float fpipe)
         v = D->_h_lev.vi (h, n);
         if (v < -80.0) continue;
 
-        v = v0 * exp2ap (0.1661 * (v + D->_h_ran.vi (h, n) * (2 * _rgen.urand () - 1)));
+        v = v0 * exp2ap (0.1661 * (v + D->_h_ran.vi (h, n) * (2 * rgen.urand () - 1)));
         k = (int)(fsamp * D->_h_att.vi (h, n) + 0.5);
-        attgain (k, D->_h_atp.vi (h, n));
+        attgain (att, k, D->_h_atp.vi (h, n));
 
         for (i = 0; i < _l0 + _l1; i++)
         {
-	    t = _arg [i] * (h + 1);
+	    t = arg [i] * (h + 1);
             t -= floorf (t);
             m = v * sinf (2 * M_PI * t);
-            if (i < k) m *= _att [i];
+            if (i < k) m *= att [i];
             _p0 [i] += m;
         }
     }
@@ -308,7 +282,7 @@ void Pipewave::looplen (float f, float fsamp, int lmax, int *aa, int *bb)
 }
 
 
-void Pipewave::attgain (int n, float p)
+void Pipewave::attgain (float *att, int n, float p)
 {
     int    i, j, k;
     float  d, m, w, x, y, z;
@@ -328,7 +302,7 @@ void Pipewave::attgain (int n, float p)
         while (j < k)
 	{
             m = (double) j / n;
-            _att [j++] = (1.0 - m) * z + m;
+            att [j++] = (1.0 - m) * z + m;
             z += d;
 	}
     }
@@ -399,15 +373,33 @@ Rankwave::~Rankwave (void)
 }
 
 
+// The scratch buffers and the random generator are local,
+// so several ranks can be generated at once in different
+// threads. The generator is seeded from the cache hash and
+// a count of the generated ranks: seeding from the time
+// would give ranks generated in the same second the same
+// random sequence.
+
+static uint32_t gen_count = 0;
+
 void Rankwave::gen_waves (Addsynth *D, float fsamp, float fbase, float *scale)
 {
-    Pipewave::initstatic (fsamp);
+    Rngen     rgen;
+    uint32_t  seed;
+    float     *arg = new float [(int)(fsamp)];
+    float     *att = new float [(int)(0.5f * fsamp)];
+
+    seed = cache_hash (D, fsamp, fbase, scale);
+    seed += 0x9e3779b9u * __sync_add_and_fetch (&gen_count, 1);
+    rgen.init (seed ? seed : 1);
 
     fbase *=  D->_fn / (D->_fd * scale [9]);
     for (int i = _n0; i <= _n1; i++)
     {
-	_pipes [i - _n0].genwave (D, i - _n0, fsamp, ldexpf (fbase * scale [i % 12], i / 12 - 5));
+	_pipes [i - _n0].genwave (D, i - _n0, fsamp, ldexpf (fbase * scale [i % 12], i / 12 - 5), rgen, arg, att);
     }
+    delete[] arg;
+    delete[] att;
     _modif = true;
 }
 
@@ -447,29 +439,115 @@ void Rankwave::play (int shift)
 }
 
 
+// Waveform files are a cache: their name contains a hash of
+// everything the waves are computed from, so every stop keeps
+// one file per tuning and temperament, and a changed stop
+// definition or file format never picks up stale waves.
+
+static uint32_t hash_bytes (uint32_t h, const void *data, int n)
+{
+    const unsigned char *p = (const unsigned char *) data;
+
+    while (n--)
+    {
+        h ^= *p++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+
+static uint32_t hash_func (uint32_t h, const N_func& F)
+{
+    for (int i = 0; i < N_NOTE; i++)
+    {
+        float v = F.vs (i);
+        h = hash_bytes (h, &v, sizeof (float));
+    }
+    return h;
+}
+
+
+static uint32_t hash_func (uint32_t h, const HN_func& F)
+{
+    for (int j = 0; j < N_HARM; j++)
+    {
+        for (int i = 0; i < N_NOTE; i++)
+        {
+            float v = F.vs (j, i);
+            h = hash_bytes (h, &v, sizeof (float));
+        }
+    }
+    return h;
+}
+
+
+uint32_t Rankwave::cache_hash (Addsynth *D, float fsamp, float fbase, float *scale)
+{
+    uint32_t   h;
+    int32_t    v;
+
+    h = 2166136261u;
+    v = WAVE_VERSION;
+    h = hash_bytes (h, &v, sizeof (int32_t));
+    h = hash_bytes (h, &D->_n0, sizeof (int32_t));
+    h = hash_bytes (h, &D->_n1, sizeof (int32_t));
+    h = hash_bytes (h, &D->_fn, sizeof (int32_t));
+    h = hash_bytes (h, &D->_fd, sizeof (int32_t));
+    h = hash_func (h, D->_n_vol);
+    h = hash_func (h, D->_n_off);
+    h = hash_func (h, D->_n_ran);
+    h = hash_func (h, D->_n_ins);
+    h = hash_func (h, D->_n_att);
+    h = hash_func (h, D->_n_atd);
+    h = hash_func (h, D->_n_dct);
+    h = hash_func (h, D->_n_dcd);
+    h = hash_func (h, D->_h_lev);
+    h = hash_func (h, D->_h_ran);
+    h = hash_func (h, D->_h_att);
+    h = hash_func (h, D->_h_atp);
+    h = hash_bytes (h, &fsamp, sizeof (float));
+    h = hash_bytes (h, &fbase, sizeof (float));
+    h = hash_bytes (h, scale, 12 * sizeof (float));
+    return h;
+}
+
+
+void Rankwave::cache_name (char *name, const char *path, Addsynth *D, float fsamp, float fbase, float *scale)
+{
+    char  *p;
+
+    sprintf (name, "%s/%s", path, D->_filename);
+    if ((p = strrchr (name, '.'))) *p = 0;
+    sprintf (name + strlen (name), "-%08x.ae1", cache_hash (D, fsamp, fbase, scale));
+}
+
+
 int Rankwave::save (const char *path, Addsynth *D, float fsamp, float fbase, float *scale)
 {
     FILE      *F;
     Pipewave  *P;
     int        i;
     char       name [1024];
+    char       tmp [1040];
     char       data [64];
-    char      *p;
 
-    sprintf (name, "%s/%s", path, D->_filename);
-    if ((p = strrchr (name, '.'))) strcpy (p, ".ae1");
-    else strcat (name, ".ae1");
+    cache_name (name, path, D, fsamp, fbase, scale);
 
-    F = fopen (name, "wb");
+    // write to a temporary file first, so a rank generated
+    // concurrently never sees a partial file
+
+    sprintf (tmp, "%s.%p", name, (void *) this);
+    F = fopen (tmp, "wb");
     if (F == NULL)
     {
-	fprintf (stderr, "Can't open waveform file '%s' for writing\n", name);
+	fprintf (stderr, "Can't open waveform file '%s' for writing\n", tmp);
         return 1;
     }
 
     memset (data, 0, 16);
     strcpy (data, "ae1");
-    data [4] = 1;
+    data [4] = WAVE_VERSION;
     fwrite (data, 1, 16, F);
 
     memset (data, 0, 64);
@@ -488,7 +566,12 @@ int Rankwave::save (const char *path, Addsynth *D, float fsamp, float fbase, flo
 
     for (i = _n0, P = _pipes; i <= _n1; i++, P++) P->save (F);
 
-    fclose (F);
+    if (fclose (F) || rename (tmp, name))
+    {
+	fprintf (stderr, "Can't write waveform file '%s'\n", name);
+        remove (tmp);
+        return 1;
+    }
 
     _modif = false;
     return 0;
@@ -502,12 +585,9 @@ int Rankwave::load (const char *path, Addsynth *D, float fsamp, float fbase, flo
     int        i;
     char       name [1024];
     char       data [64];
-    char      *p;
     float      f;
 
-    sprintf (name, "%s/%s", path, D->_filename);
-    if ((p = strrchr (name, '.'))) strcpy (p, ".ae1");
-    else strcat (name, ".ae1");
+    cache_name (name, path, D, fsamp, fbase, scale);
 
     F = fopen (name, "rb");
     if (F == NULL)
@@ -528,7 +608,7 @@ int Rankwave::load (const char *path, Addsynth *D, float fsamp, float fbase, flo
         return 1;
     }
 
-    if (data [4] != 1)
+    if (data [4] != WAVE_VERSION)
     {
 #ifdef DEBUG
 	fprintf (stderr, "File '%s' has an incompatible version tag (%d)\n", name, data [4]);
@@ -26,6 +26,7 @@
 
 
 #define PERIOD 64
+#define WAVE_VERSION 2    // version of the waveform file format and generator
 
 
 class Pipewave
@@ -42,13 +43,13 @@ private:
 
     friend class Rankwave;
 
-    void genwave (Addsynth *D, int n, float fsamp, float fpipe);
+    void genwave (Addsynth *D, int n, float fsamp, float fpipe, Rngen& rgen, float *arg, float *att);
     void save (FILE *F);
     void load (FILE *F);
     void play (void);
 
     static void looplen (float f, float fsamp, int lmax, int *aa, int *bb);
-    static void attgain (int n, float p);
+    static void attgain (float *att, int n, float p);
 
     float     *_p0;    // attack start
     float     *_p1;    // loop start
@@ -74,11 +75,7 @@ private:
     int16_t    _i_r;   // release count
 
 
-    static void initstatic (float fsamp);
-
     static   Rngen   _rgen;
-    static   float  *_arg;
-    static   float  *_att;
 };
 
 
@@ -123,6 +120,7 @@ public:
     void gen_waves (Addsynth *D, float fsamp, float fbase, float *scale);
     int  save (const char *path, Addsynth *D, float fsamp, float fbase, float *scale);
     int  load (const char *path, Addsynth *D, float fsamp, float fbase, float *scale);
+    static void cache_name (char *name, const char *path, Addsynth *D, float fsamp, float fbase, float *scale);
     bool modif (void) const { return _modif; }
 
     int  _cmask;  // used by division logic
@@ -133,6 +131,8 @@ private:
     Rankwave (const Rankwave&);
     Rankwave& operator=(const Rankwave&);
 
+    static uint32_t cache_hash (Addsynth *D, float fsamp, float fbase, float *scale);
+
     int         _n0;
     int         _n1;
     uint32_t    _sbit;
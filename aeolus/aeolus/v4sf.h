@@ -0,0 +1,202 @@
+//=============================================================================
+//  MuseScore
+//  Music Composition & Notation
+//  $Id:$
+//
+//  Copyright (C) 2012 Werner Schweer and others
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//=============================================================================
+
+#ifndef __V4SF_H__
+#define __V4SF_H__
+
+//---------------------------------------------------------
+//   v4sf
+//    four floats processed at once; the compiler maps the
+//    operators to SSE or NEON instructions, or to scalar
+//    code if there is no vector unit
+//---------------------------------------------------------
+
+typedef float v4sf __attribute__ ((vector_size (16)));
+
+// loads and stores do not require 16 byte alignment
+
+static inline v4sf load4(const float* p)
+      {
+      v4sf v;
+      __builtin_memcpy(&v, p, sizeof(v));
+      return v;
+      }
+
+static inline void store4(float* p, v4sf v)
+      {
+      __builtin_memcpy(p, &v, sizeof(v));
+      }
+
+static inline v4sf splat4(float x)
+      {
+      v4sf v = { x, x, x, x };
+      return v;
+      }
+
+//---------------------------------------------------------
+//   ramp4
+//    x, x + d, x + 2d, x + 3d
+//---------------------------------------------------------
+
+static inline v4sf ramp4(float x, float d)
+      {
+      v4sf v = { x, x + d, x + 2.0f * d, x + 3.0f * d };
+      return v;
+      }
+
+//---------------------------------------------------------
+//   kernels of Pipewave::play(), Division::process() and
+//   Asection::process(); mtest/aeolus/rankwave compares
+//   them with the scalar loops they replace. Ramps are
+//   computed as start + i * step, so results differ from
+//   the scalar loops only by rounding.
+//---------------------------------------------------------
+
+//---------------------------------------------------------
+//   add_ramp
+//    add n samples from r to q, scaled by a gain that
+//    starts at g and falls by dg per sample; returns the
+//    gain for the next sample
+//---------------------------------------------------------
+
+static inline float add_ramp(float* q, const float* r, int n, float g, float dg)
+      {
+      const int nv = n & ~3;
+      v4sf G       = ramp4(g, -dg);
+      const v4sf D = splat4(-4.0f * dg);
+      for (int i = 0; i < nv; i += 4) {
+            store4(q + i, load4(q + i) + G * load4(r + i));
+            G += D;
+            }
+      g -= nv * dg;
+      for (int i = nv; i < n; ++i) {
+            q[i] += g * r[i];
+            g -= dg;
+            }
+      return g;
+      }
+
+//---------------------------------------------------------
+//   add_interp
+//    add n interpolated samples, taking every s-th sample
+//    of the wavetable at r; the interpolation position y
+//    (rising by dy) and the gain g (falling by dg) are
+//    updated; returns the read pointer for the next sample
+//---------------------------------------------------------
+
+static inline float* add_interp(float* q, float* r, int n, int s,
+   float& y, float dy, float& g, float dg)
+      {
+      const int nv  = n & ~3;
+      v4sf Y        = ramp4(y, dy);
+      v4sf G        = ramp4(g, -dg);
+      const v4sf DY = splat4(4.0f * dy);
+      const v4sf DG = splat4(-4.0f * dg);
+      for (int i = 0; i < nv; i += 4) {
+            v4sf A, B;
+            if (s == 1) {
+                  A = load4(r);
+                  B = load4(r + 1);
+                  }
+            else {
+                  v4sf a = { r[0], r[s], r[2 * s], r[3 * s] };
+                  v4sf b = { r[1], r[s + 1], r[2 * s + 1], r[3 * s + 1] };
+                  A = a;
+                  B = b;
+                  }
+            store4(q + i, load4(q + i) + G * (A + Y * (B - A)));
+            Y += DY;
+            G += DG;
+            r += 4 * s;
+            }
+      y += nv * dy;
+      g -= nv * dg;
+      for (int i = nv; i < n; ++i) {
+            q[i] += g * (r[0] + y * (r[1] - r[0]));
+            g -= dg;
+            y += dy;
+            r += s;
+            }
+      return r;
+      }
+
+//---------------------------------------------------------
+//   add4
+//    add n samples from p to q; n is a multiple of 4
+//---------------------------------------------------------
+
+static inline void add4(float* q, const float* p, int n)
+      {
+      for (int i = 0; i < n; i += 4)
+            store4(q + i, load4(q + i) + load4(p + i));
+      }
+
+//---------------------------------------------------------
+//   matrix4
+//    mix the four channels p[0], p[stride], p[2 * stride]
+//    and p[3 * stride] into the reverb send R and the
+//    W, x, y components of the section; n is a multiple
+//    of 4
+//---------------------------------------------------------
+
+static inline void matrix4(const float* p, int stride, int n,
+   float gr, float gw, float gx1, float gx2, float gy1, float gy2,
+   float* R, float* W, float* x, float* y)
+      {
+      const v4sf vgr  = splat4(gr);
+      const v4sf vgw  = splat4(gw);
+      const v4sf vgx1 = splat4(gx1);
+      const v4sf vgx2 = splat4(gx2);
+      const v4sf vgy1 = splat4(gy1);
+      const v4sf vgy2 = splat4(gy2);
+      for (int i = 0; i < n; i += 4) {
+            v4sf t0 = load4(p + 0 * stride + i);
+            v4sf t1 = load4(p + 1 * stride + i);
+            v4sf t2 = load4(p + 2 * stride + i);
+            v4sf t3 = load4(p + 3 * stride + i);
+            v4sf s  = t0 + t1 + t2 + t3;
+            store4(R + i, load4(R + i) + vgr * s);
+            store4(W + i, load4(W + i) + vgw * s);
+            store4(x + i, vgx1 * (t3 + t0) + vgx2 * (t2 + t1));
+            store4(y + i, vgy1 * (t3 - t0) + vgy2 * (t2 - t1));
+            }
+      }
+
+//---------------------------------------------------------
+//   rotate4
+//    add x and y, rotated by the angle with cosine c and
+//    sine s, to X and Y; n is a multiple of 4
+//---------------------------------------------------------
+
+static inline void rotate4(float* X, float* Y, const float* x, const float* y,
+   int n, float c, float s)
+      {
+      const v4sf vc = splat4(c);
+      const v4sf vs = splat4(s);
+      for (int i = 0; i < n; i += 4) {
+            v4sf vx = load4(x + i);
+            v4sf vy = load4(y + i);
+            store4(X + i, load4(X + i) + (vc * vx + vs * vy));
+            store4(Y + i, load4(Y + i) + (vc * vy - vs * vx));
+            }
+      }
+
+#endif
+
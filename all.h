@@ -116,6 +116,7 @@
 #include <QtWidgets/QCheckBox>
 #include <QtWidgets/QDialogButtonBox>
 #include <QtWidgets/QProgressBar>
+#include <QtWidgets/QProgressDialog>
 #include <QtWidgets/QRadioButton>
 #include <QtWidgets/QSplashScreen>
 #include <QtWidgets/QFontComboBox>
@@ -183,6 +184,7 @@
 #include <QtGui/QCheckBox>
 #include <QtGui/QDialogButtonBox>
 #include <QtGui/QProgressBar>
+#include <QtGui/QProgressDialog>
 #include <QtGui/QRadioButton>
 #include <QtGui/QSplashScreen>
 #include <QtGui/QFontComboBox>
@@ -223,6 +225,8 @@
 #include <QtNetwork/QNetworkCookie>
 #include <QtConcurrent/QFuture>
 #include <QtConcurrent/QFutureWatcher>
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtConcurrent/QtConcurrentRun>
 #include <QtQuick1/QDeclarativeEngine>
 #include <QtQuick1/QDeclarativeComponent>
 #include <QtQuick1/QDeclarativeItem>
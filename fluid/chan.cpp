@@ -123,11 +123,11 @@ void Channel::setcc(int num, int value)
                   break;
 
             case ALL_NOTES_OFF:
-                  synth->allNotesOff(channum);
+                  synth->notesOff(channum);
                   break;
 
             case ALL_SOUND_OFF:
-                  synth->allSoundsOff(channum);
+                  synth->soundsOff(channum);
                   break;
 
             case ALL_CTRL_OFF:
@@ -221,7 +221,7 @@ void Channel::setPreset(Preset* p)
       {
       if (_preset != p) {
             if (p)
-                  p->loadSamples();
+                  synth->loadPreset(p);
             _preset = p;
             }
       }
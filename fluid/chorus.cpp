@@ -89,6 +89,12 @@ namespace FluidS {
 
 #define fluid_log(a, ...)
 
+static const int CHORUS_BLOCK = 64;       // max samples per processing block
+
+#if INTERPOLATION_SAMPLES != 5
+#error "the sinc taps in Chorus::process() are unrolled for 5 samples"
+#endif
+
 //---------------------------------------------------------
 //   Chorus
 //---------------------------------------------------------
@@ -110,17 +116,17 @@ Chorus::Chorus(float sr)
                   if (fabs(i_shifted) < 0.000001) {
                         /* sinc(0) cannot be calculated straightforward (limit needed
                            for 0/0) */
-                        sinc_table[i][ii] = (float)1.;
+                        sinc_table[ii][i] = (float)1.;
                         }
                   else {
-                        sinc_table[i][ii] = (float)sin(i_shifted * M_PI) / (M_PI * i_shifted);
+                        sinc_table[ii][i] = (float)sin(i_shifted * M_PI) / (M_PI * i_shifted);
                         /* Hamming window */
-                        sinc_table[i][ii] *= (float)0.5 * (1.0 + cos(2.0 * M_PI * i_shifted / (float)INTERPOLATION_SAMPLES));
+                        sinc_table[ii][i] *= (float)0.5 * (1.0 + cos(2.0 * M_PI * i_shifted / (float)INTERPOLATION_SAMPLES));
                         }
                   }
             }
       lookup_tab = new int[(int) (sample_rate / MIN_SPEED_HZ)];
-      chorusbuf  = new float[MAX_SAMPLES];
+      chorusbuf  = new float[MAX_SAMPLES + INTERPOLATION_SAMPLES];
       reset();
       }
 
@@ -130,7 +136,7 @@ Chorus::Chorus(float sr)
 
 void Chorus::reset()
       {
-      memset(chorusbuf, 0, MAX_SAMPLES * sizeof(*chorusbuf));
+      memset(chorusbuf, 0, (MAX_SAMPLES + INTERPOLATION_SAMPLES) * sizeof(*chorusbuf));
       number_blocks = 0;
       number_blocks = FLUID_CHORUS_DEFAULT_N;
       level         = FLUID_CHORUS_DEFAULT_LEVEL;
@@ -138,6 +144,11 @@ void Chorus::reset()
       depth_ms      = FLUID_CHORUS_DEFAULT_DEPTH;
       type          = FLUID_CHORUS_MOD_SINE;
 
+      newType          = type;
+      newDepth_ms      = depth_ms;
+      newSpeed_Hz      = speed_Hz;
+      newNumberBlocks  = number_blocks;
+      parameterChanged = false;
       update();
       }
 
@@ -188,65 +199,101 @@ void Chorus::update()
                * (double) i / (double) number_blocks);
             }
 
+      /* A block of input is written to the circular buffer before the
+       * delay lines are read; it must not reach the oldest sample still
+       * needed by the interpolation (depth plus the sinc taps).
+       */
+      blockSize = qMax(1, qMin(CHORUS_BLOCK,
+         MAX_SAMPLES - modulation_depth_samples - INTERPOLATION_SAMPLES - 1));
+
       /* Start of the circular buffer */
       counter = 0;
       }
 
 //---------------------------------------------------------
 //   process
+//    Works in blocks of up to blockSize samples: the input
+//    block is written to the circular buffer first, then every
+//    chorus block runs its modulated delay line over all
+//    samples of the block. The contributions are summed per
+//    sample in the same order as a sample by sample loop would,
+//    so the result does not depend on the block size.
 //---------------------------------------------------------
 
 void Chorus::process(int n, float* in, float* left_out, float* right_out)
       {
-      for (int sample_index = 0; sample_index < n; sample_index++) {
-            float d_in = in[sample_index];
-            float d_out = 0.0f;
-
-            /* Write the current sample into the circular buffer */
-            chorusbuf[counter] = d_in;
-
-            for (int i = 0; i < number_blocks; i++) {
-                  /* Calculate the delay in subsamples for the delay line of chorus block nr. */
-
-                  /* The value in the lookup table is so, that this expression
-                   * will always be positive.  It will always include a number of
-                   * full periods of MAX_SAMPLES*INTERPOLATION_SUBSAMPLES to
-                   * remain positive at all times.
-                   */
-                  int pos_subsamples = (INTERPOLATION_SUBSAMPLES * counter
-                     - lookup_tab[phase[i]]);
-
-                  int pos_samples = pos_subsamples/INTERPOLATION_SUBSAMPLES;
-
-                  /* modulo divide by INTERPOLATION_SUBSAMPLES */
-                  pos_subsamples &= INTERPOLATION_SUBSAMPLES_ANDMASK;
+      if (parameterChanged) {
+            type          = newType;
+            depth_ms      = newDepth_ms;
+            speed_Hz      = newSpeed_Hz;
+            number_blocks = newNumberBlocks;
+            update();
+            parameterChanged = false;
+            }
+      float out[CHORUS_BLOCK];
+      const int nb      = number_blocks;
+      const long period = modulation_period_samples;
+
+      for (int start = 0; start < n; start += blockSize) {
+            const int len = qMin(blockSize, n - start);
+
+            /* Write the current samples into the circular buffer; the
+             * first INTERPOLATION_SAMPLES entries are mirrored behind its
+             * end so that the taps of a delay line are always contiguous.
+             */
+            for (int k = 0; k < len; ++k) {
+                  int idx = (counter + k) & MAX_SAMPLES_ANDMASK;
+                  chorusbuf[idx] = in[start + k];
+                  if (idx < INTERPOLATION_SAMPLES)
+                        chorusbuf[idx + MAX_SAMPLES] = in[start + k];
+                  out[k] = 0.0f;
+                  }
 
-                  for (int ii = 0; ii < INTERPOLATION_SAMPLES; ii++) {
-	                  /* Add the delayed signal to the chorus sum d_out Note: The
-	                   * delay in the delay line moves backwards for increasing
-	                   * delay!*/
+            for (int i = 0; i < nb; i++) {
+                  long ph = phase[i];
+                  for (int k = 0; k < len; ++k) {
+                        /* Calculate the delay in subsamples for the delay line of chorus block nr. */
 
-	                  /* The & in chorusbuf[...] is equivalent to a division modulo
-	                     MAX_SAMPLES, only faster.
+                        /* The value in the lookup table is so, that this expression
+                         * will always be positive.  It will always include a number of
+                         * full periods of MAX_SAMPLES*INTERPOLATION_SUBSAMPLES to
+                         * remain positive at all times.
+                         */
+                        int pos_subsamples = INTERPOLATION_SUBSAMPLES * ((counter + k) & MAX_SAMPLES_ANDMASK)
+                           - lookup_tab[ph];
+                        int pos_samples    = pos_subsamples / INTERPOLATION_SUBSAMPLES;
+                        const float* sinc  = sinc_table[pos_subsamples & INTERPOLATION_SUBSAMPLES_ANDMASK];
+                        const float* buf   = chorusbuf + ((pos_samples - (INTERPOLATION_SAMPLES - 1))
+                           & MAX_SAMPLES_ANDMASK) + INTERPOLATION_SAMPLES - 1;
+
+                        /* Add the delayed signal to the chorus sum. Note: The
+                         * delay in the delay line moves backwards for increasing
+                         * delay!
                          */
-                        d_out += (chorusbuf[pos_samples & MAX_SAMPLES_ANDMASK]
-                           * sinc_table[ii][pos_subsamples]);
-                        pos_samples--;
+                        float d_out = out[k];
+                        d_out += buf[0] * sinc[0];
+                        d_out += buf[-1] * sinc[1];
+                        d_out += buf[-2] * sinc[2];
+                        d_out += buf[-3] * sinc[3];
+                        d_out += buf[-4] * sinc[4];
+                        out[k] = d_out;
+
+                        /* Cycle the phase of the modulating LFO */
+                        if (++ph >= period)
+                              ph = 0;
                         }
-                  /* Cycle the phase of the modulating LFO */
-                  phase[i]++;
-                  phase[i] %= (modulation_period_samples);
+                  phase[i] = ph;
                   } /* foreach chorus block */
 
-            d_out *= level;
-
-            /* Add the chorus sum d_out to output */
-            left_out[sample_index]  += d_out;
-            right_out[sample_index] += d_out;
+            /* Add the chorus sum to output */
+            for (int k = 0; k < len; ++k) {
+                  float d_out = out[k] * level;
+                  left_out[start + k]  += d_out;
+                  right_out[start + k] += d_out;
+                  }
 
             /* Move forward in circular buffer */
-            counter++;
-            counter %= MAX_SAMPLES;
+            counter = (counter + len) & MAX_SAMPLES_ANDMASK;
             }
       }
 
@@ -304,6 +351,8 @@ static const char* pNames[] = {
 
 //---------------------------------------------------------
 //   setParameter
+//    the new values are applied by the next process()
+//    call in the audio thread
 //---------------------------------------------------------
 
 void Chorus::setParameter(int idx, float value)
@@ -311,25 +360,25 @@ void Chorus::setParameter(int idx, float value)
 // printf("Chorus: setParameter %s(%d) %f\n", pNames[idx], idx, value);
       switch (idx) {
             case CHORUS_TYPE:
-                  type = lrint(value);
+                  newType = lrint(value);
                   break;
             case CHORUS_SPEED:
-                  speed_Hz = value * MAX_SPEED_HZ + MIN_SPEED_HZ;
+                  newSpeed_Hz = value * MAX_SPEED_HZ + MIN_SPEED_HZ;
                   break;
             case CHORUS_DEPTH:
-                  depth_ms = value * MAX_DEPTH;
+                  newDepth_ms = value * MAX_DEPTH;
                   break;
             case CHORUS_BLOCKS:
-                  number_blocks = lrint(value * 100.0);
+                  newNumberBlocks = lrint(value * 100.0);
                   break;
             case CHORUS_GAIN:
                   level = value;
-                  return;     // do not call update
+                  return;     // does not need an update
             default:
                   printf("Chorus:setParameter: %x invalid\n", idx);
-                  break;
+                  return;
             }
-      update();
+      parameterChanged = true;
       }
 
 //---------------------------------------------------------
@@ -340,10 +389,10 @@ double Chorus::parameter(int idx) const
       {
       float value = 0.0;
       switch (idx) {
-            case CHORUS_TYPE:   value = type; break;
-            case CHORUS_SPEED:  value = (speed_Hz-MIN_SPEED_HZ) / MAX_SPEED_HZ; break;
-            case CHORUS_DEPTH:  value = depth_ms / MAX_DEPTH; break;
-            case CHORUS_BLOCKS: value = number_blocks / 100.0; break;
+            case CHORUS_TYPE:   value = newType; break;
+            case CHORUS_SPEED:  value = (newSpeed_Hz-MIN_SPEED_HZ) / MAX_SPEED_HZ; break;
+            case CHORUS_DEPTH:  value = newDepth_ms / MAX_DEPTH; break;
+            case CHORUS_BLOCKS: value = newNumberBlocks / 100.0; break;
             case CHORUS_GAIN:   value = level; break;
             default:
                   printf("Chorus::parameter: 0x%x invalid\n", idx);
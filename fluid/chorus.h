@@ -65,15 +65,23 @@ class Chorus {
       float speed_Hz;
       int number_blocks;
 
+      int newType;            // set by setParameter(), applied by process()
+      float newDepth_ms;
+      float newSpeed_Hz;
+      int newNumberBlocks;
+      bool parameterChanged;
+
       float* chorusbuf;
       int counter;
       long phase[MAX_CHORUS];
       long modulation_period_samples;
       int* lookup_tab;
       float sample_rate;
+      int blockSize;          // max samples written to chorusbuf ahead of the readers
 
-      /* sinc lookup table */
-      float sinc_table[INTERPOLATION_SAMPLES][INTERPOLATION_SUBSAMPLES];
+      /* sinc lookup table, [subsample][tap] so that the taps
+         of one output sample are contiguous */
+      float sinc_table[INTERPOLATION_SUBSAMPLES][INTERPOLATION_SAMPLES];
 
    public:
       Chorus(float sample_rate);
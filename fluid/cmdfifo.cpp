@@ -0,0 +1,81 @@
+/* FluidSynth - A Software Synthesizer
+ *
+ * Copyright (C) 2003  Peter Hanappe and others.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public License
+ * as published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ * 02111-1307, USA
+ */
+
+
+#include "cmdfifo.h"
+
+namespace FluidS {
+
+//---------------------------------------------------------
+//   CommandFifo
+//---------------------------------------------------------
+
+CommandFifo::CommandFifo()
+      {
+      for (int i = 0; i < CMD_FIFO_SIZE; ++i)
+            slots[i].sequence.fetchAndStoreRelaxed(i);
+      widx.fetchAndStoreOrdered(0);
+      ridx = 0;
+      }
+
+//---------------------------------------------------------
+//   enqueue
+//    positions are compared as differences so that the
+//    counters may wrap around
+//---------------------------------------------------------
+
+bool CommandFifo::enqueue(const FluidCommand& cmd)
+      {
+      int pos = widx.fetchAndAddRelaxed(0);
+      Slot* s;
+      for (;;) {
+            s       = &slots[pos & (CMD_FIFO_SIZE - 1)];
+            int seq = s->sequence.fetchAndAddAcquire(0);
+            int dif = int(unsigned(seq) - unsigned(pos));
+            if (dif == 0) {
+                  if (widx.testAndSetRelaxed(pos, int(unsigned(pos) + 1)))
+                        break;
+                  pos = widx.fetchAndAddRelaxed(0);
+                  }
+            else if (dif < 0)
+                  return false;           // the slot of the last round is not read yet
+            else
+                  pos = widx.fetchAndAddRelaxed(0);
+            }
+      s->cmd = cmd;
+      s->sequence.fetchAndStoreRelease(int(unsigned(pos) + 1));
+      return true;
+      }
+
+//---------------------------------------------------------
+//   dequeue
+//---------------------------------------------------------
+
+bool CommandFifo::dequeue(FluidCommand* cmd)
+      {
+      Slot* s = &slots[ridx & (CMD_FIFO_SIZE - 1)];
+      if (s->sequence.fetchAndAddAcquire(0) != int(unsigned(ridx) + 1))
+            return false;
+      *cmd = s->cmd;
+      s->sequence.fetchAndStoreRelease(int(unsigned(ridx) + CMD_FIFO_SIZE));
+      ridx = int(unsigned(ridx) + 1);
+      return true;
+      }
+}
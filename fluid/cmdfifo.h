@@ -0,0 +1,95 @@
+/* FluidSynth - A Software Synthesizer
+ *
+ * Copyright (C) 2003  Peter Hanappe and others.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public License
+ * as published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ * 02111-1307, USA
+ */
+
+
+#ifndef _FLUID_CMDFIFO_H
+#define _FLUID_CMDFIFO_H
+
+#include "libmscore/event.h"
+
+namespace FluidS {
+
+class Voice;
+class Preset;
+
+enum FluidCommandType {
+      CMD_EVENT,              // play event
+      CMD_NOTES_OFF,          // allNotesOff(chan)
+      CMD_SOUNDS_OFF,         // allSoundsOff(chan)
+      CMD_POLYPHONY,          // add voices[0..count-1] to the pool, set the limit to value
+      CMD_LOAD_PRESET,        // sample loader: load the samples of preset
+      CMD_SYNC                // sample loader: all requests before this one are done
+      };
+
+//---------------------------------------------------------
+//   FluidCommand
+//    message to the audio thread; POD, nothing in it is
+//    owned by the fifo
+//---------------------------------------------------------
+
+struct FluidCommand {
+      int type;
+      int chan;
+      int value;
+      int count;
+      ChannelEvent event;
+      Voice** voices;
+      Preset* preset;
+
+      FluidCommand(int t = CMD_EVENT)
+         : type(t), chan(0), value(0), count(0), voices(0), preset(0) {}
+      };
+
+static const int CMD_FIFO_SIZE = 4096;    // must be a power of two
+
+//---------------------------------------------------------
+//   CommandFifo
+//    lock free multiple producer/single consumer queue
+//    - every slot has a sequence counter; a slot with
+//      sequence == pos is free for the writer which
+//      reserves position pos, a slot with sequence
+//      == pos + 1 holds the object for the reader at pos
+//    - writers reserve a position by advancing widx with
+//      test-and-set, write the object and publish it by
+//      storing the sequence (release)
+//    - the reader checks the sequence (acquire), copies
+//      the object and frees the slot for the next round
+//      by storing pos + CMD_FIFO_SIZE (release)
+//    - enqueue() never blocks, it returns false if the
+//      fifo is full
+//---------------------------------------------------------
+
+class CommandFifo {
+      struct Slot {
+            QAtomicInt sequence;
+            FluidCommand cmd;
+            };
+      Slot slots[CMD_FIFO_SIZE];
+      QAtomicInt widx;        // next position to write
+      int ridx;               // next position to read; reader only
+
+   public:
+      CommandFifo();
+      bool enqueue(const FluidCommand&);    // any thread
+      bool dequeue(FluidCommand*);          // reader only; false if empty
+      };
+
+}
+#endif
@@ -60,6 +60,74 @@ float Voice::sinc_table7[FLUID_INTERP_MAX][7];
 
 #define SINC_INTERP_ORDER 7	/* 7th order constant */
 
+/* without vector kernels the per sample loops do all the work */
+static const DspKernels scalarKernels = {
+      DSP_SCALAR, "scalar", 0, 0, 0, 0
+      };
+
+const DspKernels* Voice::dspKernels = &scalarKernels;
+
+//---------------------------------------------------------
+//   cpuSupports
+//---------------------------------------------------------
+
+static bool cpuSupports(DspKernelType type)
+      {
+#if (defined(__x86_64__) || defined(__i386__)) \
+   && (defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+      __builtin_cpu_init();
+      switch (type) {
+            case DSP_SCALAR: return true;
+            case DSP_SSE2:   return __builtin_cpu_supports("sse2");
+            case DSP_AVX2:   return __builtin_cpu_supports("avx2");
+            }
+      return false;
+#else
+      return type == DSP_SCALAR;
+#endif
+      }
+
+//---------------------------------------------------------
+//   setDspKernels
+//    select the implementation of the interpolation loops;
+//    returns false if it is not available on this cpu
+//---------------------------------------------------------
+
+bool Voice::setDspKernels(DspKernelType type)
+      {
+      if (!cpuSupports(type))
+            return false;
+      const DspKernels* k = 0;
+      switch (type) {
+            case DSP_SCALAR: k = &scalarKernels;    break;
+            case DSP_SSE2:   k = dspKernelsSse2(); break;
+            case DSP_AVX2:   k = dspKernelsAvx2(); break;
+            }
+      if (!k)
+            return false;
+      dspKernels = k;
+      return true;
+      }
+
+//---------------------------------------------------------
+//   runKernel
+//    let the vector kernel render as much of the current
+//    loop section as possible; returns the new output index
+//---------------------------------------------------------
+
+static inline unsigned runKernel(DspKernel kernel, float* buf, const short* data,
+   const float* coeffs, Phase& phase, const Phase& incr, float& amp, float ampIncr,
+   unsigned endIndex, unsigned i, unsigned n)
+      {
+      if (!kernel || i >= n || incr.data < 0)
+            return i;
+      DspBlock b = { buf, data, coeffs, phase.data, incr.data, amp, ampIncr, endIndex };
+      i          = kernel(&b, i, n);
+      phase.data = b.phase;
+      amp        = b.amp;
+      return i;
+      }
+
 //---------------------------------------------------------
 //   dsp_float_config
 //    Initializes interpolation tables
@@ -105,6 +173,9 @@ void Voice::dsp_float_config()
                   }
             }
       fluid_check_fpe("interpolation table calculation");
+
+      if (!setDspKernels(DSP_AVX2) && !setDspKernels(DSP_SSE2))
+            setDspKernels(DSP_SCALAR);
       }
 
 //-------------------------------------------------------------------
@@ -140,6 +211,8 @@ int Voice::dsp_float_interpolate_none(unsigned n)
       end_index = looping ? voice->loopend - 1 : voice->end;
 
       while(1) {
+            dsp_i = runKernel(dspKernels->none, dsp_buf, dsp_data, 0, dsp_phase,
+               dsp_phase_incr, dsp_amp, dsp_amp_incr, end_index, dsp_i, n);
             dsp_phase_index = dsp_phase.index_round();      // round to nearest point
 
             /* interpolate sequence of sample points */
@@ -213,6 +286,8 @@ int Voice::dsp_float_interpolate_linear(unsigned n)
             point = dsp_data[voice->end];             /* duplicate end for samples no longer looping */
 
       while (1) {
+            dsp_i = runKernel(dspKernels->linear, dsp_buf, dsp_data, &interp_coeff_linear[0][0],
+               dsp_phase, dsp_phase_incr, dsp_amp, dsp_amp_incr, end_index, dsp_i, n);
             dsp_phase_index = dsp_phase.index();
 
             /* interpolate the sequence of sample points */
@@ -330,6 +405,10 @@ int Voice::dsp_float_interpolate_4th_order(unsigned n)
                   amp += dsp_amp_incr;
                   }
 
+            dsp_i = runKernel(dspKernels->order4, dsp_buf, dsp_data, &interp_coeff[0][0],
+               phase, dsp_phase_incr, amp, dsp_amp_incr, end_index, dsp_i, n);
+            dsp_phase_index = phase.index();
+
             /* interpolate the sequence of sample points */
             for ( ; dsp_i < n && dsp_phase_index <= end_index; dsp_i++) {
                   coeffs = interp_coeff[fluid_phase_fract_to_tablerow (phase)];
@@ -528,6 +607,10 @@ int Voice::dsp_float_interpolate_7th_order(unsigned n)
 
             start_index -= 2;	/* set back to original start index */
 
+            dsp_i = runKernel(dspKernels->order7, dsp_buf, dsp_data, &sinc_table7[0][0],
+               dsp_phase, dsp_phase_incr, dsp_amp, dsp_amp_incr, end_index, dsp_i, n);
+            dsp_phase_index = dsp_phase.index();
+
             /* interpolate the sequence of sample points */
             for ( ; dsp_i < n && dsp_phase_index <= end_index; dsp_i++) {
                   coeffs = sinc_table7[fluid_phase_fract_to_tablerow (dsp_phase)];
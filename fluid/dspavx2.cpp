@@ -0,0 +1,282 @@
+/* FluidSynth - A Software Synthesizer
+ *
+ * Copyright (C) 2003  Peter Hanappe and others.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public License
+ * as published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ * 02111-1307, USA
+ */
+
+//
+//  AVX2 versions of the interpolation loops in dsp.cpp; eight
+//  output samples per iteration. Sample points and coefficients
+//  are fetched with gather instructions, two 16 bit points per
+//  32 bit lane. Only the kernels are compiled for the avx2 target
+//  (instead of the whole file with -mavx2) so that no inline function
+//  of a shared header ends up with avx2 code; they are only used if
+//  the cpu supports them.
+//
+
+#include "dspsimd.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#if defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)
+#define FLUID_AVX2
+#endif
+#endif
+
+#ifdef FLUID_AVX2
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#include <immintrin.h>
+
+namespace FluidS {
+
+//---------------------------------------------------------
+//   ampRamp
+//    amplitude of eight consecutive samples, accumulated
+//    the same way as "dsp_amp += dsp_amp_incr"
+//---------------------------------------------------------
+
+static inline __m256 ampRamp(float* amp, float incr)
+      {
+      float a0 = *amp;
+      float a1 = a0 + incr;
+      float a2 = a1 + incr;
+      float a3 = a2 + incr;
+      float a4 = a3 + incr;
+      float a5 = a4 + incr;
+      float a6 = a5 + incr;
+      float a7 = a6 + incr;
+      *amp = a7 + incr;
+      return _mm256_setr_ps(a0, a1, a2, a3, a4, a5, a6, a7);
+      }
+
+//---------------------------------------------------------
+//   phaseLanes
+//    split the phase of eight consecutive samples into
+//    sample index and interpolation table row
+//---------------------------------------------------------
+
+static inline void phaseLanes(qint64 phase, qint64 incr, __m256i* index, __m256i* row)
+      {
+      const __m256i perm = _mm256_setr_epi32(1, 3, 5, 7, 0, 2, 4, 6);
+      __m256i pa = _mm256_add_epi64(_mm256_set1_epi64x(phase),
+         _mm256_setr_epi64x(0, incr, 2 * incr, 3 * incr));
+      __m256i pb = _mm256_add_epi64(pa, _mm256_set1_epi64x(4 * incr));
+      __m256i qa = _mm256_permutevar8x32_epi32(pa, perm);     // index 0-3 | fract 0-3
+      __m256i qb = _mm256_permutevar8x32_epi32(pb, perm);     // index 4-7 | fract 4-7
+      *index = _mm256_permute2x128_si256(qa, qb, 0x20);
+      *row   = _mm256_srli_epi32(_mm256_permute2x128_si256(qa, qb, 0x31), 24);
+      }
+
+//---------------------------------------------------------
+//   lo16 / hi16
+//    sign extend the lower/upper 16 bit of every 32 bit lane
+//    and convert to float
+//---------------------------------------------------------
+
+static inline __m256 lo16(__m256i v)
+      {
+      return _mm256_cvtepi32_ps(_mm256_srai_epi32(_mm256_slli_epi32(v, 16), 16));
+      }
+
+static inline __m256 hi16(__m256i v)
+      {
+      return _mm256_cvtepi32_ps(_mm256_srai_epi32(v, 16));
+      }
+
+//---------------------------------------------------------
+//   points
+//    gather data[index+offset] and data[index+offset+1]
+//---------------------------------------------------------
+
+static inline __m256i points(const short* data, __m256i index, int offset)
+      {
+      return _mm256_i32gather_epi32((const int*)data,
+         _mm256_add_epi32(index, _mm256_set1_epi32(offset)), 2);
+      }
+
+static inline __m256 coeff(const float* table, __m256i row, int k)
+      {
+      return _mm256_i32gather_ps(table, _mm256_add_epi32(row, _mm256_set1_epi32(k)), 4);
+      }
+
+static inline __m256 madd(__m256 v, __m256 c, __m256 s)
+      {
+      return _mm256_add_ps(v, _mm256_mul_ps(c, s));
+      }
+
+//---------------------------------------------------------
+//   interpolateNone
+//    the gather reads one point beyond the rounded index,
+//    so the last lane has to stay below endIndex
+//---------------------------------------------------------
+
+static unsigned interpolateNone(DspBlock* b, unsigned i, unsigned n)
+      {
+      const short* data       = b->data;
+      float* buf              = b->buf;
+      const qint64 incr       = b->phaseIncr;
+      const float ampIncr     = b->ampIncr;
+      const unsigned endIndex = b->endIndex;
+      qint64 phase            = b->phase;
+      float amp               = b->amp;
+
+      while (i + 8 <= n && quint32((phase + 7 * incr + 0x80000000LL) >> 32) < endIndex) {
+            __m256i index, row;
+            phaseLanes(phase + 0x80000000LL, incr, &index, &row);
+            __m256 a = ampRamp(&amp, ampIncr);
+            _mm256_storeu_ps(buf + i, _mm256_mul_ps(a, lo16(points(data, index, 0))));
+            phase += 8 * incr;
+            i     += 8;
+            }
+      b->phase = phase;
+      b->amp   = amp;
+      return i;
+      }
+
+//---------------------------------------------------------
+//   interpolateLinear
+//---------------------------------------------------------
+
+static unsigned interpolateLinear(DspBlock* b, unsigned i, unsigned n)
+      {
+      const short* data       = b->data;
+      const float* table      = b->coeffs;
+      float* buf              = b->buf;
+      const qint64 incr       = b->phaseIncr;
+      const float ampIncr     = b->ampIncr;
+      const unsigned endIndex = b->endIndex;
+      qint64 phase            = b->phase;
+      float amp               = b->amp;
+
+      while (i + 8 <= n && quint32((phase + 7 * incr) >> 32) <= endIndex) {
+            __m256i index, row;
+            phaseLanes(phase, incr, &index, &row);
+            row = _mm256_slli_epi32(row, 1);
+            __m256i p = points(data, index, 0);
+
+            __m256 v = _mm256_mul_ps(coeff(table, row, 0), lo16(p));
+            v = madd(v, coeff(table, row, 1), hi16(p));
+            __m256 a = ampRamp(&amp, ampIncr);
+            _mm256_storeu_ps(buf + i, _mm256_mul_ps(a, v));
+            phase += 8 * incr;
+            i     += 8;
+            }
+      b->phase = phase;
+      b->amp   = amp;
+      return i;
+      }
+
+//---------------------------------------------------------
+//   interpolate4
+//---------------------------------------------------------
+
+static unsigned interpolate4(DspBlock* b, unsigned i, unsigned n)
+      {
+      const short* data       = b->data;
+      const float* table      = b->coeffs;
+      float* buf              = b->buf;
+      const qint64 incr       = b->phaseIncr;
+      const float ampIncr     = b->ampIncr;
+      const unsigned endIndex = b->endIndex;
+      qint64 phase            = b->phase;
+      float amp               = b->amp;
+
+      while (i + 8 <= n && quint32((phase + 7 * incr) >> 32) <= endIndex) {
+            __m256i index, row;
+            phaseLanes(phase, incr, &index, &row);
+            row = _mm256_slli_epi32(row, 2);
+            __m256i p0 = points(data, index, -1);     // index-1, index
+            __m256i p1 = points(data, index, 1);      // index+1, index+2
+
+            __m256 v = _mm256_mul_ps(coeff(table, row, 0), lo16(p0));
+            v = madd(v, coeff(table, row, 1), hi16(p0));
+            v = madd(v, coeff(table, row, 2), lo16(p1));
+            v = madd(v, coeff(table, row, 3), hi16(p1));
+            __m256 a = ampRamp(&amp, ampIncr);
+            _mm256_storeu_ps(buf + i, _mm256_mul_ps(a, v));
+            phase += 8 * incr;
+            i     += 8;
+            }
+      b->phase = phase;
+      b->amp   = amp;
+      return i;
+      }
+
+//---------------------------------------------------------
+//   interpolate7
+//---------------------------------------------------------
+
+static unsigned interpolate7(DspBlock* b, unsigned i, unsigned n)
+      {
+      const short* data       = b->data;
+      const float* table      = b->coeffs;
+      float* buf              = b->buf;
+      const qint64 incr       = b->phaseIncr;
+      const float ampIncr     = b->ampIncr;
+      const unsigned endIndex = b->endIndex;
+      qint64 phase            = b->phase;
+      float amp               = b->amp;
+
+      while (i + 8 <= n && quint32((phase + 7 * incr) >> 32) <= endIndex) {
+            __m256i index, row;
+            phaseLanes(phase, incr, &index, &row);
+            row = _mm256_sub_epi32(_mm256_slli_epi32(row, 3), row);     // row * 7
+            __m256i p0 = points(data, index, -3);     // index-3, index-2
+            __m256i p1 = points(data, index, -1);     // index-1, index
+            __m256i p2 = points(data, index, 1);      // index+1, index+2
+            __m256i p3 = points(data, index, 2);      // index+2, index+3
+
+            __m256 v = _mm256_mul_ps(coeff(table, row, 0), lo16(p0));
+            v = madd(v, coeff(table, row, 1), hi16(p0));
+            v = madd(v, coeff(table, row, 2), lo16(p1));
+            v = madd(v, coeff(table, row, 3), hi16(p1));
+            v = madd(v, coeff(table, row, 4), lo16(p2));
+            v = madd(v, coeff(table, row, 5), hi16(p2));
+            v = madd(v, coeff(table, row, 6), hi16(p3));
+            __m256 a = ampRamp(&amp, ampIncr);
+            _mm256_storeu_ps(buf + i, _mm256_mul_ps(a, v));
+            phase += 8 * incr;
+            i     += 8;
+            }
+      b->phase = phase;
+      b->amp   = amp;
+      return i;
+      }
+
+#pragma GCC pop_options
+
+static const DspKernels avx2Kernels = {
+      DSP_AVX2, "avx2", interpolateNone, interpolateLinear, interpolate4, interpolate7
+      };
+
+//---------------------------------------------------------
+//   dspKernelsAvx2
+//---------------------------------------------------------
+
+const DspKernels* dspKernelsAvx2()
+      {
+      return &avx2Kernels;
+      }
+}
+
+#else
+
+namespace FluidS {
+const DspKernels* dspKernelsAvx2() { return 0; }
+}
+
+#endif
@@ -0,0 +1,84 @@
+/* FluidSynth - A Software Synthesizer
+ *
+ * Copyright (C) 2003  Peter Hanappe and others.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public License
+ * as published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ * 02111-1307, USA
+ */
+
+#ifndef _FLUID_DSPSIMD_H
+#define _FLUID_DSPSIMD_H
+
+namespace FluidS {
+
+//---------------------------------------------------------
+//   DspBlock
+//    state of an interpolation loop handed to a vector
+//    kernel; phase is the 32.32 fixed point value of Phase
+//---------------------------------------------------------
+
+struct DspBlock {
+      float* buf;
+      const short* data;
+      const float* coeffs;    // interpolation table of the kernel
+      qint64 phase;
+      qint64 phaseIncr;
+      float amp;
+      float ampIncr;
+      unsigned endIndex;      // last sample index the kernel may start at
+      };
+
+//---------------------------------------------------------
+//   DspKernel
+//    Renders whole vectors of output samples beginning at
+//    buf[i] as long as a complete vector fits below n and
+//    every point of it lies within endIndex. Returns the
+//    index of the first sample not rendered; phase and amp
+//    are advanced accordingly. The per sample loops in
+//    dsp.cpp finish the remainder.
+//
+//    The kernels evaluate exactly the same expression in
+//    the same order as the scalar code (the amplitude is
+//    accumulated serially), so the output is bit identical
+//    to the reference as long as the scalar code is not
+//    contracted to fma instructions.
+//---------------------------------------------------------
+
+typedef unsigned (*DspKernel)(DspBlock*, unsigned i, unsigned n);
+
+enum DspKernelType {
+      DSP_SCALAR, DSP_SSE2, DSP_AVX2
+      };
+
+//---------------------------------------------------------
+//   DspKernels
+//    a null kernel leaves all work to the scalar loops
+//---------------------------------------------------------
+
+struct DspKernels {
+      DspKernelType type;
+      const char* name;
+      DspKernel none;
+      DspKernel linear;
+      DspKernel order4;
+      DspKernel order7;
+      };
+
+extern const DspKernels* dspKernelsSse2();      // 0 if not compiled in
+extern const DspKernels* dspKernelsAvx2();
+
+}
+
+#endif
@@ -0,0 +1,321 @@
+/* FluidSynth - A Software Synthesizer
+ *
+ * Copyright (C) 2003  Peter Hanappe and others.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public License
+ * as published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ * 02111-1307, USA
+ */
+
+//
+//  SSE2 versions of the interpolation loops in dsp.cpp; four
+//  output samples per iteration. Only the kernels are compiled for
+//  the sse2 target (instead of the whole file with -msse2) so that no
+//  inline function of a shared header ends up with sse2 code.
+//
+
+#include "dspsimd.h"
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#if defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)
+#define FLUID_SSE2
+#endif
+#endif
+
+#ifdef FLUID_SSE2
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#include <emmintrin.h>
+
+namespace FluidS {
+
+//---------------------------------------------------------
+//   ampRamp
+//    amplitude of four consecutive samples, accumulated
+//    the same way as "dsp_amp += dsp_amp_incr"
+//---------------------------------------------------------
+
+static inline __m128 ampRamp(float* amp, float incr)
+      {
+      float a0 = *amp;
+      float a1 = a0 + incr;
+      float a2 = a1 + incr;
+      float a3 = a2 + incr;
+      *amp = a3 + incr;
+      return _mm_setr_ps(a0, a1, a2, a3);
+      }
+
+//---------------------------------------------------------
+//   load2
+//    two consecutive 16 bit points in the lower 32 bit
+//---------------------------------------------------------
+
+static inline __m128i load2(const short* p)
+      {
+      int v;
+      memcpy(&v, p, sizeof(v));
+      return _mm_cvtsi32_si128(v);
+      }
+
+static inline __m128i load4(const short* p)
+      {
+      return _mm_loadl_epi64((const __m128i*)p);
+      }
+
+//---------------------------------------------------------
+//   lo16 / hi16
+//    sign extend the lower/upper 16 bit of every 32 bit lane
+//    and convert to float
+//---------------------------------------------------------
+
+static inline __m128 lo16(__m128i v)
+      {
+      return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(v, 16), 16));
+      }
+
+static inline __m128 hi16(__m128i v)
+      {
+      return _mm_cvtepi32_ps(_mm_srai_epi32(v, 16));
+      }
+
+//---------------------------------------------------------
+//   transpose16
+//    a..d hold four 16 bit points each (lower 64 bit);
+//    returns point k of all four lanes in s[k]
+//---------------------------------------------------------
+
+static inline void transpose16(__m128i a, __m128i b, __m128i c, __m128i d, __m128* s)
+      {
+      __m128i ab   = _mm_unpacklo_epi16(a, b);     // a0 b0 a1 b1 a2 b2 a3 b3
+      __m128i cd   = _mm_unpacklo_epi16(c, d);     // c0 d0 c1 d1 c2 d2 c3 d3
+      __m128i p01  = _mm_unpacklo_epi32(ab, cd);   // a0 b0 c0 d0 a1 b1 c1 d1
+      __m128i p23  = _mm_unpackhi_epi32(ab, cd);   // a2 b2 c2 d2 a3 b3 c3 d3
+      s[0] = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(p01, p01), 16));
+      s[1] = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(p01, p01), 16));
+      s[2] = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(p23, p23), 16));
+      s[3] = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(p23, p23), 16));
+      }
+
+//---------------------------------------------------------
+//   combine
+//    lower 32 bit of a..d into one vector
+//---------------------------------------------------------
+
+static inline __m128i combine(__m128i a, __m128i b, __m128i c, __m128i d)
+      {
+      return _mm_unpacklo_epi64(_mm_unpacklo_epi32(a, b), _mm_unpacklo_epi32(c, d));
+      }
+
+static inline int index(qint64 p)            { return int(p >> 32); }
+static inline unsigned row(qint64 p)         { return quint32(p) >> 24; }
+
+//---------------------------------------------------------
+//   interpolateNone
+//---------------------------------------------------------
+
+static unsigned interpolateNone(DspBlock* b, unsigned i, unsigned n)
+      {
+      const short* data       = b->data;
+      float* buf              = b->buf;
+      const qint64 incr       = b->phaseIncr;
+      const float ampIncr     = b->ampIncr;
+      const unsigned endIndex = b->endIndex;
+      qint64 phase            = b->phase + 0x80000000LL;     // round to nearest point
+      float amp               = b->amp;
+
+      while (i + 4 <= n && quint32((phase + 3 * incr) >> 32) <= endIndex) {
+            qint64 p1 = phase + incr;
+            qint64 p2 = p1 + incr;
+            qint64 p3 = p2 + incr;
+            __m128i v = _mm_cvtsi32_si128(data[index(phase)]);
+            v = _mm_insert_epi16(v, data[index(p1)], 2);
+            v = _mm_insert_epi16(v, data[index(p2)], 4);
+            v = _mm_insert_epi16(v, data[index(p3)], 6);
+            __m128 a = ampRamp(&amp, ampIncr);
+            _mm_storeu_ps(buf + i, _mm_mul_ps(a, lo16(v)));
+            phase = p3 + incr;
+            i    += 4;
+            }
+      b->phase = phase - 0x80000000LL;
+      b->amp   = amp;
+      return i;
+      }
+
+//---------------------------------------------------------
+//   interpolateLinear
+//---------------------------------------------------------
+
+static unsigned interpolateLinear(DspBlock* b, unsigned i, unsigned n)
+      {
+      const short* data       = b->data;
+      const float* table      = b->coeffs;
+      float* buf              = b->buf;
+      const qint64 incr       = b->phaseIncr;
+      const float ampIncr     = b->ampIncr;
+      const unsigned endIndex = b->endIndex;
+      qint64 phase            = b->phase;
+      float amp               = b->amp;
+
+      while (i + 4 <= n && quint32((phase + 3 * incr) >> 32) <= endIndex) {
+            qint64 p1 = phase + incr;
+            qint64 p2 = p1 + incr;
+            qint64 p3 = p2 + incr;
+            __m128i v = combine(load2(data + index(phase)), load2(data + index(p1)),
+               load2(data + index(p2)), load2(data + index(p3)));
+            const float* c0 = table + row(phase) * 2;
+            const float* c1 = table + row(p1) * 2;
+            const float* c2 = table + row(p2) * 2;
+            const float* c3 = table + row(p3) * 2;
+
+            __m128 s = _mm_mul_ps(_mm_setr_ps(c0[0], c1[0], c2[0], c3[0]), lo16(v));
+            s = _mm_add_ps(s, _mm_mul_ps(_mm_setr_ps(c0[1], c1[1], c2[1], c3[1]), hi16(v)));
+            __m128 a = ampRamp(&amp, ampIncr);
+            _mm_storeu_ps(buf + i, _mm_mul_ps(a, s));
+            phase = p3 + incr;
+            i    += 4;
+            }
+      b->phase = phase;
+      b->amp   = amp;
+      return i;
+      }
+
+//---------------------------------------------------------
+//   interpolate4
+//    4th order, points index-1 .. index+2
+//---------------------------------------------------------
+
+static unsigned interpolate4(DspBlock* b, unsigned i, unsigned n)
+      {
+      const short* data       = b->data;
+      const float* table      = b->coeffs;
+      float* buf              = b->buf;
+      const qint64 incr       = b->phaseIncr;
+      const float ampIncr     = b->ampIncr;
+      const unsigned endIndex = b->endIndex;
+      qint64 phase            = b->phase;
+      float amp               = b->amp;
+
+      while (i + 4 <= n && quint32((phase + 3 * incr) >> 32) <= endIndex) {
+            qint64 p1 = phase + incr;
+            qint64 p2 = p1 + incr;
+            qint64 p3 = p2 + incr;
+            __m128 s[4];
+            transpose16(load4(data + index(phase) - 1), load4(data + index(p1) - 1),
+               load4(data + index(p2) - 1), load4(data + index(p3) - 1), s);
+            __m128 c0 = _mm_loadu_ps(table + row(phase) * 4);
+            __m128 c1 = _mm_loadu_ps(table + row(p1) * 4);
+            __m128 c2 = _mm_loadu_ps(table + row(p2) * 4);
+            __m128 c3 = _mm_loadu_ps(table + row(p3) * 4);
+            _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+            __m128 v = _mm_mul_ps(c0, s[0]);
+            v = _mm_add_ps(v, _mm_mul_ps(c1, s[1]));
+            v = _mm_add_ps(v, _mm_mul_ps(c2, s[2]));
+            v = _mm_add_ps(v, _mm_mul_ps(c3, s[3]));
+            __m128 a = ampRamp(&amp, ampIncr);
+            _mm_storeu_ps(buf + i, _mm_mul_ps(a, v));
+            phase = p3 + incr;
+            i    += 4;
+            }
+      b->phase = phase;
+      b->amp   = amp;
+      return i;
+      }
+
+//---------------------------------------------------------
+//   interpolate7
+//    7th order, points index-3 .. index+3; the points are
+//    read as two overlapping groups of four so nothing
+//    beyond index+3 is touched
+//---------------------------------------------------------
+
+static unsigned interpolate7(DspBlock* b, unsigned i, unsigned n)
+      {
+      const short* data       = b->data;
+      const float* table      = b->coeffs;
+      float* buf              = b->buf;
+      const qint64 incr       = b->phaseIncr;
+      const float ampIncr     = b->ampIncr;
+      const unsigned endIndex = b->endIndex;
+      qint64 phase            = b->phase;
+      float amp               = b->amp;
+
+      while (i + 4 <= n && quint32((phase + 3 * incr) >> 32) <= endIndex) {
+            qint64 p1 = phase + incr;
+            qint64 p2 = p1 + incr;
+            qint64 p3 = p2 + incr;
+            const short* d0 = data + index(phase);
+            const short* d1 = data + index(p1);
+            const short* d2 = data + index(p2);
+            const short* d3 = data + index(p3);
+            const float* r0 = table + row(phase) * 7;
+            const float* r1 = table + row(p1) * 7;
+            const float* r2 = table + row(p2) * 7;
+            const float* r3 = table + row(p3) * 7;
+
+            __m128 sl[4], sh[4];
+            transpose16(load4(d0 - 3), load4(d1 - 3), load4(d2 - 3), load4(d3 - 3), sl); // index-3 .. index
+            transpose16(load4(d0), load4(d1), load4(d2), load4(d3), sh);                 // index .. index+3
+            __m128 cl0 = _mm_loadu_ps(r0);
+            __m128 cl1 = _mm_loadu_ps(r1);
+            __m128 cl2 = _mm_loadu_ps(r2);
+            __m128 cl3 = _mm_loadu_ps(r3);
+            _MM_TRANSPOSE4_PS(cl0, cl1, cl2, cl3);          // coeffs 0 .. 3
+            __m128 ch0 = _mm_loadu_ps(r0 + 3);
+            __m128 ch1 = _mm_loadu_ps(r1 + 3);
+            __m128 ch2 = _mm_loadu_ps(r2 + 3);
+            __m128 ch3 = _mm_loadu_ps(r3 + 3);
+            _MM_TRANSPOSE4_PS(ch0, ch1, ch2, ch3);          // coeffs 3 .. 6
+
+            __m128 v = _mm_mul_ps(cl0, sl[0]);
+            v = _mm_add_ps(v, _mm_mul_ps(cl1, sl[1]));
+            v = _mm_add_ps(v, _mm_mul_ps(cl2, sl[2]));
+            v = _mm_add_ps(v, _mm_mul_ps(cl3, sl[3]));
+            v = _mm_add_ps(v, _mm_mul_ps(ch1, sh[1]));
+            v = _mm_add_ps(v, _mm_mul_ps(ch2, sh[2]));
+            v = _mm_add_ps(v, _mm_mul_ps(ch3, sh[3]));
+            __m128 a = ampRamp(&amp, ampIncr);
+            _mm_storeu_ps(buf + i, _mm_mul_ps(a, v));
+            phase = p3 + incr;
+            i    += 4;
+            }
+      b->phase = phase;
+      b->amp   = amp;
+      return i;
+      }
+
+#pragma GCC pop_options
+
+static const DspKernels sse2Kernels = {
+      DSP_SSE2, "sse2", interpolateNone, interpolateLinear, interpolate4, interpolate7
+      };
+
+//---------------------------------------------------------
+//   dspKernelsSse2
+//---------------------------------------------------------
+
+const DspKernels* dspKernelsSse2()
+      {
+      return &sse2Kernels;
+      }
+}
+
+#else
+
+namespace FluidS {
+const DspKernels* dspKernelsSse2() { return 0; }
+}
+
+#endif
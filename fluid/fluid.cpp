@@ -91,6 +91,15 @@ Fluid::Fluid()
       reverb    = 0;
       chorus    = 0;
       silentBlocks = 0;
+      _renderThreads = 1;
+      _deferFree     = false;
+      _polyphony     = 0;
+      _voices        = 0;
+      voiceLimit     = 0;
+      _steals        = 0;
+      _stealFrames   = 0;
+      fontGeneration = 0;
+      loader         = 0;
       }
 
 //---------------------------------------------------------
@@ -112,8 +121,11 @@ void Fluid::init()
 
 void Fluid::init(int sr)
       {
+      static QMutex initMutex;      // several offline renderers may start at once
+      initMutex.lock();
       if (!initialized) // initialize all the conversion tables and other stuff
             init();
+      initMutex.unlock();
 
       sample_rate        = double(sr);
       sfont_id           = 0;
@@ -127,10 +139,16 @@ void Fluid::init(int sr)
 
       for (int i = 0; i < 512; i++)
             freeVoices.append(new Voice(this));
+      _polyphony = 512;
+      _voices    = 512;
+      voiceLimit = 512;
 
       reverb = new Reverb();
       chorus = new Chorus(sample_rate);
       reverb->setPreset(0);
+
+      loader = new SampleLoader;
+      loader->start(QThread::LowPriority);
       }
 
 //---------------------------------------------------------
@@ -140,11 +158,26 @@ void Fluid::init(int sr)
 Fluid::~Fluid()
       {
       _state = FLUID_SYNTH_STOPPED;
+      delete loader;
+      FluidCommand cmd;
+      while (commands.dequeue(&cmd)) {
+            if (cmd.type == CMD_POLYPHONY) {
+                  for (int i = 0; i < cmd.count; ++i)
+                        delete cmd.voices[i];
+                  delete[] cmd.voices;
+                  }
+            }
       foreach(Voice* v, activeVoices)
             delete v;
       foreach(Voice* v, freeVoices)
             delete v;
-      foreach(SFont* sf, sfonts)
+      QSet<SFont*> fonts;
+      foreach(SFontList* l, fontLists) {
+            foreach(SFont* sf, l->fonts)
+                  fonts.insert(sf);
+            delete l;
+            }
+      foreach(SFont* sf, fonts)
             delete sf;
       foreach(BankOffset* bankOffset, bank_offsets)
             delete bankOffset;
@@ -156,6 +189,9 @@ Fluid::~Fluid()
       delete[] fx_buf[0];
       delete[] fx_buf[1];
 
+      freePartitions();
+      freeStems();
+
       delete reverb;
       delete chorus;
       }
@@ -166,15 +202,76 @@ Fluid::~Fluid()
 
 void Fluid::freeVoice(Voice* v)
       {
+      if (_deferFree)         // called from a worker thread; see renderVoices()
+            return;
+      stealQueue.remove(v);
       if (activeVoices.removeOne(v))
             freeVoices.append(v);
       }
 
+//---------------------------------------------------------
+//   sendCommand
+//    never blocks; the audio thread may be the caller
+//---------------------------------------------------------
+
+bool Fluid::sendCommand(const FluidCommand& cmd)
+      {
+      if (commands.enqueue(cmd))
+            return true;
+      qDebug("Fluid: command fifo overflow");
+      return false;
+      }
+
+//---------------------------------------------------------
+//   processCommands
+//    called by process() at the start of every block
+//---------------------------------------------------------
+
+void Fluid::processCommands()
+      {
+      installSoundFonts();
+      FluidCommand cmd;
+      while (commands.dequeue(&cmd)) {
+            switch (cmd.type) {
+                  case CMD_EVENT:
+                        playEvent(cmd.event);
+                        break;
+                  case CMD_NOTES_OFF:
+                        notesOff(cmd.chan);
+                        break;
+                  case CMD_SOUNDS_OFF:
+                        soundsOff(cmd.chan);
+                        break;
+                  case CMD_POLYPHONY:
+                        for (int i = 0; i < cmd.count; ++i)
+                              freeVoices.append(cmd.voices[i]);
+                        delete[] cmd.voices;
+                        voiceLimit = cmd.value;
+                        break;
+                  }
+            }
+      }
+
 //---------------------------------------------------------
 //   play
+//    the event is applied at the start of the next
+//    block
 //---------------------------------------------------------
 
-void Fluid::play(const Event& event)
+void Fluid::play(const ChannelEvent& event)
+      {
+      FluidCommand cmd(CMD_EVENT);
+      cmd.chan  = event.channel();
+      cmd.event = event;
+      sendCommand(cmd);
+      }
+
+//---------------------------------------------------------
+//   playEvent
+//    audio thread
+//---------------------------------------------------------
+
+void Fluid::playEvent(const ChannelEvent& event)
       {
       bool err = false;
       int ch   = event.channel();
@@ -259,10 +356,9 @@ void Fluid::damp_voices(int chan)
 
 void Fluid::allNotesOff(int chan)
       {
-      foreach(Voice* v, activeVoices) {
-            if (chan == -1 || v->chan == chan)
-                  v->noteoff();
-            }
+      FluidCommand cmd(CMD_NOTES_OFF);
+      cmd.chan = chan;
+      sendCommand(cmd);
       }
 
 //---------------------------------------------------------
@@ -272,6 +368,31 @@ void Fluid::allNotesOff(int chan)
 //---------------------------------------------------------
 
 void Fluid::allSoundsOff(int chan)
+      {
+      FluidCommand cmd(CMD_SOUNDS_OFF);
+      cmd.chan = chan;
+      sendCommand(cmd);
+      }
+
+//---------------------------------------------------------
+//   notesOff
+//    audio thread
+//---------------------------------------------------------
+
+void Fluid::notesOff(int chan)
+      {
+      foreach(Voice* v, activeVoices) {
+            if (chan == -1 || v->chan == chan)
+                  v->noteoff();
+            }
+      }
+
+//---------------------------------------------------------
+//   soundsOff
+//    audio thread
+//---------------------------------------------------------
+
+void Fluid::soundsOff(int chan)
       {
       foreach(Voice* v, activeVoices) {
             if (chan == -1 || v->chan == chan)
@@ -493,19 +614,33 @@ void Fluid::process(unsigned len, float* out, float gain)
       memset(fx_buf[0], 0, byte_size);
       memset(fx_buf[1], 0, byte_size);
 
-      if (mutex.tryLock()) {
-            if (activeVoices.isEmpty())
-                  silentBlocks--;
+      processCommands();
+
+      if (activeVoices.isEmpty())
+            silentBlocks--;
+      else {
+            silentBlocks = SILENT_BLOCKS;
+            if (_renderThreads > 1 && activeVoices.size() >= 2 * _renderThreads)
+                  renderVoices(len);
             else {
-                  silentBlocks = SILENT_BLOCKS;
                   foreach (Voice* v, activeVoices)
                         v->write(len, left_buf, right_buf, fx_buf[0], fx_buf[1]);
                   }
-            if (silentBlocks > 0) {
-                  reverb->process(len, fx_buf[0], left_buf, right_buf);
-                  chorus->process(len, fx_buf[1], left_buf, right_buf);
+            // requeue voices which entered a new envelope section
+            foreach (Voice* v, activeVoices) {
+                  if (v->volenv_section != v->queueSection)
+                        stealQueue.update(v);
                   }
-            mutex.unlock();
+            }
+      _stealFrames += len;
+      if (_stealFrames >= sample_rate) {
+            _stealsPerSecond.fetchAndStoreRelaxed(_steals);
+            _steals      = 0;
+            _stealFrames = 0;
+            }
+      if (silentBlocks > 0) {
+            reverb->process(len, fx_buf[0], left_buf, right_buf);
+            chorus->process(len, fx_buf[1], left_buf, right_buf);
             }
       for (unsigned i = 0; i < len; i++) {
             *out++ += gain * left_buf[i];
@@ -513,73 +648,283 @@ void Fluid::process(unsigned len, float* out, float gain)
             }
       }
 
-/*
- * fluid_synth_free_voice_by_kill
- *
- * selects a voice for killing. the selection algorithm is a refinement
- * of the algorithm previously in fluid_synth_alloc_voice.
- */
+//---------------------------------------------------------
+//   setRenderThreads
+//    Render the active voices in n partitions on worker
+//    threads. Meant for offline rendering: process() blocks
+//    until all partitions are done. Must not be called
+//    while process() is running.
+//---------------------------------------------------------
+
+void Fluid::setRenderThreads(int n)
+      {
+      n = qBound(1, n, 64);
+      if (n == _renderThreads)
+            return;
+      freePartitions();
+      _renderThreads = n;
+      if (n > 1) {
+            for (int i = 0; i < n; ++i) {
+                  VoicePartition p;
+                  p.len   = 0;
+                  p.left  = new float[FLUID_MAX_BUFSIZE];
+                  p.right = new float[FLUID_MAX_BUFSIZE];
+                  p.fx[0] = new float[FLUID_MAX_BUFSIZE];
+                  p.fx[1] = new float[FLUID_MAX_BUFSIZE];
+                  partitions.append(p);
+                  }
+            }
+      }
+
+//---------------------------------------------------------
+//   freePartitions
+//---------------------------------------------------------
 
-void Fluid::free_voice_by_kill()
+void Fluid::freePartitions()
       {
-      float best_prio = 999999.;
-      float this_voice_prio;
-      Voice* best_voice = 0;
+      foreach(const VoicePartition& p, partitions) {
+            delete[] p.left;
+            delete[] p.right;
+            delete[] p.fx[0];
+            delete[] p.fx[1];
+            }
+      partitions.clear();
+      }
+
+//---------------------------------------------------------
+//   renderPartition
+//    called from QtConcurrent worker threads
+//---------------------------------------------------------
+
+static void renderPartition(VoicePartition& p)
+      {
+      const int byte_size = p.len * sizeof(float);
+      memset(p.left,  0, byte_size);
+      memset(p.right, 0, byte_size);
+      memset(p.fx[0], 0, byte_size);
+      memset(p.fx[1], 0, byte_size);
+      foreach (Voice* v, p.voices)
+            v->write(p.len, p.left, p.right, p.fx[0], p.fx[1]);
+      }
+
+//---------------------------------------------------------
+//   renderVoices
+//    The active voices are split into consecutive runs, one
+//    per partition. Every partition is mixed into its own
+//    buffers; the buffers are then added up in partition
+//    order. The result therefore only depends on the number
+//    of partitions, not on thread scheduling.
+//    Voices which end while rendering cannot be removed from
+//    activeVoices by the worker threads; they are freed
+//    afterwards in the order the serial loop would free them.
+//---------------------------------------------------------
 
+void Fluid::renderVoices(unsigned len)
+      {
+      QList<Voice*> voices;
       foreach(Voice* v, activeVoices) {
-            /* Determine, how 'important' a voice is.
-             * Start with an arbitrary number */
-            this_voice_prio = 10000.;
-
-            /* Is this voice on the drum channel?
-             * Then it is very important.
-             * Also, forget about the released-note condition:
-             * Typically, drum notes are triggered only very briefly, they run most
-             * of the time in release phase.
-             */
-            if (v->chan == 9) {
-                  this_voice_prio += 4000;
+            if (v->PLAYING())       // write() does nothing for the others
+                  voices.append(v);
+            }
+      const int n     = partitions.size();
+      const int chunk = (voices.size() + n - 1) / n;
+      for (int i = 0; i < n; ++i) {
+            partitions[i].voices = voices.mid(i * chunk, chunk);
+            partitions[i].len    = len;
+            }
 
-                  }
-            else if (v->RELEASED()) {
-                  /* The key for this voice has been released. Consider it much less important
-                  * than a voice, which is still held.
-                  */
-                  this_voice_prio -= 2000.;
-                  }
+      _deferFree = true;
+      QtConcurrent::blockingMap(partitions, renderPartition);
+      _deferFree = false;
 
-            if (v->SUSTAINED()) {
-              /* The sustain pedal is held down on this channel.
-               * Consider it less important than non-sustained channels.
-               * This decision is somehow subjective. But usually the sustain pedal
-               * is used to play 'more-voices-than-fingers', so it shouldn't hurt
-               * if we kill one voice.
-               */
-                  this_voice_prio -= 1000;
+      foreach(const VoicePartition& p, partitions) {
+            for (unsigned i = 0; i < len; ++i) {
+                  left_buf[i]  += p.left[i];
+                  right_buf[i] += p.right[i];
+                  fx_buf[0][i] += p.fx[0][i];
+                  fx_buf[1][i] += p.fx[1][i];
                   }
+            }
+      foreach(Voice* v, voices) {
+            if (v->status == FLUID_VOICE_OFF)
+                  freeVoice(v);
+            }
+      }
+
+//---------------------------------------------------------
+//   createStems
+//    every stem gets its own reverb and chorus with the
+//    current effect settings
+//---------------------------------------------------------
 
-            /* We are not enthusiastic about releasing voices, which have just been started.
-             * Otherwise hitting a chord may result in killing notes belonging to that very same
-             * chord.
-             * So subtract the age of the voice from the priority - an older voice is just a little
-             * bit less important than a younger voice.
-             * This is a number between roughly 0 and 100.*/
+void Fluid::createStems(int n)
+      {
+      freeStems();
+      for (int i = 0; i < n; ++i) {
+            StemBuffer s;
+            s.len    = 0;
+            s.left   = new float[FLUID_MAX_BUFSIZE];
+            s.right  = new float[FLUID_MAX_BUFSIZE];
+            s.fx[0]  = new float[FLUID_MAX_BUFSIZE];
+            s.fx[1]  = new float[FLUID_MAX_BUFSIZE];
+            s.reverb = new Reverb();
+            s.chorus = new Chorus(sample_rate);
+            for (int k = REVERB_ROOMSIZE; k <= REVERB_GAIN; ++k)
+                  s.reverb->setParameter(k, reverb->parameter(k));
+            for (int k = CHORUS_TYPE; k <= CHORUS_GAIN; ++k)
+                  s.chorus->setParameter(k, chorus->parameter(k));
+            stems.append(s);
+            }
+      }
 
-            this_voice_prio -= (noteid - v->get_id());
+//---------------------------------------------------------
+//   freeStems
+//---------------------------------------------------------
 
-            /* take a rough estimate of loudness into account. Louder voices are more important. */
-            if (v->volenv_section != FLUID_VOICE_ENVATTACK) {
-                  this_voice_prio += v->volenv_val * 1000.;
+void Fluid::freeStems()
+      {
+      foreach(const StemBuffer& s, stems) {
+            delete[] s.left;
+            delete[] s.right;
+            delete[] s.fx[0];
+            delete[] s.fx[1];
+            delete s.reverb;
+            delete s.chorus;
+            }
+      stems.clear();
+      }
+
+//---------------------------------------------------------
+//   renderStem
+//    called from QtConcurrent worker threads
+//---------------------------------------------------------
+
+static void renderStem(StemBuffer& s)
+      {
+      const int byte_size = s.len * sizeof(float);
+      memset(s.left,  0, byte_size);
+      memset(s.right, 0, byte_size);
+      memset(s.fx[0], 0, byte_size);
+      memset(s.fx[1], 0, byte_size);
+      foreach (Voice* v, s.voices)
+            v->write(s.len, s.left, s.right, s.fx[0], s.fx[1]);
+      s.reverb->process(s.len, s.fx[0], s.left, s.right);
+      s.chorus->process(s.len, s.fx[1], s.left, s.right);
+      }
+
+//---------------------------------------------------------
+//   processStems
+//    Offline rendering: the voices of channel c are mixed
+//    into out[channelStem[c]]. Every stem is rendered with
+//    its own effects on a worker thread, so the stems add
+//    up to the output of process(). Voices of channels
+//    without a stem are rendered and dropped.
+//---------------------------------------------------------
+
+void Fluid::processStems(unsigned len, float** out, const QVector<int>& channelStem,
+   int, float gain)
+      {
+      processCommands();
+
+      int n = 0;
+      foreach(int s, channelStem)
+            n = qMax(n, s + 1);
+      if (n != stems.size())
+            createStems(n);
+      for (int i = 0; i < n; ++i) {
+            stems[i].voices.clear();
+            stems[i].len = len;
+            }
+
+      const int byte_size = len * sizeof(float);
+      memset(left_buf,  0, byte_size);
+      memset(right_buf, 0, byte_size);
+      memset(fx_buf[0], 0, byte_size);
+      memset(fx_buf[1], 0, byte_size);
+
+      QList<Voice*> voices;
+      foreach(Voice* v, activeVoices) {
+            if (!v->PLAYING())
+                  continue;
+            int s = v->chan < channelStem.size() ? channelStem[v->chan] : -1;
+            if (s >= 0) {
+                  stems[s].voices.append(v);
+                  voices.append(v);
                   }
+            else
+                  v->write(len, left_buf, right_buf, fx_buf[0], fx_buf[1]);
+            }
+
+      _deferFree = true;
+      QtConcurrent::blockingMap(stems, renderStem);
+      _deferFree = false;
+
+      foreach(Voice* v, voices) {
+            if (v->status == FLUID_VOICE_OFF)
+                  freeVoice(v);
+            }
+      foreach (Voice* v, activeVoices) {
+            if (v->volenv_section != v->queueSection)
+                  stealQueue.update(v);
+            }
 
-            /* check if this voice has less priority than the previous candidate. */
-            if (this_voice_prio < best_prio) {
-                  best_voice = v;
-                  best_prio = this_voice_prio;
+      for (int i = 0; i < n; ++i) {
+            const StemBuffer& s = stems[i];
+            float* p = out[i];
+            for (unsigned k = 0; k < len; ++k) {
+                  *p++ += gain * s.left[k];
+                  *p++ += gain * s.right[k];
                   }
             }
-      if (best_voice)
-            best_voice->off();
+      }
+
+//---------------------------------------------------------
+//   free_voice_by_kill
+//    Kill the voice with the lowest steal priority; see
+//    Voice::stealPriority() for the rating. Returns false
+//    if there is no voice to kill.
+//---------------------------------------------------------
+
+bool Fluid::free_voice_by_kill()
+      {
+      Voice* v = stealQueue.top();
+      if (v == 0)
+            return false;
+      v->off();
+      ++_steals;
+      _totalSteals.fetchAndAddRelaxed(1);
+      return true;
+      }
+
+//---------------------------------------------------------
+//   setPolyphony
+//    Set the max number of voices playing at once; the
+//    voice pool grows as needed. If more voices are active,
+//    they are not killed but new notes steal voices until
+//    the number drops below the limit.
+//    The new voices are allocated here and handed to the
+//    audio thread together with the limit.
+//---------------------------------------------------------
+
+void Fluid::setPolyphony(int n)
+      {
+      n = qBound(1, n, FLUID_MAX_POLYPHONY);
+      FluidCommand cmd(CMD_POLYPHONY);
+      cmd.value = n;
+      cmd.count = qMax(0, n - _voices);
+      if (cmd.count) {
+            cmd.voices = new Voice*[cmd.count];
+            for (int i = 0; i < cmd.count; ++i)
+                  cmd.voices[i] = new Voice(this);
+            }
+      if (!sendCommand(cmd)) {
+            for (int i = 0; i < cmd.count; ++i)
+                  delete cmd.voices[i];
+            delete[] cmd.voices;
+            return;
+            }
+      _voices   += cmd.count;
+      _polyphony = n;
       }
 
 //---------------------------------------------------------
@@ -590,11 +935,15 @@ Voice* Fluid::alloc_voice(unsigned id, Sample* sample, int chan, int key, int ve
       {
       Channel* c = 0;
 
-      /* check if there's an available synthesis process */
-      if (freeVoices.isEmpty())
-            free_voice_by_kill();
+      /* check if there's an available synthesis process; after the
+         limit was lowered, kill until the number drops below it */
+      while (freeVoices.isEmpty() || activeVoices.size() >= voiceLimit) {
+            int n = activeVoices.size();
+            if (!free_voice_by_kill() || activeVoices.size() == n)
+                  break;
+            }
 
-      if (freeVoices.isEmpty()) {
+      if (freeVoices.isEmpty() || activeVoices.size() >= voiceLimit) {
             log("Failed to allocate a synthesis process. (chan=%d,key=%d)", chan, key);
             return 0;
             }
@@ -663,6 +1012,7 @@ void Fluid::start_voice(Voice* voice)
                   }
             }
       voice->voice_start();
+      stealQueue.insert(voice);
       }
 
 //---------------------------------------------------------
@@ -675,7 +1025,7 @@ void Fluid::updatePatchList()
             delete p;
       patches.clear();
 
-      foreach(const SFont* sf, sfonts) {
+      foreach(const SFont* sf, _soundFonts) {
             BankOffset* bo = get_bank_offset0(sf->id());
             int bankOffset = bo ? bo->offset : 0;
             foreach (Preset* p, sf->getPresets()) {
@@ -696,13 +1046,41 @@ void Fluid::updatePatchList()
 QStringList Fluid::soundFonts() const
       {
       QStringList sf;
-      foreach (SFont* f, sfonts)
+      foreach (SFont* f, _soundFonts)
             sf.append(f->get_name());
       return sf;
       }
 
 //---------------------------------------------------------
-//   loadSoundFont
+//   prefetchProgram
+//    gui thread; start loading the samples of a program
+//    before it is selected by a program change
+//---------------------------------------------------------
+
+void Fluid::prefetchProgram(int bank, int program)
+      {
+      foreach(SFont* sf, _soundFonts) {
+            Preset* p = sf->get_preset(bank - get_bank_offset(sf->id()), program);
+            if (p) {
+                  loadPreset(p);
+                  return;
+                  }
+            }
+      }
+
+//---------------------------------------------------------
+//   waitPrefetch
+//    wait until all presets requested so far are loaded;
+//    for offline rendering
+//---------------------------------------------------------
+
+void Fluid::waitPrefetch()
+      {
+      loader->sync();
+      }
+
+//---------------------------------------------------------
+//   loadSoundFonts
 //    return false on error
 //---------------------------------------------------------
 
@@ -713,20 +1091,16 @@ bool Fluid::loadSoundFonts(const QStringList& sl)
             // printf("Fluid:loadSoundFonts: already loaded\n");
             return true;
             }
-      mutex.lock();
-      foreach(Voice* v, activeVoices)
-            v->off();
-      foreach(Channel* c, channel)
-            c->reset();
-      foreach (SFont* sf, sfonts)
-            sfunload(sf->id(), true);
+      QList<SFont*> fonts;
       bool ok = true;
-
-      for (int i = sl.size() - 1; i >= 0; --i) {
-            if (sfload(sl[i], true) == -1)
+      foreach(const QString& s, sl) {
+            SFont* sf = loadSoundFont(s);
+            if (sf)
+                  fonts.append(sf);
+            else
                   ok = false;
             }
-      mutex.unlock();
+      publishSoundFonts(fonts, SFONT_RESET);
       return ok;
       }
 
@@ -737,10 +1111,13 @@ bool Fluid::loadSoundFonts(const QStringList& sl)
 
 bool Fluid::addSoundFont(const QString& s)
       {
-      mutex.lock();
-      bool rv = (sfload(s, true) == -1) ? false : true;
-      mutex.unlock();
-      return rv;
+      SFont* sf = loadSoundFont(s);
+      if (sf == 0)
+            return false;
+      QList<SFont*> fonts = _soundFonts;
+      fonts.prepend(sf);
+      publishSoundFonts(fonts, SFONT_KEEP_VOICES);
+      return true;
       }
 
 //---------------------------------------------------------
@@ -750,96 +1127,121 @@ bool Fluid::addSoundFont(const QString& s)
 
 bool Fluid::removeSoundFont(const QString& s)
       {
-      mutex.lock();
-      foreach(Voice* v, activeVoices)
-            v->off();
-      SFont* sf = get_sfont_by_name(s);
-      sfunload(sf->id(), true);
-      mutex.unlock();
-      return true;
+      QList<SFont*> fonts = _soundFonts;
+      foreach(SFont* sf, _soundFonts) {
+            if (sf->get_name() == s) {
+                  fonts.removeOne(sf);
+                  publishSoundFonts(fonts, SFONT_VOICES_OFF);
+                  return true;
+                  }
+            }
+      return false;
       }
 
 //---------------------------------------------------------
-//   sfload
+//   loadSoundFont
+//    gui thread; returns 0 on error
 //---------------------------------------------------------
 
-int Fluid::sfload(const QString& filename, bool reset_presets)
+SFont* Fluid::loadSoundFont(const QString& filename)
       {
       if (filename.isEmpty())
-            return -1;
-
+            return 0;
       SFont* sf = new SFont(this);
       if (!sf->read(filename)) {
             delete sf;
-            sf = 0;
-            return -1;
+            return 0;
             }
-
       sf->setId(++sfont_id);
-
-      /* insert the sfont as the first one on the list */
-      sfonts.prepend(sf);
-
-      /* reset the presets for all channels */
-      if (reset_presets)
-            program_reset();
-
-      updatePatchList();
-      return sf->id();
+      return sf;
       }
 
 //---------------------------------------------------------
-//   sfunload
+//   publishSoundFonts
+//    Hand a new set of soundfonts to the audio thread.
+//    A list which was published but not yet picked up
+//    is taken back; its mode is merged into the new one
+//    so that voices of removed fonts are still stopped.
 //---------------------------------------------------------
 
-bool Fluid::sfunload(int id, bool reset_presets)
+void Fluid::publishSoundFonts(const QList<SFont*>& fonts, int mode)
       {
-      SFont* sf = get_sfont_by_id(id);
-
-      if (!sf) {
-            printf("No SoundFont with id = %d", id);
-            return false;
+      SFontList* l = new SFontList;
+      l->fonts     = fonts;
+      l->mode      = mode;
+      SFontList* ol = pendingFonts.fetchAndStoreOrdered(0);
+      if (ol) {
+            l->mode = qMax(l->mode, ol->mode);
+            ol->generation = -1;
             }
+      l->generation = ++fontGeneration;
+      fontLists.append(l);
+      pendingFonts.fetchAndStoreOrdered(l);
 
-      sfonts.removeAll(sf);   // remove the SoundFont from the list
-
-      /* reset the presets for all channels */
-      if (reset_presets)
-            program_reset();
-      else
-            update_presets();
-      delete sf;
+      _soundFonts = fonts;
       updatePatchList();
-      return true;
+      collectSoundFonts();
       }
 
 //---------------------------------------------------------
-//   add_sfont
+//   collectSoundFonts
+//    Delete lists older than the one installed by the
+//    audio thread, and all fonts which are not part of
+//    a remaining list.
 //---------------------------------------------------------
 
-int Fluid::add_sfont(SFont* sf)
+void Fluid::collectSoundFonts()
       {
-	sf->setId(++sfont_id);
-
-	/* insert the sfont as the first one on the list */
-      sfonts.prepend(sf);
-
-	/* reset the presets for all channels */
-	program_reset();
-	return sf->id();
+      int installed = installedGeneration.fetchAndAddAcquire(0);
+      QList<SFontList*> garbage;
+      QSet<SFont*> live;
+      foreach(SFontList* l, fontLists) {
+            if (l->generation < installed)
+                  garbage.append(l);
+            else {
+                  foreach(SFont* sf, l->fonts)
+                        live.insert(sf);
+                  }
+            }
+      QSet<SFont*> fonts;
+      foreach(SFontList* l, garbage) {
+            foreach(SFont* sf, l->fonts) {
+                  if (!live.contains(sf))
+                        fonts.insert(sf);
+                  }
+            fontLists.removeOne(l);
+            delete l;
+            }
+      if (fonts.isEmpty())
+            return;
+      // the audio thread does not request presets of these
+      // fonts anymore; wait for the requests still queued
+      loader->sync();
+      foreach(SFont* sf, fonts)
+            delete sf;
       }
 
 //---------------------------------------------------------
-//   remove_sfont
+//   installSoundFonts
+//    audio thread; switch to the last published list
 //---------------------------------------------------------
 
-void Fluid::remove_sfont(SFont* sf)
+void Fluid::installSoundFonts()
       {
-	int sfont_id = sf->id();
-	sfonts.removeAll(sf);
-
-	remove_bank_offset(sfont_id); /* remove a possible bank offset */
-	program_reset();              /* reset the presets for all channels */
+      SFontList* l = pendingFonts.fetchAndStoreAcquire(0);
+      if (l == 0)
+            return;
+      if (l->mode >= SFONT_VOICES_OFF) {
+            foreach(Voice* v, activeVoices)
+                  v->off();
+            }
+      if (l->mode == SFONT_RESET) {
+            foreach(Channel* c, channel)
+                  c->reset();
+            }
+      sfonts = l->fonts;
+      program_reset();
+      installedGeneration.fetchAndStoreRelease(l->generation);
       }
 
 //---------------------------------------------------------
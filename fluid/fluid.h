@@ -25,6 +25,9 @@
 #include "msynth/synti.h"
 #include "libmscore/midipatch.h"
 #include "rev.h"
+#include "voicequeue.h"
+#include "cmdfifo.h"
+#include "sampleloader.h"
 
 namespace FluidS {
 
@@ -39,6 +42,7 @@ class Chorus;
 class Fluid;
 
 #define FLUID_MAX_BUFSIZE       4096
+#define FLUID_MAX_POLYPHONY     4096
 #define FLUID_NUM_PROGRAMS      129
 
 enum fluid_loop {
@@ -64,6 +68,56 @@ struct BankOffset {
       int offset;
       };
 
+//---------------------------------------------------------
+//   VoicePartition
+//    a share of the active voices, rendered by one worker
+//    thread into private buffers (see Fluid::renderVoices())
+//---------------------------------------------------------
+
+struct VoicePartition {
+      QList<Voice*> voices;
+      unsigned len;
+      float* left;
+      float* right;
+      float* fx[2];
+      };
+
+//---------------------------------------------------------
+//   StemBuffer
+//    the voices of a group of channels, rendered with their
+//    own effects into private buffers (see
+//    Fluid::processStems())
+//---------------------------------------------------------
+
+struct StemBuffer {
+      QList<Voice*> voices;
+      unsigned len;
+      float* left;
+      float* right;
+      float* fx[2];
+      Reverb* reverb;
+      Chorus* chorus;
+      };
+
+//---------------------------------------------------------
+//   SFontList
+//    a set of soundfonts published by the gui thread;
+//    the audio thread installs it at the start of the
+//    next block (see Fluid::installSoundFonts())
+//---------------------------------------------------------
+
+enum {
+      SFONT_KEEP_VOICES,      // the new list contains all fonts in use
+      SFONT_VOICES_OFF,       // stop all voices before the switch
+      SFONT_RESET             // also reset all channels
+      };
+
+struct SFontList {
+      QList<SFont*> fonts;
+      int mode;
+      int generation;         // -1: replaced before it was installed
+      };
+
 enum fluid_midi_control_change {
       BANK_SELECT_MSB = 0x00,
       MODULATION_MSB = 0x01,
@@ -317,7 +371,7 @@ class Fluid : public Synth {
       static const int SILENT_BLOCKS = 32*5;
       int silentBlocks;
 
-      QList<SFont*> sfonts;               // the loaded soundfonts
+      QList<SFont*> sfonts;               // the soundfonts used by the audio thread
       QList<BankOffset*> bank_offsets;    // the offsets of the soundfont banks
       QList<MidiPatch*> patches;
 
@@ -332,9 +386,50 @@ class Fluid : public Synth {
       float _masterTuning;                // usually 440.0
       double _tuning[128];                // the pitch of every key, in cents
 
-      QMutex mutex;
       void updatePatchList();
 
+      // The gui thread never touches the synthesizer state
+      // directly. Events and commands are passed through a
+      // fifo, soundfonts are replaced by publishing a new
+      // SFontList. Both are picked up by process().
+
+      CommandFifo commands;
+      bool sendCommand(const FluidCommand&);
+      void processCommands();
+      void playEvent(const ChannelEvent&);
+
+      QList<SFont*> _soundFonts;          // gui: the last published soundfonts
+      QList<SFontList*> fontLists;        // gui: published lists, not yet reclaimed
+      int fontGeneration;                 // gui: generation of the last published list
+      QAtomicPointer<SFontList> pendingFonts;   // published, not yet installed
+      QAtomicInt installedGeneration;     // written by the audio thread
+      SFont* loadSoundFont(const QString& filename);
+      void publishSoundFonts(const QList<SFont*>& fonts, int mode);
+      void collectSoundFonts();
+      void installSoundFonts();
+
+      SampleLoader* loader;
+
+      int _renderThreads;                 // number of voice partitions, 1: render serially
+      bool _deferFree;                    // voices are written by worker threads
+      QList<VoicePartition> partitions;
+      void freePartitions();
+      void renderVoices(unsigned len);
+
+      QList<StemBuffer> stems;
+      void createStems(int n);
+      void freeStems();
+
+      VoiceQueue stealQueue;              // active voices by steal priority
+      int _polyphony;                     // gui: max number of active voices
+      int _voices;                        // gui: size of the voice pool
+      int voiceLimit;                     // audio thread: value of _polyphony
+      int _steals;                        // voices killed in the current second
+      unsigned _stealFrames;              // frames rendered in the current second
+      mutable QAtomicInt _stealsPerSecond;  // read by the gui
+      mutable QAtomicInt _totalSteals;
+      void updateStealQueue(Voice* v) { stealQueue.update(v); }
+
    protected:
       int _state;                         // the synthesizer state
 
@@ -354,11 +449,6 @@ class Fluid : public Synth {
 
       SFont* get_sfont_by_name(const QString& name);
       SFont* get_sfont_by_id(int id);
-      SFont* get_sfont(int idx) const     { return sfonts[idx];   }
-      void remove_sfont(SFont* sf);
-      int add_sfont(SFont* sf);
-      bool sfunload(int id, bool reset_presets);
-      int sfload(const QString& filename, bool reset_presets);
 
    public:
       Fluid();
@@ -367,7 +457,7 @@ class Fluid : public Synth {
 
       virtual const char* name() const { return "Fluid"; }
 
-      virtual void play(const Event&);
+      virtual void play(const ChannelEvent&);
       virtual const QList<MidiPatch*>& getPatchInfo() const { return patches; }
 
       // set/get a single parameter
@@ -379,6 +469,8 @@ class Fluid : public Synth {
       virtual void setState(SyntiState&);
       virtual void allSoundsOff(int);
       virtual void allNotesOff(int);
+      void notesOff(int chan);            // audio thread versions of the above
+      void soundsOff(int chan);
 
       bool log(const char* fmt, ...);
 
@@ -412,6 +504,10 @@ class Fluid : public Synth {
 
       Preset* get_channel_preset(int chan) const { return channel[chan]->preset(); }
 
+      void loadPreset(Preset* p)          { loader->load(p); }
+      virtual void prefetchProgram(int bank, int program);
+      virtual void waitPrefetch();
+
       virtual bool loadSoundFonts(const QStringList& s);
       virtual bool addSoundFont(const QString& s);
       virtual bool removeSoundFont(const QString& s);
@@ -419,9 +515,18 @@ class Fluid : public Synth {
 
       void start_voice(Voice* voice);
       Voice* alloc_voice(unsigned id, Sample* sample, int chan, int key, int vel, double vt);
-      void free_voice_by_kill();
+      bool free_voice_by_kill();
 
       virtual void process(unsigned len, float* out, float gain);
+      virtual void processStems(unsigned len, float** out, const QVector<int>& channelStem,
+         int defaultStem, float gain);
+      virtual void setRenderThreads(int n);
+      int renderThreads() const { return _renderThreads; }
+
+      void setPolyphony(int n);
+      int polyphony() const            { return _polyphony; }
+      int stealsPerSecond() const      { return _stealsPerSecond.fetchAndAddRelaxed(0); }
+      int totalSteals() const          { return _totalSteals.fetchAndAddRelaxed(0); }
 
       void program_reset();
 
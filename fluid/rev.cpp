@@ -16,6 +16,10 @@ namespace FluidS {
 
 #define DC_OFFSET 1e-8
 
+static const int REVERB_BLOCK = 64;       // max samples per processing block
+
+typedef float v4sf __attribute__ ((vector_size (16)));
+
 static ReverbPreset revmodel_preset[] = {
       // name           roomsize       damp      width        level
       { "Default",         0.5f,      0.5f,       1.0f,       0.2f },
@@ -47,6 +51,33 @@ void Allpass::init()
             buffer[i] = DC_OFFSET;  // this is not 100 % correct.
       }
 
+//---------------------------------------------------------
+//   process
+//    filter n samples in place; as a block is never longer
+//    than the delay line, there is no dependency between
+//    the samples of one segment
+//---------------------------------------------------------
+
+void Allpass::process(int n, float* io)
+      {
+      while (n) {
+            int len = qMin(n, bufsize - bufidx);
+            float* __restrict b = buffer + bufidx;
+            float* __restrict x = io;
+            for (int i = 0; i < len; ++i) {
+                  float bufout = b[i];
+                  float input  = x[i];
+                  x[i] = bufout - input;
+                  b[i] = input + (bufout * feedback);
+                  }
+            bufidx += len;
+            if (bufidx >= bufsize)
+                  bufidx = 0;
+            io += len;
+            n  -= len;
+            }
+      }
+
 void Comb::setbuffer(int size)
       {
       filterstore = 0;
@@ -101,7 +132,8 @@ Reverb::Reverb()
             allpassL[i].setfeedback(0.5f);
             allpassR[i].setfeedback(0.5f);
             }
-      gain = 0.30;      // input gain
+      gain    = 0.30;   // input gain
+      newGain = gain;
       setPreset(0);
       init();           // Clear all buffers
       parameterChanged = false;
@@ -123,8 +155,68 @@ void Reverb::init()
             }
       }
 
+//---------------------------------------------------------
+//   flushDenormal
+//---------------------------------------------------------
+
+static inline float flushDenormal(float v)
+      {
+      return fabsf(v) < 1e-30f ? 0.0f : v;
+      }
+
+//---------------------------------------------------------
+//   processCombs
+//    Run four comb filters over n samples; n must not reach
+//    beyond the end of any of their buffers, so every comb
+//    reads and writes one contiguous segment of its delay
+//    line. The lowpass filters of the four combs run side by
+//    side as one vector; all combs share damping and feedback
+//    (see update()). The delayed signal is added to out in
+//    comb order.
+//---------------------------------------------------------
+
+void Reverb::processCombs(Comb* c, int n, const float* in, float* out)
+      {
+      float* __restrict p0 = c[0].buffer + c[0].bufidx;
+      float* __restrict p1 = c[1].buffer + c[1].bufidx;
+      float* __restrict p2 = c[2].buffer + c[2].bufidx;
+      float* __restrict p3 = c[3].buffer + c[3].bufidx;
+      float* __restrict o  = out;
+
+      const float d1      = c[0].damp1;
+      const float d2      = c[0].damp2;
+      const float fb      = c[0].feedback;
+      const v4sf damp1    = { d1, d1, d1, d1 };
+      const v4sf damp2    = { d2, d2, d2, d2 };
+      const v4sf feedback = { fb, fb, fb, fb };
+      v4sf fs = { c[0].filterstore, c[1].filterstore, c[2].filterstore, c[3].filterstore };
+
+      for (int k = 0; k < n; ++k) {
+            const float x    = in[k];
+            const v4sf input = { x, x, x, x };
+            const v4sf tmp   = { p0[k], p1[k], p2[k], p3[k] };
+            fs               = (tmp * damp2) + (fs * damp1);
+            const v4sf v     = input + (fs * feedback);
+            p0[k] = v[0];
+            p1[k] = v[1];
+            p2[k] = v[2];
+            p3[k] = v[3];
+            o[k]  = o[k] + tmp[0] + tmp[1] + tmp[2] + tmp[3];
+            }
+
+      for (int i = 0; i < 4; ++i) {
+            c[i].filterstore = flushDenormal(fs[i]);
+            c[i].bufidx += n;
+            if (c[i].bufidx >= c[i].bufsize)
+                  c[i].bufidx = 0;
+            }
+      }
+
 //---------------------------------------------------------
 //   process
+//    The signal is processed in blocks which end where the
+//    first comb buffer wraps around, so every stage can
+//    run over a whole block at once.
 //---------------------------------------------------------
 
 void Reverb::process(int n, float* in, float* l, float* r)
@@ -137,28 +229,45 @@ void Reverb::process(int n, float* in, float* l, float* r)
             update();
             parameterChanged = false;
             }
-      for (int k = 0; k < n; k++) {
-            float outL = 0.0;
-            float outR = 0.0;
-
-            float input = (in[k] * 2.0 + DC_OFFSET) * gain;
+      float input[REVERB_BLOCK];
+      float outL[REVERB_BLOCK];
+      float outR[REVERB_BLOCK];
+
+      for (int k = 0; k < n;) {
+            int len = qMin(n - k, REVERB_BLOCK);
+            for (int i = 0; i < numcombs; ++i) {
+                  len = qMin(len, combL[i].bufsize - combL[i].bufidx);
+                  len = qMin(len, combR[i].bufsize - combR[i].bufidx);
+                  }
+            for (int i = 0; i < len; ++i)
+                  input[i] = (in[k + i] * 2.0 + DC_OFFSET) * gain;
 
-            for (int i = 0; i < numcombs; i++) {      // Accumulate comb filters in parallel
-                  outL += combL[i].process(input);
-                  outR += combR[i].process(input);
+            for (int i = 0; i < len; ++i) {
+                  outL[i] = 0.0;
+                  outR[i] = 0.0;
                   }
+            for (int i = 0; i < numcombs; i += 4) {   // Accumulate comb filters in parallel
+                  processCombs(&combL[i], len, input, outL);
+                  processCombs(&combR[i], len, input, outR);
+                  }
+
             for (int i = 0; i < numallpasses; i++) {  // Feed through allpasses in series
-                  outL = allpassL[i].process(outL);
-                  outR = allpassR[i].process(outR);
+                  allpassL[i].process(len, outL);
+                  allpassR[i].process(len, outR);
                   }
 
-            /* Remove the DC offset */
-            outL -= DC_OFFSET;
-            outR -= DC_OFFSET;
+            for (int i = 0; i < len; ++i) {
+                  /* Remove the DC offset */
+                  float oL = outL[i];
+                  float oR = outR[i];
+                  oL -= DC_OFFSET;
+                  oR -= DC_OFFSET;
 
-            /* Calculate output MIXING with anything already there */
-            l[k] += outL * wet1 + outR * wet2;
-            r[k] += outR * wet1 + outL * wet2;
+                  /* Calculate output MIXING with anything already there */
+                  l[k + i] += oL * wet1 + oR * wet2;
+                  r[k + i] += oR * wet1 + oL * wet2;
+                  }
+            k += len;
             }
       }
 
@@ -42,19 +42,12 @@ class Allpass {
       void init();
       void setfeedback(float val) { feedback = val;  }
       float getfeedback() const   { return feedback; }
-
-      float process(float _input) {
-            float bufout = buffer[bufidx];
-            float output = bufout - _input;
-            buffer[bufidx] = _input + (bufout * feedback);
-            if (++bufidx >= bufsize)
-                  bufidx = 0;
-            return output;
-            }
+      void process(int n, float* io);
       };
 
 //---------------------------------------------------------
 //   Comb
+//    processed by Reverb::processCombs() four at a time
 //---------------------------------------------------------
 
 class Comb {
@@ -66,6 +59,8 @@ class Comb {
       int bufsize;
       int bufidx;
 
+      friend class Reverb;
+
    public:
       void setbuffer(int size);
       void init();
@@ -73,15 +68,6 @@ class Comb {
       float getdamp() const       { return damp1;    }
       void setfeedback(float val) { feedback = val;  }
       float getfeedback() const   { return feedback; }
-
-      float process(float input) {
-            float tmp = buffer[bufidx];
-            filterstore      = (tmp * damp2) + (filterstore * damp1);
-            buffer[bufidx]   = input + (filterstore * feedback);
-            if (++bufidx >= bufsize)
-                  bufidx = 0;
-            return tmp;
-            }
       };
 
 static const float scaleroom  = 0.28f;
@@ -96,6 +82,7 @@ static const float scaledamp  = 0.4f;
 class Reverb {
       void init();
       void update();
+      void processCombs(Comb* c, int n, const float* in, float* out);
 
       float roomsize;
       float damp;
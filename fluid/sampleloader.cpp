@@ -0,0 +1,133 @@
+/* FluidSynth - A Software Synthesizer
+ *
+ * Copyright (C) 2003  Peter Hanappe and others.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public License
+ * as published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ * 02111-1307, USA
+ */
+
+
+#include "sampleloader.h"
+#include "sfont.h"
+
+namespace FluidS {
+
+static const int IDLE_WAIT = 50;    // msec, bounds the delay of a lost wake up
+
+//---------------------------------------------------------
+//   SampleLoader
+//---------------------------------------------------------
+
+SampleLoader::SampleLoader()
+      {
+      syncCount = 0;
+      }
+
+//---------------------------------------------------------
+//   ~SampleLoader
+//    requests still in the fifo are dropped
+//---------------------------------------------------------
+
+SampleLoader::~SampleLoader()
+      {
+      quit.fetchAndStoreOrdered(1);
+      wake();
+      wait();
+      }
+
+//---------------------------------------------------------
+//   wake
+//    not for the audio thread
+//---------------------------------------------------------
+
+void SampleLoader::wake()
+      {
+      mutex.lock();
+      wakeup.wakeOne();
+      mutex.unlock();
+      }
+
+//---------------------------------------------------------
+//   run
+//    sleeps until a request wakes it up; a request from the
+//    audio thread cannot wait for the mutex and its wake up
+//    is lost if the loader is just about to sleep, so the
+//    fifo is checked again after IDLE_WAIT
+//---------------------------------------------------------
+
+void SampleLoader::run()
+      {
+      mutex.lock();
+      while (!quit.fetchAndAddAcquire(0)) {
+            FluidCommand cmd;
+            if (!requests.dequeue(&cmd)) {
+                  wakeup.wait(&mutex, IDLE_WAIT);
+                  continue;
+                  }
+            mutex.unlock();
+            if (cmd.type == CMD_LOAD_PRESET)
+                  cmd.preset->loadSamples();
+            else if (cmd.type == CMD_SYNC)
+                  syncSerial.fetchAndStoreRelease(cmd.value);
+            mutex.lock();
+            }
+      mutex.unlock();
+      }
+
+//---------------------------------------------------------
+//   load
+//    any thread, never blocks; a preset is only queued
+//    once
+//---------------------------------------------------------
+
+void SampleLoader::load(Preset* p)
+      {
+      if (!p->requestLoad())
+            return;
+      FluidCommand cmd(CMD_LOAD_PRESET);
+      cmd.preset = p;
+      if (!requests.enqueue(cmd)) {
+            p->cancelLoad();
+            qDebug("SampleLoader: fifo overflow");
+            return;
+            }
+      // the loader holds the mutex only on its way to sleep
+      if (mutex.tryLock()) {
+            wakeup.wakeOne();
+            mutex.unlock();
+            }
+      }
+
+//---------------------------------------------------------
+//   sync
+//    Wait until all requests sent before are done. Not
+//    for the audio thread; used to make sure no preset of
+//    a soundfont about to be deleted is still loading and
+//    by offline rendering.
+//---------------------------------------------------------
+
+void SampleLoader::sync()
+      {
+      if (!isRunning())
+            return;
+      FluidCommand cmd(CMD_SYNC);
+      cmd.value = ++syncCount;
+      while (!requests.enqueue(cmd))
+            msleep(1);
+      wake();
+      while (syncSerial.fetchAndAddAcquire(0) != cmd.value)
+            msleep(1);
+      }
+}
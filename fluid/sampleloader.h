@@ -0,0 +1,59 @@
+/* FluidSynth - A Software Synthesizer
+ *
+ * Copyright (C) 2003  Peter Hanappe and others.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public License
+ * as published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ * 02111-1307, USA
+ */
+
+
+#ifndef _FLUID_SAMPLELOADER_H
+#define _FLUID_SAMPLELOADER_H
+
+#include "cmdfifo.h"
+
+namespace FluidS {
+
+class Preset;
+
+//---------------------------------------------------------
+//   SampleLoader
+//    Loads the samples of presets in a background thread,
+//    so that a program change never waits for the disk or
+//    for sf3 decoding. Requests are accepted from any
+//    thread without blocking. Until its samples are ready
+//    a preset plays no sound (see Preset::noteon()).
+//---------------------------------------------------------
+
+class SampleLoader : public QThread {
+      CommandFifo requests;
+      QAtomicInt quit;
+      QAtomicInt syncSerial;        // last CMD_SYNC processed
+      int syncCount;                // last CMD_SYNC sent
+      QMutex mutex;                 // held by the loader unless it waits or loads
+      QWaitCondition wakeup;
+
+      virtual void run();
+      void wake();
+
+   public:
+      SampleLoader();
+      ~SampleLoader();
+      void load(Preset*);
+      void sync();
+      };
+
+}
+#endif
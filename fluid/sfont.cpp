@@ -47,15 +47,25 @@ SFVersion::SFVersion()
 //   SFont
 //---------------------------------------------------------
 
+bool SFont::_mapSamples = true;
+QString SFont::_sampleCacheDir;
+
 SFont::SFont(Fluid* f)
       {
-      synth      = f;
-      samplepos  = 0;
-      samplesize = 0;
+      synth        = f;
+      samplepos    = 0;
+      samplesize   = 0;
+      sampleMap    = 0;
+      cacheMap     = 0;
+      cacheState   = CACHE_NONE;
+      cacheBuilder = 0;
       }
 
 SFont::~SFont()
       {
+#ifdef SOUNDFONT3
+      stopSampleCache();
+#endif
       foreach(Sample* s, sample)
             delete s;
       foreach(Preset* p, presets)
@@ -67,6 +77,23 @@ SFont::~SFont()
 //                  delete z;
             delete i;
             }
+      if (sampleMap)
+            mapFile.unmap(sampleMap);
+      if (cacheMap)
+            cacheFile.unmap(cacheMap);
+      }
+
+//---------------------------------------------------------
+//   setSampleCacheDir
+//    directory for decoded sf3 samples; an empty string
+//    switches the cache off
+//---------------------------------------------------------
+
+void SFont::setSampleCacheDir(const QString& s)
+      {
+      _sampleCacheDir = s;
+      if (!s.isEmpty())
+            QDir().mkpath(s);
       }
 
 //---------------------------------------------------------
@@ -78,6 +105,8 @@ bool SFont::read(const QString& s)
       f.setFileName(s);
       if (!load())
             return false;
+      if (_mapSamples)
+            mapSampleData();
 
       foreach(Instrument* i, instruments) {
             if (!i->import_sfont())
@@ -91,6 +120,32 @@ bool SFont::read(const QString& s)
       return true;
       }
 
+//---------------------------------------------------------
+//   mapSampleData
+//    Map the sample chunk into memory. Sample::load() then
+//    points the sample data into the mapping instead of
+//    reading a copy; processes playing the same soundfont
+//    share the pages. The 16 bit samples are little endian,
+//    so uncompressed samples can only be used in place on
+//    little endian hosts; compressed (sf3) samples are
+//    decoded from the mapping on every host.
+//---------------------------------------------------------
+
+bool SFont::mapSampleData()
+      {
+      if (samplesize == 0)
+            return false;
+      mapFile.setFileName(f.fileName());
+      if (!mapFile.open(QIODevice::ReadOnly))
+            return false;
+      sampleMap = mapFile.map(samplepos, samplesize);
+      if (sampleMap == 0) {
+            mapFile.close();
+            return false;
+            }
+      return true;
+      }
+
 //---------------------------------------------------------
 //   get_preset
 //---------------------------------------------------------
@@ -127,31 +182,54 @@ Preset::~Preset()
             delete z;
       }
 
+//---------------------------------------------------------
+//   loadSample
+//    called from QtConcurrent worker threads
+//---------------------------------------------------------
+
+static void loadSample(Sample* s)
+      {
+      s->load();
+      }
+
 //---------------------------------------------------------
 //   loadSamples
-//    this is called if the preset is associated with a
-//    channel
+//    this is called by the sample loader thread if the
+//    preset is associated with a channel or prefetched
 //---------------------------------------------------------
 
 void Preset::loadSamples()
       {
-//      sfont->synth->mutex.lock();
+      QSet<Sample*> samples;
       if (_global_zone && _global_zone->instrument) {
             Instrument* i = _global_zone->instrument;
             if (i->global_zone && i->global_zone->sample)
-                  i->global_zone->sample->load();
+                  samples.insert(i->global_zone->sample);
             foreach(Zone* iz, i->zones)
-                  iz->sample->load();
+                  samples.insert(iz->sample);
             }
 
       foreach(Zone* z, zones) {
             Instrument* i = z->instrument;
             if (i->global_zone && i->global_zone->sample)
-                  i->global_zone->sample->load();
+                  samples.insert(i->global_zone->sample);
             foreach(Zone* iz, i->zones)
-                  iz->sample->load();
+                  samples.insert(iz->sample);
             }
-//      sfont->synth->mutex.unlock();
+      samples.remove(0);
+#ifdef SOUNDFONT3
+      // compressed samples are decoded in parallel; every
+      // sample is loaded by exactly one thread; a missing
+      // sample cache is written only after the samples of
+      // this preset are loaded
+      sfont->prepareSampleCache();
+      QList<Sample*> sl = samples.toList();
+      QtConcurrent::blockingMap(sl, loadSample);
+      sfont->startSampleCache();
+#else
+      foreach(Sample* s, samples)
+            loadSample(s);
+#endif
       }
 
 //---------------------------------------------------------
@@ -180,6 +258,10 @@ bool Preset::noteon(Fluid* synth, unsigned id, int chan, int key, int vel, doubl
                         Sample* sample = inst_zone->get_sample();
                         if (sample == 0 || sample->inRom())
                               continue;
+                        /* the samples are loaded in the background; skip
+                           the zone until they are available */
+                        if (!sample->ready())
+                              continue;
                         /* check if the note falls into the key and velocity range of this
                            instrument */
                         if (inst_zone->inside_range(key, vel) && (sample != 0)) {
@@ -575,6 +657,7 @@ Sample::Sample(SFont* s)
       {
       sf          = s;
       _valid      = false;
+      _mapped     = false;
       start       = 0;
       end         = 0;
       loopstart   = 0;
@@ -594,7 +677,8 @@ Sample::Sample(SFont* s)
 
 Sample::~Sample()
       {
-      delete[] data;
+      if (!_mapped)
+            delete[] data;
       }
 
 //---------------------------------------------------------
@@ -605,6 +689,27 @@ void Sample::load()
       {
       if (!_valid || data)
             return;
+      bool cached = false;
+#ifdef SOUNDFONT3
+      if (sampletype & FLUID_SAMPLETYPE_OGG_VORBIS)
+            cached = loadCached();
+#endif
+      if (!cached) {
+            if (sf->sampleData())
+                  loadMapped();
+            else
+                  loadFile();
+            }
+      if (data && _valid)
+            _ready.fetchAndStoreRelease(1);
+      }
+
+//---------------------------------------------------------
+//   loadFile
+//---------------------------------------------------------
+
+void Sample::loadFile()
+      {
       QFile fd(sf->get_name());
       if (!fd.open(QIODevice::ReadOnly))
             return;
@@ -656,6 +761,47 @@ void Sample::load()
       optimize();
       }
 
+//---------------------------------------------------------
+//   loadMapped
+//    same as load() for a soundfont with mapped sample
+//    data; uncompressed samples are not copied on little
+//    endian hosts
+//---------------------------------------------------------
+
+void Sample::loadMapped()
+      {
+      const uchar* p = sf->sampleData();
+      unsigned size  = sf->getSamplesize();
+
+      if (sampletype & FLUID_SAMPLETYPE_OGG_VORBIS) {
+#ifdef SOUNDFONT3
+            if (start > end || end > size)
+                  return;
+            decompressOggVorbis((const char*)p + start, end - start);
+#endif
+            }
+      else {
+            if (start > end || end > size / sizeof(short))
+                  return;
+            unsigned n = end - start;
+            if (QSysInfo::ByteOrder == QSysInfo::LittleEndian) {
+                  data    = (short*)(p + start * sizeof(short));
+                  _mapped = true;
+                  }
+            else {
+                  data = new short[n];
+                  p   += start * sizeof(short);
+                  for (unsigned i = 0; i < n; ++i, p += 2)
+                        data[i] = short(p[0] | (p[1] << 8));
+                  }
+            end       -= (start + 1);       // marks last sample, contrary to SF spec.
+            loopstart -= start;
+            loopend   -= start;
+            start      = 0;
+            }
+      optimize();
+      }
+
 //---------------------------------------------------------
 //   inRom
 //---------------------------------------------------------
@@ -31,6 +31,7 @@ namespace FluidS {
 class Preset;
 class Sample;
 class Instrument;
+class SampleCacheBuilder;
 struct SFGen;
 struct SFMod;
 
@@ -50,10 +51,22 @@ struct SFVersion {            // version structure
 //---------------------------------------------------------
 
 class SFont {
+      static bool _mapSamples;
+      static QString _sampleCacheDir;
+
       Fluid* synth;
       QFile f;
       unsigned samplepos;           // the position in the file at which the sample data starts
       unsigned samplesize;          // the size of the sample data
+      QFile mapFile;                // stays open as long as the sample data is mapped
+      uchar* sampleMap;             // the mapped sample data or 0
+      QFile cacheFile;              // decoded sf3 samples, see sfont3.cpp
+      uchar* cacheMap;              // the mapped cache file or 0
+      enum { CACHE_NONE, CACHE_BUILD, CACHE_BUILDING, CACHE_DONE };
+      int cacheState;               // see prepareSampleCache()
+      QString cachePath;
+      SampleCacheBuilder* cacheBuilder;   // writes the cache in the background
+      QVector<Sample*> cacheSamples;      // unloaded copies of the samples to cache
 
       QList<Instrument*> instruments;
       QList<Preset*> presets;
@@ -96,6 +109,14 @@ class SFont {
       void safe_fread(void *buf, int count);
       void safe_fseek(long ofs);
       bool load();
+      bool mapSampleData();
+#ifdef SOUNDFONT3
+      QString sampleCachePath() const;
+      bool openSampleCache(const QString& path);
+      bool buildSampleCache(const QString& path, QAtomicInt& abort);
+      void stopSampleCache();
+      friend class SampleCacheBuilder;
+#endif
 
    public:
       SFont(Fluid* f);
@@ -113,6 +134,17 @@ class SFont {
       void setSamplepos(unsigned v)             { samplepos = v; }
       void setSamplesize(unsigned v)            { samplesize = v; }
       unsigned getSamplesize() const            { return samplesize; }
+      const uchar* sampleData() const           { return sampleMap;  }
+      static void setMapSamples(bool val)       { _mapSamples = val; }
+      static bool mapSamples()                  { return _mapSamples; }
+      static void setSampleCacheDir(const QString& s);
+      static QString sampleCacheDir()           { return _sampleCacheDir; }
+#ifdef SOUNDFONT3
+      void prepareSampleCache();
+      void startSampleCache();
+      const uchar* sampleCache() const          { return cacheMap; }
+      int sampleIndex(const Sample* s) const    { return sample.indexOf(const_cast<Sample*>(s)); }
+#endif
       const QList<Preset*> getPresets() const   { return presets; }
       SFVersion version() const                 { return _version; }
       friend class Preset;
@@ -124,6 +156,14 @@ class SFont {
 
 class Sample {
       bool _valid;
+      bool _mapped;                 // data points into the mapped sample chunk
+      mutable QAtomicInt _ready;    // data is loaded; set by the sample loader
+
+      void loadFile();
+      void loadMapped();
+#ifdef SOUNDFONT3
+      bool loadCached();
+#endif
 
    public:
       SFont* sf;
@@ -152,10 +192,11 @@ class Sample {
       bool inRom() const;
       void optimize();
       void load();
+      bool ready() const    { return _ready.fetchAndAddAcquire(0); }
       bool valid() const    { return _valid; }
       void setValid(bool v) { _valid = v; }
 #ifdef SOUNDFONT3
-      bool decompressOggVorbis(char* p, int size);
+      bool decompressOggVorbis(const char* p, int size);
 #endif
       };
 
@@ -218,6 +259,7 @@ class Preset {
 
       Zone* _global_zone;           // the global zone of the preset
       QList<Zone*> zones;
+      QAtomicInt _loadRequested;    // handed to the sample loader
 
    public:
       Preset(SFont* sfont);
@@ -233,6 +275,8 @@ class Preset {
 
       Zone* global_zone()                       { return _global_zone; }
       void loadSamples();
+      bool requestLoad()                        { return _loadRequested.testAndSetOrdered(0, 1); }
+      void cancelLoad()                         { _loadRequested.fetchAndStoreOrdered(0); }
       QList<Zone*> getZones()                   { return zones; }
       };
 
@@ -2,6 +2,11 @@
 #include <stdlib.h>
 #include <math.h>
 #include <vorbis/codec.h>
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDateTime>
+#include <QtCore/QFileInfo>
+#include <QtCore/QTemporaryFile>
+#include <QtCore/QThread>
 #include "sfont.h"
 
 namespace FluidS {
@@ -10,11 +15,12 @@ namespace FluidS {
 //   decompressOggVorbis
 //---------------------------------------------------------
 
-bool Sample::decompressOggVorbis(char* src, int size)
+bool Sample::decompressOggVorbis(const char* src, int size)
       {
 #define MAX_OUT   1024*500
-      short odata[MAX_OUT];
-      short* oPtr = odata;
+      QVector<short> obuf(MAX_OUT);       // too large for the stack of pool threads
+      short* odata = obuf.data();
+      short* oPtr  = odata;
 
       ogg_sync_state   oy; // sync and verify incoming physical bitstream
       ogg_stream_state os; // take physical pages, weld into a logical stream of packets
@@ -213,4 +219,305 @@ bool Sample::decompressOggVorbis(char* src, int size)
 // printf("  vorbis sample 0-%d %d %d\n", end, loopstart, loopend);
       return true;
       }
+
+//---------------------------------------------------------
+//   sample cache
+//    The decoded samples of a sf3 soundfont are kept in
+//    one file per soundfont, named after the md5 sum of the
+//    path, size and modification time of the soundfont file.
+//    The file is mapped on later runs; each sample is
+//    verified by its checksum when it is first loaded. The
+//    cache is written in host byte order and is only used
+//    on little endian hosts.
+//---------------------------------------------------------
+
+static const char CACHE_MAGIC[4] = { 'M', 'S', 'C', '3' };
+static const quint32 CACHE_VERSION = 1;
+
+struct SampleCacheHeader {
+      char magic[4];
+      quint32 version;
+      quint32 samples;
+      quint32 reserved;
+      };
+
+struct SampleCacheEntry {
+      quint64 offset;         // 0 if the sample is not cached
+      quint32 frames;
+      quint32 loopstart;
+      quint32 loopend;
+      quint32 checksum;
+      quint32 reserved[2];
+      };
+
+//---------------------------------------------------------
+//   checksum
+//    FNV-1a over the sample words
+//---------------------------------------------------------
+
+static quint32 checksum(const short* data, unsigned n)
+      {
+      quint32 h = 2166136261u;
+      for (unsigned i = 0; i < n; ++i) {
+            h ^= quint16(data[i]);
+            h *= 16777619u;
+            }
+      return h;
+      }
+
+//---------------------------------------------------------
+//   loadCached
+//    returns false if the sample is not in the cache or
+//    the cached data is damaged
+//---------------------------------------------------------
+
+bool Sample::loadCached()
+      {
+      const uchar* p = sf->sampleCache();
+      if (p == 0)
+            return false;
+      const SampleCacheHeader* h = (const SampleCacheHeader*)p;
+      int idx = sf->sampleIndex(this);
+      if (idx < 0 || idx >= int(h->samples))
+            return false;
+      const SampleCacheEntry* e = (const SampleCacheEntry*)(p + sizeof(SampleCacheHeader)) + idx;
+      if (e->offset == 0)
+            return false;
+      const short* d = (const short*)(p + e->offset);
+      if (checksum(d, e->frames) != e->checksum) {
+            qDebug("sample cache: checksum error in sample %d", idx);
+            return false;
+            }
+      data      = const_cast<short*>(d);
+      _mapped   = true;
+      start     = 0;
+      end       = e->frames - 1;
+      loopstart = e->loopstart;
+      loopend   = e->loopend;
+      optimize();
+      return true;
+      }
+
+//---------------------------------------------------------
+//   sampleCachePath
+//---------------------------------------------------------
+
+QString SFont::sampleCachePath() const
+      {
+      QFileInfo fi(f.fileName());
+      if (!fi.exists())
+            return QString();
+      QCryptographicHash h(QCryptographicHash::Md5);
+      h.addData(fi.absoluteFilePath().toUtf8());
+      h.addData(QByteArray::number(fi.size()));
+      h.addData(fi.lastModified().toString(Qt::ISODate).toUtf8());
+      return _sampleCacheDir + "/" + h.result().toHex() + ".pcm";
+      }
+
+//---------------------------------------------------------
+//   openSampleCache
+//---------------------------------------------------------
+
+bool SFont::openSampleCache(const QString& path)
+      {
+      cacheFile.setFileName(path);
+      if (!cacheFile.open(QIODevice::ReadOnly))
+            return false;
+      qint64 size  = cacheFile.size();
+      qint64 table = sizeof(SampleCacheHeader) + sample.size() * sizeof(SampleCacheEntry);
+      if (size >= table)
+            cacheMap = cacheFile.map(0, size);
+      if (cacheMap == 0) {
+            cacheFile.close();
+            return false;
+            }
+      const SampleCacheHeader* h = (const SampleCacheHeader*)cacheMap;
+      bool ok = memcmp(h->magic, CACHE_MAGIC, 4) == 0
+         && h->version == CACHE_VERSION
+         && h->samples == unsigned(sample.size());
+      const SampleCacheEntry* e = (const SampleCacheEntry*)(cacheMap + sizeof(SampleCacheHeader));
+      for (int i = 0; ok && i < sample.size(); ++i, ++e) {
+            if (e->offset && (e->offset < quint64(table) || e->frames == 0
+               || e->offset + quint64(e->frames) * sizeof(short) > quint64(size)))
+                  ok = false;
+            }
+      if (!ok) {
+            qDebug("sample cache <%s> is invalid", qPrintable(path));
+            cacheFile.unmap(cacheMap);
+            cacheMap = 0;
+            cacheFile.close();
+            }
+      return ok;
+      }
+
+//---------------------------------------------------------
+//   SampleCacheBuilder
+//    writes the sample cache of a soundfont at low priority,
+//    so it does not compete with the sample loader
+//---------------------------------------------------------
+
+class SampleCacheBuilder : public QThread {
+      SFont* sf;
+      QString path;
+
+   public:
+      QAtomicInt abort;
+      bool ok;
+
+      SampleCacheBuilder(SFont* s, const QString& p) : sf(s), path(p), ok(false) {}
+      virtual void run() { ok = sf->buildSampleCache(path, abort); }
+      };
+
+//---------------------------------------------------------
+//   buildSampleCache
+//    decode the copies in cacheSamples one by one and write
+//    them to a new cache file; called in the
+//    SampleCacheBuilder thread
+//---------------------------------------------------------
+
+bool SFont::buildSampleCache(const QString& path, QAtomicInt& abort)
+      {
+      QTemporaryFile tf(_sampleCacheDir + "/XXXXXX.tmp");
+      if (!tf.open())
+            return false;
+      QVector<SampleCacheEntry> entries(cacheSamples.size());
+      memset(entries.data(), 0, entries.size() * sizeof(SampleCacheEntry));
+      SampleCacheHeader h;
+      memcpy(h.magic, CACHE_MAGIC, 4);
+      h.version  = CACHE_VERSION;
+      h.samples  = cacheSamples.size();
+      h.reserved = 0;
+      qint64 tableSize = entries.size() * sizeof(SampleCacheEntry);
+      bool ok = tf.write((const char*)&h, sizeof(h)) == sizeof(h)
+         && tf.write((const char*)entries.data(), tableSize) == tableSize;
+
+      for (int i = 0; ok && i < cacheSamples.size(); ++i) {
+            if (abort.fetchAndAddRelaxed(0))
+                  return false;
+            Sample* d = cacheSamples[i];
+            if (d == 0)
+                  continue;
+            d->load();
+            if (d->valid() && d->data) {
+                  qint64 pos = (tf.pos() + 15) & ~qint64(15);
+                  unsigned n = d->end + 1;
+                  qint64 len = n * sizeof(short);
+                  ok = tf.seek(pos) && tf.write((const char*)d->data, len) == len;
+                  SampleCacheEntry& e = entries[i];
+                  e.offset    = pos;
+                  e.frames    = n;
+                  e.loopstart = d->loopstart;
+                  e.loopend   = d->loopend;
+                  e.checksum  = checksum(d->data, n);
+                  }
+            cacheSamples[i] = 0;
+            delete d;
+            }
+      ok = ok && tf.seek(sizeof(h)) && tf.write((const char*)entries.data(), tableSize) == tableSize;
+      if (!ok) {
+            qDebug("cannot write sample cache <%s>", qPrintable(path));
+            return false;
+            }
+      tf.setAutoRemove(false);
+      tf.close();
+      QFile::remove(path);
+      if (!QFile::rename(tf.fileName(), path)) {
+            QFile::remove(tf.fileName());
+            return false;
+            }
+      return true;
+      }
+
+//---------------------------------------------------------
+//   prepareSampleCache
+//    open the sample cache; called by the sample loader
+//    before the samples of a preset are loaded
+//
+//    If there is no cache, unloaded copies of the compressed
+//    samples are taken here and written to a new cache by
+//    startSampleCache() after the preset is loaded. The new
+//    cache is opened once it is complete.
+//---------------------------------------------------------
+
+void SFont::prepareSampleCache()
+      {
+      if (cacheState == CACHE_BUILDING) {
+            if (!cacheBuilder->isFinished())
+                  return;
+            if (cacheBuilder->ok)
+                  openSampleCache(cachePath);
+            delete cacheBuilder;
+            cacheBuilder = 0;
+            cacheState   = CACHE_DONE;
+            return;
+            }
+      if (cacheState != CACHE_NONE)
+            return;
+      cacheState = CACHE_DONE;
+      if (_sampleCacheDir.isEmpty() || QSysInfo::ByteOrder != QSysInfo::LittleEndian)
+            return;
+      bool compressed = false;
+      foreach(Sample* s, sample) {
+            if (s->sampletype & FLUID_SAMPLETYPE_OGG_VORBIS) {
+                  compressed = true;
+                  break;
+                  }
+            }
+      if (!compressed)
+            return;
+      cachePath = sampleCachePath();
+      if (cachePath.isEmpty() || openSampleCache(cachePath))
+            return;
+
+      // copy the sample parameters before loading changes them
+      cacheSamples.fill(0, sample.size());
+      for (int i = 0; i < sample.size(); ++i) {
+            Sample* s = sample[i];
+            if (!s->valid() || !(s->sampletype & FLUID_SAMPLETYPE_OGG_VORBIS))
+                  continue;
+            Sample* d     = new Sample(this);
+            d->start      = s->start;
+            d->end        = s->end;
+            d->loopstart  = s->loopstart;
+            d->loopend    = s->loopend;
+            d->sampletype = s->sampletype;
+            d->setValid(true);
+            cacheSamples[i] = d;
+            }
+      cacheState = CACHE_BUILD;
+      }
+
+//---------------------------------------------------------
+//   startSampleCache
+//    start writing the cache prepared by
+//    prepareSampleCache(); called by the sample loader
+//    after the samples of a preset are loaded
+//---------------------------------------------------------
+
+void SFont::startSampleCache()
+      {
+      if (cacheState != CACHE_BUILD)
+            return;
+      cacheState   = CACHE_BUILDING;
+      cacheBuilder = new SampleCacheBuilder(this, cachePath);
+      cacheBuilder->start(QThread::LowestPriority);
+      }
+
+//---------------------------------------------------------
+//   stopSampleCache
+//    abort a running cache build
+//---------------------------------------------------------
+
+void SFont::stopSampleCache()
+      {
+      if (cacheBuilder) {
+            cacheBuilder->abort.fetchAndStoreRelaxed(1);
+            cacheBuilder->wait();
+            delete cacheBuilder;
+            cacheBuilder = 0;
+            }
+      foreach(Sample* d, cacheSamples)
+            delete d;
+      cacheSamples.clear();
+      }
 } // namespace
@@ -64,6 +64,10 @@ Voice::Voice(Fluid* f)
       channel = 0;
       sample  = 0;
 
+      queueIndex   = -1;
+      queuePrio    = 0.0;
+      queueSection = 0;
+
       /* The 'sustain' and 'finished' segments of the volume / modulation
        * envelope are constant. They are never affected by any modulator
        * or generator. Therefore it is enough to initialize them once
@@ -1284,6 +1288,7 @@ void Voice::noteoff()
             modenv_section = FLUID_VOICE_ENVRELEASE;
             modenv_count = 0;
             }
+      _fluid->updateStealQueue(this);
       }
 
 /*
@@ -1324,6 +1329,70 @@ void Voice::kill_excl()
       /* Speed up the modulation envelope */
       gen_set(GEN_MODENVRELEASE, -200);
       update_param(GEN_MODENVRELEASE);
+
+      _fluid->updateStealQueue(this);
+      }
+
+//---------------------------------------------------------
+//   stealPriority
+//    Determine, how 'important' a voice is; the voice with
+//    the lowest priority is killed if a new voice is needed
+//    and the polyphony is exhausted.
+//    This is the rating fluid_synth_free_voice_by_kill()
+//    computed for every voice on each allocation. Here it is
+//    only evaluated when the voice is queued and when its
+//    release state or volume envelope section changes, so
+//    the loudness is the one at the start of the current
+//    envelope section.
+//---------------------------------------------------------
+
+double Voice::stealPriority() const
+      {
+      /* Start with an arbitrary number */
+      double prio = 10000.;
+
+      /* Is this voice on the drum channel?
+       * Then it is very important.
+       * Also, forget about the released-note condition:
+       * Typically, drum notes are triggered only very briefly, they run most
+       * of the time in release phase.
+       */
+      if (chan == 9)
+            prio += 4000;
+      else if (RELEASED()) {
+            /* The key for this voice has been released. Consider it much less important
+             * than a voice, which is still held.
+             */
+            prio -= 2000.;
+            }
+
+      /* The sustain pedal is held down on this channel.
+       * Consider it less important than non-sustained channels.
+       */
+      if (SUSTAINED())
+            prio -= 1000;
+
+      /* An older voice is just a little bit less important than a younger voice.
+       * The original rating subtracts the age (noteid - id); as noteid
+       * is the same for all voices, adding the id gives the same order.
+       */
+      prio += id;
+
+      /* take a rough estimate of loudness into account. Louder voices are more important. */
+      if (volenv_section != FLUID_VOICE_ENVATTACK)
+            prio += volenv_val * 1000.;
+      return prio;
+      }
+
+//---------------------------------------------------------
+//   updateStealPriority
+//    called by VoiceQueue
+//---------------------------------------------------------
+
+void Voice::updateStealPriority()
+      {
+      queuePrio    = stealPriority();
+      queueSection = volenv_section;
       }
 
 //---------------------------------------------------------
@@ -23,6 +23,7 @@
 
 #include "fluid.h"
 #include "gen.h"
+#include "dspsimd.h"
 
 namespace FluidS {
 
@@ -66,6 +67,7 @@ class Voice
       static float interp_coeff_linear[FLUID_INTERP_MAX][2];
       static float interp_coeff[FLUID_INTERP_MAX][4];
       static float sinc_table7[FLUID_INTERP_MAX][7];
+      static const DspKernels* dspKernels;
 
       Fluid* _fluid;
       double _noteTuning;             // +/- in midicent
@@ -187,6 +189,11 @@ class Voice
 	int debug;
 	double ref;
 
+	/* voice stealing, see VoiceQueue */
+	int queueIndex;           /* position in Fluid::stealQueue, -1 if not queued */
+	double queuePrio;         /* steal priority when last queued */
+	int queueSection;         /* volenv_section when last queued */
+
    public:
       Voice(Fluid*);
       Channel* get_channel() const    { return channel; }
@@ -215,6 +222,8 @@ class Voice
       void check_sample_sanity();
       void noteoff();
       void kill_excl();
+      double stealPriority() const;
+      void updateStealPriority();
       int calculate_hold_decay_frames(int gen_base, int gen_key2base, int is_decay);
 
       /* A voice is 'ON', if it has not yet received a noteoff
@@ -231,6 +240,9 @@ class Voice
       void add_mod(const Mod* mod, int mode);
 
       static void dsp_float_config();
+      static bool setDspKernels(DspKernelType);
+      static DspKernelType dspKernelType() { return dspKernels->type; }
+      static const char* dspKernelName()   { return dspKernels->name; }
       int dsp_float_interpolate_none(unsigned);
       int dsp_float_interpolate_linear(unsigned);
       int dsp_float_interpolate_4th_order(unsigned);
@@ -0,0 +1,145 @@
+/* FluidSynth - A Software Synthesizer
+ *
+ * Copyright (C) 2003  Peter Hanappe and others.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public License
+ * as published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ * 02111-1307, USA
+ */
+
+#include "voicequeue.h"
+#include "voice.h"
+
+namespace FluidS {
+
+//---------------------------------------------------------
+//   less
+//---------------------------------------------------------
+
+bool VoiceQueue::less(int a, int b) const
+      {
+      return heap[a]->queuePrio < heap[b]->queuePrio;
+      }
+
+//---------------------------------------------------------
+//   swap
+//---------------------------------------------------------
+
+void VoiceQueue::swap(int a, int b)
+      {
+      Voice* v = heap[a];
+      heap[a]  = heap[b];
+      heap[b]  = v;
+      heap[a]->queueIndex = a;
+      heap[b]->queueIndex = b;
+      }
+
+//---------------------------------------------------------
+//   up
+//---------------------------------------------------------
+
+void VoiceQueue::up(int i)
+      {
+      while (i > 0) {
+            int parent = (i - 1) / 2;
+            if (!less(i, parent))
+                  break;
+            swap(i, parent);
+            i = parent;
+            }
+      }
+
+//---------------------------------------------------------
+//   down
+//---------------------------------------------------------
+
+void VoiceQueue::down(int i)
+      {
+      int n = heap.size();
+      for (;;) {
+            int child = 2 * i + 1;
+            if (child >= n)
+                  break;
+            if (child + 1 < n && less(child + 1, child))
+                  ++child;
+            if (!less(child, i))
+                  break;
+            swap(i, child);
+            i = child;
+            }
+      }
+
+//---------------------------------------------------------
+//   insert
+//---------------------------------------------------------
+
+void VoiceQueue::insert(Voice* v)
+      {
+      if (v->queueIndex >= 0) {
+            update(v);
+            return;
+            }
+      v->updateStealPriority();
+      v->queueIndex = heap.size();
+      heap.append(v);
+      up(v->queueIndex);
+      }
+
+//---------------------------------------------------------
+//   remove
+//---------------------------------------------------------
+
+void VoiceQueue::remove(Voice* v)
+      {
+      int i = v->queueIndex;
+      if (i < 0)
+            return;
+      int last = heap.size() - 1;
+      if (i != last)
+            swap(i, last);
+      heap.removeLast();
+      v->queueIndex = -1;
+      if (i != last) {
+            up(i);
+            down(i);
+            }
+      }
+
+//---------------------------------------------------------
+//   update
+//    recompute the priority of v and restore the heap
+//---------------------------------------------------------
+
+void VoiceQueue::update(Voice* v)
+      {
+      int i = v->queueIndex;
+      if (i < 0)
+            return;
+      v->updateStealPriority();
+      up(i);
+      down(v->queueIndex);
+      }
+
+//---------------------------------------------------------
+//   clear
+//---------------------------------------------------------
+
+void VoiceQueue::clear()
+      {
+      foreach(Voice* v, heap)
+            v->queueIndex = -1;
+      heap.clear();
+      }
+
+}
@@ -0,0 +1,56 @@
+/* FluidSynth - A Software Synthesizer
+ *
+ * Copyright (C) 2003  Peter Hanappe and others.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public License
+ * as published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ * 02111-1307, USA
+ */
+
+#ifndef _FLUID_VOICEQUEUE_H
+#define _FLUID_VOICEQUEUE_H
+
+namespace FluidS {
+
+class Voice;
+
+//---------------------------------------------------------
+//   VoiceQueue
+//    Binary min-heap of the active voices ordered by their
+//    steal priority (Voice::stealPriority()). The voice with
+//    the lowest priority is the next one to be stolen.
+//    Every voice knows its own heap position, so insert,
+//    remove and update are O(log n).
+//---------------------------------------------------------
+
+class VoiceQueue {
+      QVector<Voice*> heap;
+
+      bool less(int a, int b) const;
+      void swap(int a, int b);
+      void up(int i);
+      void down(int i);
+
+   public:
+      void insert(Voice*);
+      void remove(Voice*);
+      void update(Voice*);
+      void clear();
+      Voice* top() const     { return heap.isEmpty() ? 0 : heap[0]; }
+      int size() const       { return heap.size(); }
+      bool isEmpty() const   { return heap.isEmpty(); }
+      };
+
+}
+#endif
@@ -358,3 +358,121 @@ QString midiMetaName(int meta)
             }
       return QString(s);
       }
+
+//---------------------------------------------------------
+//   ChannelEvent
+//---------------------------------------------------------
+
+ChannelEvent::ChannelEvent(const Event& e)
+      {
+      _tick    = e.ontime();
+      _type    = e.type();
+      _channel = e.channel();
+      _a       = e.dataA();
+      _b       = e.dataB();
+      _tuning  = e.tuning();
+      _note    = e.note();
+      }
+
+//---------------------------------------------------------
+//   toEvent
+//---------------------------------------------------------
+
+Event ChannelEvent::toEvent() const
+      {
+      Event e(_type);
+      e.setOntime(_tick);
+      e.setChannel(_channel);
+      e.setDataA(_a);
+      e.setDataB(_b);
+      e.setTuning(_tuning);
+      e.setNote(_note);
+      return e;
+      }
+
+//---------------------------------------------------------
+//   isChannelEvent
+//---------------------------------------------------------
+
+bool ChannelEvent::isChannelEvent() const
+      {
+      switch(_type) {
+            case ME_NOTEOFF:
+            case ME_NOTEON:
+            case ME_POLYAFTER:
+            case ME_CONTROLLER:
+            case ME_PROGRAM:
+            case ME_AFTERTOUCH:
+            case ME_PITCHBEND:
+                  return true;
+            default:
+                  return false;
+            }
+      }
+
+//---------------------------------------------------------
+//   add
+//    add an event at tick; events with payload (sysex,
+//    meta, notes with length) are dropped
+//---------------------------------------------------------
+
+void ChannelEventList::add(int tick, const Event& e)
+      {
+      // the sequencer and midi export play channel events only
+      if (e.len() || e.type() == ME_SYSEX || e.type() == ME_META)
+            return;
+      ChannelEvent ce(e);
+      ce.setTick(tick);
+      QVector<ChannelEvent>::append(ce);
+      }
+
+//---------------------------------------------------------
+//   append
+//    append all events of l shifted by tickOffset
+//---------------------------------------------------------
+
+void ChannelEventList::append(const ChannelEventList& l, int tickOffset)
+      {
+      int n = size();
+      QVector<ChannelEvent>::operator+=(l);
+      ChannelEvent* e = data() + n;
+      for (int i = 0; i < l.size(); ++i)
+            e[i]._tick += tickOffset;
+      }
+
+//---------------------------------------------------------
+//   sort
+//    events with the same tick keep their order
+//---------------------------------------------------------
+
+static bool tickLessThan(const ChannelEvent& a, const ChannelEvent& b)
+      {
+      return a._tick < b._tick;
+      }
+
+void ChannelEventList::sort()
+      {
+      qStableSort(begin(), end(), tickLessThan);
+      }
+
+//---------------------------------------------------------
+//   lowerBound
+//    index of first event with tick >= tick
+//---------------------------------------------------------
+
+int ChannelEventList::lowerBound(int tick) const
+      {
+      int idx = 0;
+      int n   = size();
+      const ChannelEvent* e = constData();
+      while (n > 0) {
+            int half = n / 2;
+            if (e[idx + half]._tick < tick) {
+                  idx += half + 1;
+                  n   -= half + 1;
+                  }
+            else
+                  n = half;
+            }
+      return idx;
+      }
@@ -15,6 +15,8 @@
 #define __EVENT_H__
 
 class Note;
+class Measure;
+class Part;
 // class MidiFile;
 class Xml;
 
@@ -201,6 +203,78 @@ class EventList : public QList<Event> {
 
 class EventMap : public QMap<int, Event> {};
 
+//---------------------------------------------------------
+//   ChannelEvent
+//    compact, fixed size event for playback: note on/off,
+//    controller, program and metronome ticks; no heap data
+//---------------------------------------------------------
+
+struct ChannelEvent {
+      int _tick;
+      ushort _type;
+      ushort _channel;        // scores with many parts use more than 256 channels
+      int _a;                 // controller numbers exceed 16 bit (CTRL_PROGRAM...)
+      short _b;
+      float _tuning;
+      const Note* _note;
+
+      ChannelEvent() : _tick(0), _type(ME_INVALID), _channel(0), _a(0), _b(0), _tuning(0.0), _note(0) {}
+      ChannelEvent(int tick, int type, int channel = 0, int a = 0, int b = 0)
+         : _tick(tick), _type(type), _channel(channel), _a(a), _b(b), _tuning(0.0), _note(0) {}
+      ChannelEvent(const Event&);
+      Event toEvent() const;
+
+      int tick() const              { return _tick;     }
+      void setTick(int v)           { _tick = v;        }
+      int type() const              { return _type;     }
+      int channel() const           { return _channel;  }
+      void setChannel(int c)        { _channel = c;     }
+      int dataA() const             { return _a;        }
+      int dataB() const             { return _b;        }
+      int pitch() const             { return _a;        }
+      int velo() const              { return _b;        }
+      void setVelo(int v)           { _b = v;           }
+      int controller() const        { return _a;        }
+      int value() const             { return _b;        }
+      qreal tuning() const          { return _tuning;   }
+      void setTuning(qreal v)       { _tuning = v;      }
+      const Note* note() const      { return _note;     }
+      void setNote(const Note* n)   { _note = n;        }
+      bool isChannelEvent() const;
+      };
+
+Q_DECLARE_TYPEINFO(ChannelEvent, Q_PRIMITIVE_TYPE);
+
+//---------------------------------------------------------
+//   ChannelEventList
+//    playlist of ChannelEvents sorted by tick
+//---------------------------------------------------------
+
+class ChannelEventList : public QVector<ChannelEvent> {
+   public:
+      void add(int tick, const Event&);
+      void add(const ChannelEvent& e)   { QVector<ChannelEvent>::append(e); }
+      void append(const ChannelEventList&, int tickOffset);
+      void sort();
+      int lowerBound(int tick) const;
+      };
+
+//---------------------------------------------------------
+//   MeasureEvents
+//    rendered events of one part in one measure; tick and
+//    ticks are those of the measure when it was rendered
+//---------------------------------------------------------
+
+struct MeasureEvents {
+      int tick;
+      int ticks;
+      int generation;         // render pass which used the events last, -1: not rendered
+      ChannelEventList events;
+      MeasureEvents() : tick(0), ticks(0), generation(-1) {}
+      };
+
+class MeasureEventCache : public QHash<QPair<const Measure*, const Part*>, MeasureEvents> {};
+
 typedef EventList::iterator iEvent;
 typedef EventList::const_iterator ciEvent;
 
@@ -264,23 +264,22 @@ bool ExportMidi::write(const QString& name, bool midiExpandRepeats)
                   }
 
 
-            EventMap events;
+            ChannelEventList events;
             cs->renderPart(&events, part);
 
-            for (EventMap::const_iterator i = events.begin(); i != events.end(); ++i) {
-                  Event event = i.value();
+            foreach (const ChannelEvent& event, events) {
                   if (event.channel() != channel)
                         continue;
                   if (event.type() == ME_NOTEON) {
                         Event ne(ME_NOTEON);
-                        ne.setOntime(i.key());
+                        ne.setOntime(event.tick());
                         ne.setChannel(event.channel());
                         ne.setPitch(event.pitch());
                         ne.setVelo(event.velo());
                         track->insert(ne);
                         }
                   else if (event.type() == ME_CONTROLLER) {
-                        track->addCtrl(i.key(), event.channel(), event.controller(), event.value());
+                        track->addCtrl(event.tick(), event.channel(), event.controller(), event.value());
                         }
                   else {
                         qDebug("writeMidi: unknown midi event 0x%02x\n", event.type());
@@ -15,34 +15,38 @@
 
 //---------------------------------------------------------
 //   clear
+//    not thread safe; call only if reader and writer
+//    are idle
 //---------------------------------------------------------
 
 void FifoBase::clear()
-	{
-	ridx    = 0;
+      {
+      ridx    = 0;
       widx    = 0;
-      counter = 0;
+      counter.fetchAndStoreOrdered(0);
       }
 
 //---------------------------------------------------------
 //   push
+//    called by the writer after the object at widx is
+//    stored
 //---------------------------------------------------------
 
 void FifoBase::push()
       {
       widx = (widx + 1) % maxCount;
-//      q_atomic_increment(&counter);
-      ++counter;
+      counter.fetchAndAddRelease(1);
       }
 
 //---------------------------------------------------------
 //   pop
+//    called by the reader after the object at ridx is
+//    copied out
 //---------------------------------------------------------
 
 void FifoBase::pop()
       {
       ridx = (ridx + 1) % maxCount;
-      // q_atomic_decrement(&counter);
-      --counter;
+      counter.fetchAndAddRelease(-1);
       }
 
@@ -16,32 +16,39 @@
 
 //---------------------------------------------------------
 //   FifoBase
+//    wait free single producer/single consumer queue
 //    - works only for one reader/writer
 //    - reader writes ridx
 //    - writer writes widx
-//    - reader decrements counter
-//    - writer increments counter
-//    - counter increment/decrement must be atomic
+//    - reader decrements counter (release) after the
+//      object is read
+//    - writer increments counter (release) after the
+//      object is written
+//    - isEmpty() and isFull() load counter with acquire
+//      semantic, so the object is visible to the reader
+//      and the slot is free for the writer
+//    - stored objects should be POD; nothing may be
+//      shared between reader and writer besides the slot
 //---------------------------------------------------------
 
 class FifoBase {
 
    protected:
-      int ridx;               // read index
-      int widx;               // write index
-      volatile int counter;   // objects in fifo
+      int ridx;                     // read index
+      int widx;                     // write index
+      mutable QAtomicInt counter;   // objects in fifo
       int maxCount;
 
       void push();
       void pop();
 
    public:
-      FifoBase()              { clear(); }
+      FifoBase()              { maxCount = 0; clear(); }
       virtual ~FifoBase()     {}
       void clear();
-      int count() const       { return counter; }
-      bool isEmpty() const    { return counter == 0; }
-      bool isFull() const     { return maxCount == counter; }
+      int count() const       { return counter.fetchAndAddAcquire(0); }
+      bool isEmpty() const    { return count() == 0; }
+      bool isFull() const     { return count() == maxCount; }
       };
 
 #endif
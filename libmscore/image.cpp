@@ -36,6 +36,7 @@ Image::Image(Score* s)
       _size            = QSizeF(0, 0);
       _storeItem       = 0;
       _dirty           = false;
+      _placeholder     = false;
       _lockAspectRatio = defaultLockAspectRatio;
       _autoScale       = defaultAutoScale;
       _sizeIsSpatium   = defaultSizeIsSpatium;
@@ -51,6 +52,7 @@ Image::Image(const Image& img)
       _lockAspectRatio = img._lockAspectRatio;
       _autoScale       = img._autoScale;
       _dirty           = img._dirty;
+      _placeholder     = img._placeholder;
       _storeItem       = img._storeItem;
       _sizeIsSpatium   = img._sizeIsSpatium;
       _storeItem->reference(this);
@@ -492,9 +494,18 @@ void RasterImage::draw(QPainter* painter) const
             QSize ss = QSizeF(s.width() * t.m11(), s.height() * t.m22()).toSize();
             t.setMatrix(1.0, t.m12(), t.m13(), t.m21(), 1.0, t.m23(), t.m31(), t.m32(), t.m33());
             painter->setWorldTransform(t);
-            if ((buffer.size() != ss || _dirty) && !doc.isNull()) {
-                  buffer = QPixmap::fromImage(doc.scaled(ss, Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
-                  _dirty = false;
+            if ((buffer.size() != ss || _dirty || _placeholder) && !doc.isNull()) {
+                  // the shared cache returns a smooth scaled image of at
+                  // least size ss, which only needs a small rescale;
+                  // while it is being scaled in the background a
+                  // rescaled placeholder is shown
+                  bool exact;
+                  QImage img = scaledImageCache.image(_storeItem, doc, ss, &exact);
+                  if (img.size() != ss)
+                        img = img.scaled(ss, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+                  buffer       = QPixmap::fromImage(img);
+                  _dirty       = false;
+                  _placeholder = !exact;
                   }
             Image::draw(painter, ss);
             }
@@ -36,6 +36,7 @@ class Image : public BSymbol {
       bool _autoScale;              ///< fill parent frame
       bool _sizeIsSpatium;
       mutable bool _dirty;
+      mutable bool _placeholder;    ///< last draw showed a placeholder
 
       virtual bool isEditable() const { return true; }
       virtual void editDrag(const EditData&);
@@ -63,6 +64,7 @@ class Image : public BSymbol {
       void setAutoScale(bool v)         { _autoScale = v;        }
       ImageStoreItem* storeItem() const { return _storeItem;     }
       bool sizeIsSpatium() const        { return _sizeIsSpatium; }
+      bool placeholder() const          { return _placeholder;   }
       void setSizeIsSpatium(bool val)   { _sizeIsSpatium = val;  }
 
       QSizeF scale() const;
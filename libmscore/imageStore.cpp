@@ -15,6 +15,7 @@
 #include "imageStore.h"
 #include "score.h"
 #include "image.h"
+#include "mscoreview.h"
 
 ImageStore imageStore;  // the global image store
 
@@ -188,3 +189,203 @@ ImageStoreItem* ImageStore::add(const QString& path, const QByteArray& ba)
       return item;
       }
 
+
+//---------------------------------------------------------
+//   ImageReadyEvent
+//    posted by the scaling thread
+//---------------------------------------------------------
+
+static const QEvent::Type IMAGE_READY_EVENT = QEvent::Type(QEvent::User + 1);
+
+struct ImageReadyEvent : public QEvent {
+      QByteArray hash;
+      ImageReadyEvent(const QByteArray& h) : QEvent(IMAGE_READY_EVENT), hash(h) {}
+      };
+
+static const qint64 MAX_SCALED_IMAGE_CACHE = 64 * 1024 * 1024;     // bytes
+static const int UNFETCHED_USES = 256;    // an image not fetched for so many uses may be evicted
+
+ScaledImageCache scaledImageCache;      // the global cache of scaled images
+
+//---------------------------------------------------------
+//   ScaledImageCache
+//---------------------------------------------------------
+
+ScaledImageCache::ScaledImageCache()
+      {
+      cacheSize  = 0;
+      useCounter = 0;
+      }
+
+//---------------------------------------------------------
+//   bucketSize
+//    round size up to the next of four steps per octave
+//---------------------------------------------------------
+
+QSize ScaledImageCache::bucketSize(const QSize& s)
+      {
+      int w = s.width();
+      int h = s.height();
+      if (w <= 0 || h <= 0)
+            return s;
+      int bw = qMax(1, int(ceil(pow(2.0, ceil(log2(double(w)) * 4.0) / 4.0))));
+      int bh = qMax(1, int(ceil(pow(2.0, ceil(log2(double(h)) * 4.0) / 4.0))));
+      return QSize(qMax(bw, w), qMax(bh, h));
+      }
+
+//---------------------------------------------------------
+//   key
+//---------------------------------------------------------
+
+QByteArray ScaledImageCache::key(const QByteArray& hash, const QSize& s)
+      {
+      return hash + QByteArray::number(s.width()) + 'x' + QByteArray::number(s.height());
+      }
+
+//---------------------------------------------------------
+//   image
+//    return an image of at least size s for item;
+//    exact is set if the returned image is the smooth
+//    scaled bucket for s, otherwise the caller should
+//    ask again later
+//---------------------------------------------------------
+
+QImage ScaledImageCache::image(const ImageStoreItem* item, const QImage& doc, const QSize& s, bool* exact)
+      {
+      *exact = false;
+      if (item == 0 || doc.isNull() || s.isEmpty())
+            return doc;
+      QSize bs = bucketSize(s);
+      if (qint64(bs.width()) * bs.height() * 4 > MAX_SCALED_IMAGE_CACHE / 2) {
+            // would push everything else out of the cache
+            *exact = true;
+            return doc.scaled(s, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+            }
+      QByteArray k = key(item->hash(), bs);
+
+      QMutexLocker locker(&mutex);
+      QHash<QByteArray, Entry>::iterator i = entries.find(k);
+      if (i != entries.end()) {
+            i->lastUse = ++useCounter;
+            if (!i->image.isNull()) {
+                  i->fetched = true;
+                  *exact     = true;
+                  return i->image;
+                  }
+            }
+      else {
+            Entry e;
+            e.hash    = item->hash();
+            e.size    = bs;
+            e.lastUse = ++useCounter;
+            e.fetched = false;
+            entries.insert(k, e);
+            QtConcurrent::run(scale, this, k, doc, bs);
+            }
+
+      // while scaling is pending use the nearest cached size
+      QImage best = doc;
+      foreach(const Entry& e, entries) {
+            if (e.hash != item->hash() || e.image.isNull())
+                  continue;
+            if (e.size.width() >= s.width() && e.size.width() < best.width())
+                  best = e.image;
+            }
+      return best;
+      }
+
+//---------------------------------------------------------
+//   scale
+//    called in background thread
+//---------------------------------------------------------
+
+void ScaledImageCache::scale(ScaledImageCache* cache, QByteArray k, QImage doc, QSize s)
+      {
+      cache->insert(k, doc.scaled(s, Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
+      }
+
+//---------------------------------------------------------
+//   insert
+//---------------------------------------------------------
+
+void ScaledImageCache::insert(const QByteArray& k, const QImage& image)
+      {
+      QByteArray hash;
+      {
+      QMutexLocker locker(&mutex);
+      QHash<QByteArray, Entry>::iterator i = entries.find(k);
+      if (i == entries.end())       // cleared meanwhile
+            return;
+      i->image   = image;
+      cacheSize += image.byteCount();
+      hash       = i->hash;
+      purge(k);
+      }
+      QCoreApplication::postEvent(this, new ImageReadyEvent(hash));
+      }
+
+//---------------------------------------------------------
+//   purge
+//    remove least recently used images until the cache
+//    fits into MAX_SCALED_IMAGE_CACHE; the image just
+//    inserted and images not fetched yet are kept, else
+//    the repaint they are waiting for would scale them
+//    again
+//---------------------------------------------------------
+
+void ScaledImageCache::purge(const QByteArray& keep)
+      {
+      while (cacheSize > MAX_SCALED_IMAGE_CACHE) {
+            QHash<QByteArray, Entry>::iterator lru = entries.end();
+            for (QHash<QByteArray, Entry>::iterator i = entries.begin(); i != entries.end(); ++i) {
+                  if (i->image.isNull() || i.key() == keep)
+                        continue;
+                  if (!i->fetched && i->lastUse + UNFETCHED_USES > useCounter)
+                        continue;
+                  if (lru == entries.end() || i->lastUse < lru->lastUse)
+                        lru = i;
+                  }
+            if (lru == entries.end())
+                  break;
+            cacheSize -= lru->image.byteCount();
+            entries.erase(lru);
+            }
+      }
+
+//---------------------------------------------------------
+//   clear
+//---------------------------------------------------------
+
+void ScaledImageCache::clear()
+      {
+      QMutexLocker locker(&mutex);
+      entries.clear();
+      cacheSize = 0;
+      }
+
+//---------------------------------------------------------
+//   event
+//    a scaled image is ready: repaint all images using it;
+//    views without a score, like the palettes, listen to
+//    imageReady()
+//---------------------------------------------------------
+
+bool ScaledImageCache::event(QEvent* ev)
+      {
+      if (ev->type() != IMAGE_READY_EVENT)
+            return QObject::event(ev);
+      const QByteArray& hash = static_cast<ImageReadyEvent*>(ev)->hash;
+      foreach(ImageStoreItem* item, imageStore) {
+            if (item->hash() != hash)
+                  continue;
+            foreach(Image* image, item->references()) {
+                  Score* score = image->score();
+                  if (score == 0)
+                        continue;
+                  foreach(MuseScoreView* v, score->getViewer())
+                        v->dataChanged(image->canvasBoundingRect());
+                  }
+            }
+      emit imageReady(hash);
+      return true;
+      }
@@ -34,6 +34,7 @@ class ImageStoreItem {
       void reference(Image*);
 
       const QString& path() const      { return _path;     }
+      const QList<Image*>& references() const { return _references; }
       QByteArray& buffer()             { return _buffer;   }
       bool loaded() const              { return !_buffer.isEmpty();   }
       void setPath(const QString& val);
@@ -56,5 +57,53 @@ class ImageStore : public QList<ImageStoreItem*>  {
       };
 
 extern ImageStore imageStore;       // this is the global imageStore
+
+//---------------------------------------------------------
+//   ScaledImageCache
+//    Smooth scaled versions of ImageStore images, shared
+//    by all RasterImages referencing the same item.
+//    Requested sizes are rounded up to size buckets (four
+//    per octave) which are scaled in a background thread;
+//    until a bucket is ready the nearest cached size of
+//    the same image is returned. A scaled image is not
+//    evicted before it has been fetched once, so a pending
+//    repaint always finds it; images too large for the
+//    cache are scaled in the paint without caching.
+//---------------------------------------------------------
+
+class ScaledImageCache : public QObject {
+      Q_OBJECT
+
+      struct Entry {
+            QByteArray hash;
+            QSize size;
+            QImage image;           // null while scaling is pending
+            int lastUse;
+            bool fetched;           // image was returned to a caller
+            };
+      mutable QMutex mutex;
+      QHash<QByteArray, Entry> entries;
+      qint64 cacheSize;             // in bytes
+      int useCounter;
+
+      static QByteArray key(const QByteArray& hash, const QSize&);
+      static void scale(ScaledImageCache*, QByteArray key, QImage, QSize);
+      void insert(const QByteArray& key, const QImage&);
+      void purge(const QByteArray& keep);
+
+   protected:
+      virtual bool event(QEvent*);
+
+   public:
+      ScaledImageCache();
+      static QSize bucketSize(const QSize&);
+      QImage image(const ImageStoreItem*, const QImage& doc, const QSize&, bool* exact);
+      void clear();
+
+   signals:
+      void imageReady(const QByteArray& hash);
+      };
+
+extern ScaledImageCache scaledImageCache;
 #endif
 
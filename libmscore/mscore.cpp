@@ -30,6 +30,7 @@ qreal MScore::DPMM;
 bool  MScore::debugMode;
 
 MStyle* MScore::_defaultStyle;
+int     MScore::_defaultStyleGeneration = 0;
 MStyle* MScore::_baseStyle;
 QString MScore::_globalShare;
 int     MScore::_vRaster;
@@ -193,5 +194,6 @@ void MScore::setDefaultStyle(MStyle* s)
       {
       delete _defaultStyle;
       _defaultStyle = s;
+      ++_defaultStyleGeneration;
       }
 
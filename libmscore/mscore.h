@@ -356,6 +356,7 @@ class MScore : public QObject {
 
    private:
       static MStyle* _defaultStyle;       // default modified by preferences
+      static int _defaultStyleGeneration; // incremented by setDefaultStyle()
       static MStyle* _baseStyle;          // buildin initial style
       static QString _globalShare;
       static int _hRaster, _vRaster;
@@ -369,6 +370,7 @@ class MScore : public QObject {
       static MStyle* defaultStyle();
       static MStyle* baseStyle();
       static void setDefaultStyle(MStyle*);
+      static int defaultStyleGeneration() { return _defaultStyleGeneration; }
       static const QString& globalShare() { return _globalShare; }
       static qreal hRaster()              { return _hRaster;     }
       static qreal vRaster()              { return _vRaster;     }
@@ -31,6 +31,14 @@
 #include "system.h"
 #include "mscore.h"
 #include "segment.h"
+#include "accidental.h"
+#include "articulation.h"
+#include "clef.h"
+#include "keysig.h"
+#include "timesig.h"
+#include "tremolo.h"
+#include "rest.h"
+#include "symbol.h"
 
 #define MM(x) ((x)/INCH)
 
@@ -128,7 +136,9 @@ Page::Page(Score* s)
    : Element(s),
    _no(0)
       {
-      bspTreeValid = false;
+      bspTreeValid    = false;
+      _layoutHash     = 0;
+      layoutHashValid = false;
       }
 
 Page::~Page()
@@ -397,6 +407,78 @@ void Page::scanElements(void* data, void (*func)(void*, Element*), bool all)
       func(data, this);
       }
 
+//---------------------------------------------------------
+//   elementSubtype
+//    the glyph an element draws, if it can change without
+//    changing the element size
+//---------------------------------------------------------
+
+static int elementSubtype(const Element* e)
+      {
+      switch (e->type()) {
+            case Element::NOTE:         return static_cast<const Note*>(e)->noteHead();
+            case Element::REST:         return static_cast<const Rest*>(e)->sym();
+            case Element::SYMBOL:       return static_cast<const Symbol*>(e)->sym();
+            case Element::ACCIDENTAL:   return static_cast<const Accidental*>(e)->symbol();
+            case Element::ARTICULATION: return static_cast<const Articulation*>(e)->subtype();
+            case Element::BAR_LINE:     return static_cast<const BarLine*>(e)->subtype();
+            case Element::CLEF:         return static_cast<const Clef*>(e)->clefType();
+            case Element::HOOK:         return static_cast<const Hook*>(e)->subtype();
+            case Element::KEYSIG:       return static_cast<const KeySig*>(e)->keySignature();
+            case Element::TREMOLO:      return static_cast<const Tremolo*>(e)->subtype();
+            case Element::TIMESIG:
+                  {
+                  Fraction f(static_cast<const TimeSig*>(e)->sig());
+                  return (f.numerator() << 8) + f.denominator();
+                  }
+            default:
+                  if (e->isText())
+                        return qHash(static_cast<const Text*>(e)->getText());
+                  return 0;
+            }
+      }
+
+//---------------------------------------------------------
+//   hashElement
+//---------------------------------------------------------
+
+static void hashElement(void* data, Element* e)
+      {
+      uint* h = static_cast<uint*>(data);
+      QPointF p(e->pagePos());
+      QRectF r(e->bbox());
+      int v[] = {
+            e->type(), elementSubtype(e), e->visible(), int(e->color().rgba()),
+            qRound(p.x() * 100.0), qRound(p.y() * 100.0),
+            qRound(r.width() * 100.0), qRound(r.height() * 100.0)
+            };
+      for (unsigned i = 0; i < sizeof(v)/sizeof(*v); ++i)
+            *h = (*h << 5) + *h + uint(v[i]);
+      }
+
+//---------------------------------------------------------
+//   layoutHash
+//    Fingerprint of the position, size, kind, glyph and
+//    text of all visible elements on the page. It is
+//    recomputed lazily after every layout and allows views
+//    to detect which pages were changed by the last layout.
+//---------------------------------------------------------
+
+uint Page::layoutHash()
+      {
+      if (!layoutHashValid) {
+            uint h = 5381;
+            foreach(System* s, _systems) {
+                  foreach(MeasureBase* m, s->measures())
+                        m->scanElements(&h, hashElement, false);
+                  }
+            scanElements(&h, hashElement, false);
+            _layoutHash     = h;
+            layoutHashValid = true;
+            }
+      return _layoutHash;
+      }
+
 //---------------------------------------------------------
 //   PageFormat
 //---------------------------------------------------------
@@ -130,6 +130,8 @@ class Page : public Element {
       void doRebuildBspTree();
 #endif
       bool bspTreeValid;
+      uint _layoutHash;
+      bool layoutHashValid;
 
       QString replaceTextMacros(const QString&) const;
       void drawStyledHeaderFooter(QPainter*, int area, const QPointF&, const QString&) const;
@@ -161,7 +163,8 @@ class Page : public Element {
 
       QList<const Element*> items(const QRectF& r);
       QList<const Element*> items(const QPointF& p);
-      void rebuildBspTree()   { bspTreeValid = false; }
+      void rebuildBspTree()   { bspTreeValid = false; layoutHashValid = false; }
+      uint layoutHash();
       QPointF pagePos() const { return QPointF(); }     ///< position in page coordinates
       QList<System*> searchSystem(const QPointF& pos) const;
       Measure* searchMeasure(const QPointF& p) const;
@@ -75,7 +75,22 @@ void Score::updateChannel()
                   }
             }
 
-      for (Segment* s = fm->first(Segment::SegChordRest | Segment::SegGrace); s; s = s->next1(Segment::SegChordRest | Segment::SegGrace)) {
+      updateSubchannels(0, lastMeasure()->tick() + lastMeasure()->ticks());
+      }
+
+//---------------------------------------------------------
+//   updateSubchannels
+//    set the channel of the notes from tick1 up to tick2;
+//    the channel lists must be up to date
+//---------------------------------------------------------
+
+void Score::updateSubchannels(int tick1, int tick2)
+      {
+      Measure* m = tick2measure(tick1);
+      if (!m)
+            return;
+      Segment::SegmentTypes types = Segment::SegChordRest | Segment::SegGrace;
+      for (Segment* s = m->first(types); s && s->tick() < tick2; s = s->next1(types)) {
             foreach(Staff* st, _staves) {
                   int strack = st->idx() * VOICES;
                   int etrack = strack + VOICES;
@@ -103,26 +118,24 @@ void Score::updateChannel()
 //   playNote
 //---------------------------------------------------------
 
-static void playNote(EventMap* events, const Note* note, int channel, int pitch,
+static void playNote(ChannelEventList* events, const Note* note, int channel, int pitch,
    int velo, int onTime, int offTime)
       {
       velo = note->customizeVelocity(velo);
-      Event ev(ME_NOTEON);
-      ev.setChannel(channel);
-      ev.setPitch(pitch);
-      ev.setVelo(velo);
+      ChannelEvent ev(onTime, ME_NOTEON, channel, pitch, velo);
       ev.setTuning(note->tuning());
       ev.setNote(note);
-      events->insertMulti(onTime, ev);
+      events->add(ev);
+      ev.setTick(offTime);
       ev.setVelo(0);
-      events->insertMulti(offTime, ev);
+      events->add(ev);
       }
 
 //---------------------------------------------------------
 //   collectNote
 //---------------------------------------------------------
 
-static void collectNote(EventMap* events, int channel, const Note* note, int velo, int tickOffset, int gateTime)
+static void collectNote(ChannelEventList* events, int channel, const Note* note, int velo, int tickOffset, int gateTime)
       {
       if (note->hidden() || note->tieBack())       // do not play overlapping notes
             return;
@@ -221,7 +234,7 @@ struct OttavaShiftSegment {
 //   playChord
 //---------------------------------------------------------
 
-static void playChord(EventMap* events, Chord* chord, Instrument* instr, int velocity, int tick, int ticks)
+static void playChord(ChannelEventList* events, Chord* chord, Instrument* instr, int velocity, int tick, int ticks)
       {
       foreach (const Note* note, chord->notes()) {
             int channel = instr->channel(note->subchannel()).channel;
@@ -233,7 +246,7 @@ static void playChord(EventMap* events, Chord* chord, Instrument* instr, int vel
 //   collectMeasureEvents
 //---------------------------------------------------------
 
-static void collectMeasureEvents(EventMap* events, Measure* m, Part* part, int tickOffset)
+static void collectMeasureEvents(ChannelEventList* events, Measure* m, Part* part, int tickOffset)
       {
       int firstStaffIdx = m->score()->staffIdx(part);
       int nextStaffIdx  = firstStaffIdx + part->nstaves();
@@ -337,12 +350,11 @@ static void collectMeasureEvents(EventMap* events, Measure* m, Part* part, int t
                               NamedEventList* nel = instr->midiAction(ma, channel);
                               if (!nel)
                                     continue;
-                              int n = nel->events.size();
-                              for (int i = n-1; i >= 0; --i) {
-                                    Event event(nel->events[i]);
+                              foreach (const Event& e, nel->events) {
+                                    Event event(e);
                                     event.setOntime(tick);
                                     event.setChannel(channel);
-                                    events->insertMulti(tick, event);
+                                    events->add(tick, event);
                                     }
                               }
                         }
@@ -351,27 +363,14 @@ static void collectMeasureEvents(EventMap* events, Measure* m, Part* part, int t
                         int voice   = 0;
                         int channel = staff->channel(tick, voice);
 
+                        // per group: clear group, set mode, select stops
                         for (int i = 0; i < 4; ++i) {
+                              events->add(ChannelEvent(tick, ME_CONTROLLER, channel, 98, 64 + i));
+                              events->add(ChannelEvent(tick, ME_CONTROLLER, channel, 98, 96 + i));
                               for (int k = 0; k < 16; ++k) {
-                                    if (st->getAeolusStop(i, k)) {
-                                          Event event;
-                                          event.setType(ME_CONTROLLER);
-                                          event.setController(98);
-                                          event.setValue(k);
-                                          event.setOntime(tick);
-                                          event.setChannel(channel);
-                                          events->insertMulti(tick, event);
-                                          }
+                                    if (st->getAeolusStop(i, k))
+                                          events->add(ChannelEvent(tick, ME_CONTROLLER, channel, 98, k));
                                     }
-                              Event event(ME_CONTROLLER);
-                              event.setController(98);
-                              event.setValue(96 + i);
-                              event.setOntime(tick);
-                              event.setChannel(channel);
-                              events->insertMulti(tick, event);
-
-                              event.setValue(64 + i);
-                              events->insertMulti(tick, event);
                               }
                         }
                   }
@@ -385,26 +384,194 @@ static void collectMeasureEvents(EventMap* events, Measure* m, Part* part, int t
 
                         int channel = staff->channel(s1->tick(), 0);
 
-                        Event event(ME_CONTROLLER);
-                        event.setChannel(channel);
-                        event.setController(CTRL_SUSTAIN);
+                        events->add(ChannelEvent(s1->tick() + tickOffset, ME_CONTROLLER, channel, CTRL_SUSTAIN, 127));
+                        events->add(ChannelEvent(s2->tick() + tickOffset - 1, ME_CONTROLLER, channel, CTRL_SUSTAIN, 0));
+                        }
+                  }
+            }
+      }
 
-                        event.setValue(127);
-                        events->insertMulti(s1->tick() + tickOffset, event);
+//---------------------------------------------------------
+//   clearEventCache
+//    drop all rendered events; channels, velocities and
+//    the repeat list are updated on next toEList()
+//---------------------------------------------------------
 
-                        event.setValue(0);
-                        events->insertMulti(s2->tick() + tickOffset - 1, event);
-                        }
+void Score::clearEventCache()
+      {
+      _eventCache->clear();
+      _eventsDirty = true;
+      rootScore()->_repeatsExpanded = -1;
+      }
+
+//---------------------------------------------------------
+//   setEventsDirty
+//    drop the rendered events of the measures overlapping
+//    tick1 up to tick2
+//---------------------------------------------------------
+
+void Score::setEventsDirty(int tick1, int tick2)
+      {
+      for (MeasureEventCache::iterator i = _eventCache->begin(); i != _eventCache->end();) {
+            const MeasureEvents& me = i.value();
+            if (me.tick < tick2 && me.tick + me.ticks > tick1)
+                  i = _eventCache->erase(i);
+            else
+                  ++i;
+            }
+      if (_eventsDirtyTick1 == -1) {
+            _eventsDirtyTick1 = tick1;
+            _eventsDirtyTick2 = tick2;
+            }
+      else {
+            _eventsDirtyTick1 = qMin(_eventsDirtyTick1, tick1);
+            _eventsDirtyTick2 = qMax(_eventsDirtyTick2, tick2);
+            }
+      }
+
+//---------------------------------------------------------
+//   eventMeasure
+//    measure an element is rendered in, if any
+//---------------------------------------------------------
+
+static Measure* eventMeasure(const Element* e)
+      {
+      for (; e; e = e->parent()) {
+            if (e->type() == Element::MEASURE)
+                  return static_cast<Measure*>(const_cast<Element*>(e));
+            }
+      return 0;
+      }
+
+//---------------------------------------------------------
+//   setEventsDirty
+//    called from the undo layer for every element an edit
+//    changes; drops the events rendered from it
+//---------------------------------------------------------
+
+void Score::setEventsDirty(const Element* e)
+      {
+      switch (e->type()) {
+            // not rendered
+            case Element::SYMBOL:
+            case Element::TEXT:
+            case Element::INSTRUMENT_NAME:
+            case Element::SLUR_SEGMENT:
+            case Element::STAFF_LINES:
+            case Element::STEM_SLASH:
+            case Element::BRACKET:
+            case Element::STEM:
+            case Element::BREATH:
+            case Element::IMAGE:
+            case Element::BEAM:
+            case Element::HOOK:
+            case Element::LYRICS:
+            case Element::FIGURED_BASS:
+            case Element::FINGERING:
+            case Element::REHEARSAL_MARK:
+            case Element::HARMONY:
+            case Element::FRET_DIAGRAM:
+            case Element::HAIRPIN_SEGMENT:
+            case Element::OTTAVA_SEGMENT:
+            case Element::TRILL_SEGMENT:
+            case Element::TEXTLINE_SEGMENT:
+            case Element::VOLTA_SEGMENT:
+            case Element::LAYOUT_BREAK:
+            case Element::SPACER:
+            case Element::LEDGER_LINE:
+            case Element::NOTEDOT:
+            case Element::TEXTLINE:
+            case Element::SLUR:
+            case Element::HBOX:
+            case Element::VBOX:
+            case Element::TBOX:
+            case Element::FBOX:
+            case Element::ACCIDENTAL_BRACKET:
+                  break;
+
+            // rendered into the measure they belong to
+            case Element::ARPEGGIO:
+            case Element::ACCIDENTAL:
+            case Element::NOTE:
+            case Element::NOTEHEAD:
+            case Element::REST:
+            case Element::CHORD:
+            case Element::ARTICULATION:
+            case Element::TREMOLO:
+            case Element::CHORDLINE:
+            case Element::GLISSANDO:
+            case Element::BEND:
+            case Element::TREMOLOBAR:
+            case Element::TUPLET:
+            case Element::REPEAT_MEASURE:
+                  {
+                  Measure* m = eventMeasure(e);
+                  if (m)
+                        setEventsDirty(m->tick(), m->tick() + m->ticks());
+                  else
+                        clearEventCache();
+                  }
+                  break;
+
+            // a tie changes the start of the tied note
+            case Element::TIE:
+                  {
+                  const Tie* tie = static_cast<const Tie*>(e);
+                  if (tie->startNote())
+                        setEventsDirty(tie->startNote());
+                  if (tie->endNote())
+                        setEventsDirty(tie->endNote());
+                  }
+                  break;
+
+            case Element::PEDAL:
+                  {
+                  // both controller events are rendered from the start segment
+                  const Segment* s = static_cast<const Segment*>(static_cast<const Spanner*>(e)->startElement());
+                  if (s)
+                        setEventsDirty(s->tick(), s->tick() + 1);
+                  else
+                        clearEventCache();
                   }
+                  break;
+
+            // dynamics, hairpins, staff texts, tempo, signatures,
+            // repeats, measures: velocities, channels or the
+            // repeat list may change from here on
+            default:
+                  clearEventCache();
+                  break;
             }
       }
 
+//---------------------------------------------------------
+//   measureEvents
+//    return the events of part in measure m, rendered
+//    without tick offset; the events are cached until the
+//    undo layer reports a change in the measure
+//---------------------------------------------------------
+
+const ChannelEventList& Score::measureEvents(Measure* m, Part* part)
+      {
+      MeasureEvents& me = (*_eventCache)[qMakePair((const Measure*)m, (const Part*)part)];
+      if (me.generation == -1) {
+            collectMeasureEvents(&me.events, m, part, 0);
+            me.tick  = m->tick();
+            me.ticks = m->ticks();
+            }
+      me.generation = _eventCacheGeneration;
+      return me.events;
+      }
+
 //---------------------------------------------------------
 //   renderPart
+//    if sorted is false the events are appended
+//    unsorted, the caller has to sort the list
 //---------------------------------------------------------
 
-void Score::renderPart(EventMap* events, Part* part)
+void Score::renderPart(ChannelEventList* events, Part* part, bool sorted)
       {
+      ++_eventCacheGeneration;
       Measure* lastMeasure = 0;
       foreach (const RepeatSegment* rs, *repeatList()) {
             int startTick  = rs->tick;
@@ -413,16 +580,18 @@ void Score::renderPart(EventMap* events, Part* part)
             for (Measure* m = tick2measure(startTick); m; m = m->nextMeasure()) {
                   if (lastMeasure && m->isRepeatMeasure(part)) {
                         int offset = m->tick() - lastMeasure->tick();
-                        collectMeasureEvents(events, lastMeasure, part, tickOffset + offset);
+                        events->append(measureEvents(lastMeasure, part), tickOffset + offset);
                         }
                   else {
                         lastMeasure = m;
-                        collectMeasureEvents(events, m, part, tickOffset);
+                        events->append(measureEvents(m, part), tickOffset);
                         }
                   if (m->tick() + m->ticks() >= endTick)
                         break;
                   }
             }
+      if (sorted)
+            events->sort();
       }
 
 //---------------------------------------------------------
@@ -431,6 +600,9 @@ void Score::renderPart(EventMap* events, Part* part)
 
 void Score::updateRepeatList(bool expandRepeats)
       {
+      Score* root = rootScore();
+      if (root->_repeatsExpanded == int(expandRepeats))
+            return;
       if (!expandRepeats) {
             foreach(RepeatSegment* s, *repeatList())
                   delete s;
@@ -450,6 +622,7 @@ void Score::updateRepeatList(bool expandRepeats)
             repeatList()->unwind();
       if (MScore::debugMode)
             repeatList()->dump();
+      root->_repeatsExpanded = expandRepeats;
       setPlaylistDirty(true);
       }
 
@@ -458,15 +631,31 @@ void Score::updateRepeatList(bool expandRepeats)
 //    export score to event list
 //---------------------------------------------------------
 
-void Score::toEList(EventMap* events)
+void Score::toEList(ChannelEventList* events)
       {
       updateRepeatList(MScore::playRepeats);
       _foundPlayPosAfterRepeats = false;
-      updateChannel();
-      updateVelo();
+      if (_eventsDirty) {
+            updateChannel();
+            updateVelo();
+            }
+      else if (_eventsDirtyTick1 != -1)
+            updateSubchannels(_eventsDirtyTick1, _eventsDirtyTick2);
+      _eventsDirty      = false;
+      _eventsDirtyTick1 = -1;
+      _eventsDirtyTick2 = -1;
 
+      int generation = _eventCacheGeneration;
       foreach (Part* part, _parts)
-            renderPart(events, part);
+            renderPart(events, part, false);
+
+      // drop measures which are not part of the score anymore
+      for (MeasureEventCache::iterator i = _eventCache->begin(); i != _eventCache->end();) {
+            if (i.value().generation <= generation)
+                  i = _eventCache->erase(i);
+            else
+                  ++i;
+            }
 
       // add metronome ticks
       foreach (const RepeatSegment* rs, *repeatList()) {
@@ -490,14 +679,13 @@ void Score::toEList(EventMap* events)
                         continue;
                   for (int i = 0; i < ts.numerator(); i++) {
                         int tick = m->tick() + i * tw + tickOffset;
-                        Event event;
-                        event.setType(i == 0 ? ME_TICK1 : ME_TICK2);
-                        events->insertMulti(tick, event);
+                        events->add(ChannelEvent(tick, i == 0 ? ME_TICK1 : ME_TICK2));
                         }
                   if (m->tick() + m->ticks() >= endTick)
                         break;
                   }
             }
+      events->sort();
       }
 
 //---------------------------------------------------------
@@ -296,7 +296,7 @@ void Score::init()
       _symIdx         = 0;
       _pageNumberOffset = 0;
       startLayout     = 0;
-      _undo           = new UndoStack();
+      _undo           = new UndoStack(this);
       _repeatList     = new RepeatList(this);
       foreach(StaffType* st, ::staffTypes)
              _staffTypes.append(st->clone());
@@ -323,6 +323,12 @@ void Score::init()
 
       _printing       = false;
       _playlistDirty  = false;
+      _eventCache     = new MeasureEventCache;
+      _eventCacheGeneration = 0;
+      _eventsDirty    = true;
+      _eventsDirtyTick1 = -1;
+      _eventsDirtyTick2 = -1;
+      _repeatsExpanded  = -1;
       _autosaveDirty  = false;
       _dirty          = false;
       _saved          = false;
@@ -415,6 +421,7 @@ Score::~Score()
       delete _tempomap;
       delete _sigmap;
       delete _repeatList;
+      delete _eventCache;
       foreach(StaffType* st, _staffTypes)
             delete st;
       }
@@ -960,6 +967,7 @@ void Score::appendPart(Part* p)
 
 void Score::rebuildMidiMapping()
       {
+      clearEventCache();      // cached events carry midi channels
       _midiMapping.clear();
       int port    = 0;
       int channel = 0;
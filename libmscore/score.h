@@ -58,7 +58,8 @@ class KeySigEvent;
 class Volta;
 class MidiEvent;
 class Excerpt;
-class EventMap;
+class ChannelEventList;
+class MeasureEventCache;
 class Harmony;
 struct Channel;
 class Tuplet;
@@ -312,6 +313,12 @@ class Score : public QObject {
 
       bool _printing;   ///< True if we are drawing to a printer
       bool _playlistDirty;
+      MeasureEventCache* _eventCache;     ///< rendered events per measure and part
+      int _eventCacheGeneration;
+      bool _eventsDirty;                  ///< channels, velocities and repeats must be updated
+      int _eventsDirtyTick1;              ///< range of changed measures, -1: none
+      int _eventsDirtyTick2;
+      int _repeatsExpanded;               ///< expandRepeats of the repeat list, -1: out of date
       bool _autosaveDirty;
       bool _dirty;      ///< Score data was modified.
       bool _saved;      ///< True if project was already saved; only on first
@@ -678,8 +685,12 @@ class Score : public QObject {
       void spatiumChanged(qreal oldValue, qreal newValue);
 
       void pasteStaff(const QDomElement&, ChordRest* dst);
-      void toEList(EventMap* events);
-      void renderPart(EventMap* events, Part*);
+      void toEList(ChannelEventList* events);
+      void renderPart(ChannelEventList* events, Part*, bool sorted = true);
+      const ChannelEventList& measureEvents(Measure*, Part*);
+      void clearEventCache();
+      void setEventsDirty(int tick1, int tick2);
+      void setEventsDirty(const Element*);
       int mscVersion() const    { return _mscVersion; }
       void setMscVersion(int v) { _mscVersion = v; }
 
@@ -696,6 +707,7 @@ class Score : public QObject {
       MidiMapping* midiMapping(int channel)   { return &_midiMapping[channel]; }
       void rebuildMidiMapping();
       void updateChannel();
+      void updateSubchannels(int tick1, int tick2);
 
       void cmdTransposeStaff(int staffIdx, Interval, bool useDoubleSharpsFlats);
       void cmdConcertPitchChanged(bool, bool useSharpsFlats);
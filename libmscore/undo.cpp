@@ -137,15 +137,34 @@ void UndoCommand::redo()
             }
       }
 
+//---------------------------------------------------------
+//   invalidateEvents
+//    drop the rendered playback events the command changed;
+//    a command which does not know may have changed anything
+//---------------------------------------------------------
+
+void UndoCommand::invalidateEvents(Score* score) const
+      {
+      if (childList.isEmpty()) {
+            foreach(Score* s, score->scoreList())
+                  s->clearEventCache();
+            }
+      else {
+            foreach(UndoCommand* c, childList)
+                  c->invalidateEvents(score);
+            }
+      }
+
 //---------------------------------------------------------
 //   unwind
 //---------------------------------------------------------
 
-void UndoCommand::unwind()
+void UndoCommand::unwind(Score* score)
       {
       while (!childList.isEmpty()) {
             UndoCommand* c = childList.takeLast();
             c->undo();
+            c->invalidateEvents(score);
             delete c;
             }
       }
@@ -154,8 +173,9 @@ void UndoCommand::unwind()
 //   UndoStack
 //---------------------------------------------------------
 
-UndoStack::UndoStack()
+UndoStack::UndoStack(Score* s)
       {
+      score    = s;
       curCmd   = 0;
       curIdx   = 0;
       cleanIdx = 0;
@@ -220,6 +240,7 @@ void UndoStack::push(UndoCommand* cmd)
             // qDebug("UndoStack:push(): no active command, UndoStack %p", this);
 
             cmd->redo();
+            cmd->invalidateEvents(score);
             delete cmd;
             return;
             }
@@ -234,6 +255,7 @@ void UndoStack::push(UndoCommand* cmd)
 #endif
       curCmd->appendChild(cmd);
       cmd->redo();
+      cmd->invalidateEvents(score);
       }
 
 //---------------------------------------------------------
@@ -248,6 +270,7 @@ void UndoStack::pop()
             }
       UndoCommand* cmd = curCmd->removeChild();
       cmd->undo();
+      cmd->invalidateEvents(score);
       }
 
 //---------------------------------------------------------
@@ -273,6 +296,7 @@ void UndoStack::undo()
             if (MScore::debugMode)
                   qDebug("--undo index %d", curIdx);
             list[curIdx]->undo();
+            list[curIdx]->invalidateEvents(score);
             }
       }
 
@@ -285,7 +309,8 @@ void UndoStack::redo()
       if (canRedo()) {
             if (MScore::debugMode)
                   qDebug("--redo index %d", curIdx);
-            list[curIdx++]->redo();
+            list[curIdx]->redo();
+            list[curIdx++]->invalidateEvents(score);
             }
       }
 
@@ -1252,6 +1277,15 @@ void AddElement::redo()
             }
       }
 
+//---------------------------------------------------------
+//   invalidateEvents
+//---------------------------------------------------------
+
+void AddElement::invalidateEvents(Score*) const
+      {
+      element->score()->setEventsDirty(element);
+      }
+
 //---------------------------------------------------------
 //   name
 //---------------------------------------------------------
@@ -1328,6 +1362,15 @@ void RemoveElement::redo()
             element->score()->setLayoutAll(true);    //DEBUG
       }
 
+//---------------------------------------------------------
+//   invalidateEvents
+//---------------------------------------------------------
+
+void RemoveElement::invalidateEvents(Score*) const
+      {
+      element->score()->setEventsDirty(element);
+      }
+
 //---------------------------------------------------------
 //   name
 //---------------------------------------------------------
@@ -1575,6 +1618,15 @@ void ChangePitch::flip()
       score->setLayoutAll(true);
       }
 
+//---------------------------------------------------------
+//   invalidateEvents
+//---------------------------------------------------------
+
+void ChangePitch::invalidateEvents(Score*) const
+      {
+      note->score()->setEventsDirty(note);
+      }
+
 //---------------------------------------------------------
 //   FlipNoteDotDirection
 //---------------------------------------------------------
@@ -1640,6 +1692,16 @@ void ChangeElement::flip()
       score->setLayoutAll(true);
       }
 
+//---------------------------------------------------------
+//   invalidateEvents
+//---------------------------------------------------------
+
+void ChangeElement::invalidateEvents(Score*) const
+      {
+      oldElement->score()->setEventsDirty(oldElement);
+      newElement->score()->setEventsDirty(newElement);
+      }
+
 //---------------------------------------------------------
 //   InsertStaves
 //---------------------------------------------------------
@@ -2011,6 +2073,15 @@ void ChangeChordRestLen::flip()
       cr->score()->setLayout(cr->measure());
       }
 
+//---------------------------------------------------------
+//   invalidateEvents
+//---------------------------------------------------------
+
+void ChangeChordRestLen::invalidateEvents(Score*) const
+      {
+      cr->score()->setEventsDirty(cr);
+      }
+
 //---------------------------------------------------------
 //   MoveElement
 //---------------------------------------------------------
@@ -2097,6 +2168,15 @@ void EditText::undoRedo()
       text->score()->setLayoutAll(true);
       }
 
+//---------------------------------------------------------
+//   invalidateEvents
+//---------------------------------------------------------
+
+void EditText::invalidateEvents(Score*) const
+      {
+      text->score()->setEventsDirty(text);
+      }
+
 //---------------------------------------------------------
 //   ChangePatch
 //---------------------------------------------------------
@@ -2403,6 +2483,15 @@ void ChangeChordStaffMove::flip()
       staffMove = v;
       }
 
+//---------------------------------------------------------
+//   invalidateEvents
+//---------------------------------------------------------
+
+void ChangeChordStaffMove::invalidateEvents(Score*) const
+      {
+      chord->score()->setEventsDirty(chord);
+      }
+
 //---------------------------------------------------------
 //   ChangeVelocity
 //---------------------------------------------------------
@@ -2422,6 +2511,15 @@ void ChangeVelocity::flip()
       veloOffset = o;
       }
 
+//---------------------------------------------------------
+//   invalidateEvents
+//---------------------------------------------------------
+
+void ChangeVelocity::invalidateEvents(Score*) const
+      {
+      note->score()->setEventsDirty(note);
+      }
+
 //---------------------------------------------------------
 //   ChangeMStaffProperties
 //---------------------------------------------------------
@@ -2533,6 +2631,15 @@ void ChangeNoteProperties::flip()
       _offTimeUserOffset = v9;
       }
 
+//---------------------------------------------------------
+//   invalidateEvents
+//---------------------------------------------------------
+
+void ChangeNoteProperties::invalidateEvents(Score*) const
+      {
+      note->score()->setEventsDirty(note);
+      }
+
 //---------------------------------------------------------
 //   ChangeTimesig
 //---------------------------------------------------------
@@ -2669,6 +2776,15 @@ void ChangeDuration::flip()
       d = od;
       }
 
+//---------------------------------------------------------
+//   invalidateEvents
+//---------------------------------------------------------
+
+void ChangeDuration::invalidateEvents(Score*) const
+      {
+      cr->score()->setEventsDirty(cr);
+      }
+
 //---------------------------------------------------------
 //   AddExcerpt::undo
 //---------------------------------------------------------
@@ -2720,6 +2836,15 @@ void ChangeBend::flip()
       points = pv;
       }
 
+//---------------------------------------------------------
+//   invalidateEvents
+//---------------------------------------------------------
+
+void ChangeBend::invalidateEvents(Score*) const
+      {
+      bend->score()->setEventsDirty(bend);
+      }
+
 //---------------------------------------------------------
 //   flip
 //---------------------------------------------------------
@@ -2731,6 +2856,15 @@ void ChangeTremoloBar::flip()
       points = pv;
       }
 
+//---------------------------------------------------------
+//   invalidateEvents
+//---------------------------------------------------------
+
+void ChangeTremoloBar::invalidateEvents(Score*) const
+      {
+      bend->score()->setEventsDirty(bend);
+      }
+
 //---------------------------------------------------------
 //   ChangeNoteEvents::flip
 //---------------------------------------------------------
@@ -2743,6 +2877,15 @@ void ChangeNoteEvents::flip()
       */
       }
 
+//---------------------------------------------------------
+//   invalidateEvents
+//---------------------------------------------------------
+
+void ChangeNoteEvents::invalidateEvents(Score*) const
+      {
+      chord->score()->setEventsDirty(chord);
+      }
+
 //---------------------------------------------------------
 //   undoChangeBarLine
 //---------------------------------------------------------
@@ -2884,6 +3027,16 @@ void SwapCR::flip()
       cr1->score()->setLayoutAll(true);
       }
 
+//---------------------------------------------------------
+//   invalidateEvents
+//---------------------------------------------------------
+
+void SwapCR::invalidateEvents(Score*) const
+      {
+      cr1->score()->setEventsDirty(cr1);
+      cr2->score()->setEventsDirty(cr2);
+      }
+
 //---------------------------------------------------------
 //   ChangeClefType
 //---------------------------------------------------------
@@ -2944,6 +3097,15 @@ void ChangeDurationType::flip()
       t = type;
       }
 
+//---------------------------------------------------------
+//   invalidateEvents
+//---------------------------------------------------------
+
+void ChangeDurationType::invalidateEvents(Score*) const
+      {
+      cr->score()->setEventsDirty(cr);
+      }
+
 //---------------------------------------------------------
 //   ChangeSpannerAnchor::flip
 //---------------------------------------------------------
@@ -3039,6 +3201,15 @@ void ChangeProperty::flip()
       property = v;
       }
 
+//---------------------------------------------------------
+//   invalidateEvents
+//---------------------------------------------------------
+
+void ChangeProperty::invalidateEvents(Score*) const
+      {
+      element->score()->setEventsDirty(element);
+      }
+
 //---------------------------------------------------------
 //   ChangeMetaText::flip
 //---------------------------------------------------------
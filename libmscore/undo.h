@@ -90,10 +90,11 @@ class UndoCommand {
       virtual ~UndoCommand();
       virtual void undo();
       virtual void redo();
+      virtual void invalidateEvents(Score*) const;
       void appendChild(UndoCommand* cmd) { childList.append(cmd);       }
       UndoCommand* removeChild()         { return childList.takeLast(); }
       int childCount() const             { return childList.size();     }
-      void unwind();
+      void unwind(Score*);
 #ifdef DEBUG_UNDO
       virtual const char* name() const  { return "UndoCommand"; }
 #endif
@@ -104,13 +105,14 @@ class UndoCommand {
 //---------------------------------------------------------
 
 class UndoStack {
+      Score* score;
       UndoCommand* curCmd;
       QList<UndoCommand*> list;
       int curIdx;
       int cleanIdx;
 
    public:
-      UndoStack();
+      UndoStack(Score*);
       ~UndoStack();
 
       bool active() const           { return curCmd != 0; }
@@ -142,6 +144,7 @@ class SaveState : public UndoCommand {
       SaveState(Score*);
       virtual void undo();
       virtual void redo();
+      virtual void invalidateEvents(Score*) const {}
       UNDO_NAME("SaveState");
       };
 
@@ -315,6 +318,7 @@ class ChangePitch : public UndoCommand {
       ChangePitch(Note* note, int pitch, int tpc, int l/*, int f, int string*/);
       virtual void undo() { flip(); }
       virtual void redo() { flip(); }
+      virtual void invalidateEvents(Score*) const;
       UNDO_NAME("ChangePitch");
       };
 
@@ -349,6 +353,7 @@ class FlipNoteDotDirection : public UndoCommand {
       FlipNoteDotDirection(Note* n) : note(n) {}
       virtual void undo() { flip(); }
       virtual void redo() { flip(); }
+      virtual void invalidateEvents(Score*) const {}
       UNDO_NAME("FlipNoteDotDirection");
       };
 
@@ -381,6 +386,7 @@ class ChangeElement : public UndoCommand {
       ChangeElement(Element* oldElement, Element* newElement);
       virtual void undo() { flip(); }
       virtual void redo() { flip(); }
+      virtual void invalidateEvents(Score*) const;
       UNDO_NAME("ChangeElement");
       };
 
@@ -429,6 +435,7 @@ class ChangeVoltaText : public UndoCommand {
       ChangeVoltaText(Volta*, const QString&);
       virtual void undo() { flip(); }
       virtual void redo() { flip(); }
+      virtual void invalidateEvents(Score*) const {}
       UNDO_NAME("ChangeVoltaText");
       };
 
@@ -445,6 +452,7 @@ class ChangeChordRestSize : public UndoCommand {
       ChangeChordRestSize(ChordRest*, bool small);
       virtual void undo() { flip(); }
       virtual void redo() { flip(); }
+      virtual void invalidateEvents(Score*) const {}
       UNDO_NAME("ChangeChordRestSize");
       };
 
@@ -461,6 +469,7 @@ class ChangeChordNoStem : public UndoCommand {
       ChangeChordNoStem(Chord*, bool noStem);
       virtual void undo() { flip(); }
       virtual void redo() { flip(); }
+      virtual void invalidateEvents(Score*) const {}
       UNDO_NAME("ChangeChordNoStem");
       };
 
@@ -477,6 +486,7 @@ class ChangeEndBarLineType : public UndoCommand {
       ChangeEndBarLineType(Measure*, BarLineType subtype);
       virtual void undo() { flip(); }
       virtual void redo() { flip(); }
+      virtual void invalidateEvents(Score*) const {}
       UNDO_NAME("ChangeEndBarLineType");
       };
 
@@ -493,6 +503,7 @@ class ChangeBarLineSpan : public UndoCommand {
       ChangeBarLineSpan(Staff*, int span);
       virtual void undo() { flip(); }
       virtual void redo() { flip(); }
+      virtual void invalidateEvents(Score*) const {}
       UNDO_NAME("ChangeBarLineSpan");
       };
 
@@ -515,6 +526,7 @@ class ChangeSlurOffsets : public UndoCommand {
             }
       virtual void undo() { flip(); }
       virtual void redo() { flip(); }
+      virtual void invalidateEvents(Score*) const {}
       UNDO_NAME("ChangeSlurOffsets");
       };
 
@@ -566,6 +578,7 @@ class ChangeCopyright : public UndoCommand {
       ChangeCopyright(Score*, const QString&);
       virtual void undo() { flip(); }
       virtual void redo() { flip(); }
+      virtual void invalidateEvents(Score*) const {}
       UNDO_NAME("ChangeCopyright");
       };
 #endif
@@ -616,6 +629,7 @@ class ChangeInstrumentShort : public UndoCommand {
       ChangeInstrumentShort(int, Part*, QList<StaffNameDoc>);
       virtual void undo() { flip(); }
       virtual void redo() { flip(); }
+      virtual void invalidateEvents(Score*) const {}
       UNDO_NAME("ChangeInstrumentShort");
       };
 
@@ -634,6 +648,7 @@ class ChangeInstrumentLong : public UndoCommand {
       ChangeInstrumentLong(int, Part*, QList<StaffNameDoc>);
       virtual void undo() { flip(); }
       virtual void redo() { flip(); }
+      virtual void invalidateEvents(Score*) const {}
       UNDO_NAME("ChangeInstrumentLong");
       };
 
@@ -650,6 +665,7 @@ class ChangeChordRestLen : public UndoCommand {
       ChangeChordRestLen(ChordRest*, const TDuration& d);
       virtual void undo() { flip(); }
       virtual void redo() { flip(); }
+      virtual void invalidateEvents(Score*) const;
       UNDO_NAME("ChangeChordRestLen");
       };
 
@@ -666,6 +682,7 @@ class MoveElement : public UndoCommand {
       MoveElement(Element*, const QPointF&);
       virtual void undo() { flip(); }
       virtual void redo() { flip(); }
+      virtual void invalidateEvents(Score*) const {}
       UNDO_NAME("MoveElement");
       };
 
@@ -683,6 +700,7 @@ class ChangeBracketSpan : public UndoCommand {
       ChangeBracketSpan(Staff*, int column, int span);
       virtual void undo() { flip(); }
       virtual void redo() { flip(); }
+      virtual void invalidateEvents(Score*) const {}
       UNDO_NAME("ChangeBracketSpan");
       };
 
@@ -697,6 +715,7 @@ class AddElement : public UndoCommand {
       AddElement(Element*);
       virtual void undo();
       virtual void redo();
+      virtual void invalidateEvents(Score*) const;
 #ifdef DEBUG_UNDO
       virtual const char* name() const;
 #endif
@@ -713,6 +732,7 @@ class RemoveElement : public UndoCommand {
       RemoveElement(Element*);
       virtual void undo();
       virtual void redo();
+      virtual void invalidateEvents(Score*) const;
 #ifdef DEBUG_UNDO
       virtual const char* name() const;
 #endif
@@ -749,6 +769,7 @@ class EditText : public UndoCommand {
       EditText(Text* t, const QString& ot, int l) : text(t), oldText(ot), undoLevel(l) {}
       virtual void undo();
       virtual void redo();
+      virtual void invalidateEvents(Score*) const;
       UNDO_NAME("EditText");
       };
 
@@ -787,6 +808,7 @@ class ChangePageFormat : public UndoCommand {
       ~ChangePageFormat();
       virtual void undo() { flip(); }
       virtual void redo() { flip(); }
+      virtual void invalidateEvents(Score*) const {}
       UNDO_NAME("ChangePageFormat");
       };
 
@@ -861,6 +883,7 @@ class ChangeTextStyle : public UndoCommand {
       ChangeTextStyle(Score*, const TextStyle& style);
       virtual void undo() { flip(); }
       virtual void redo() { flip(); }
+      virtual void invalidateEvents(Score*) const {}
       UNDO_NAME("ChangeTextStyle");
       };
 
@@ -876,6 +899,7 @@ class AddTextStyle : public UndoCommand {
       AddTextStyle(Score* s, const TextStyle& st) : score(s), style(st) {}
       virtual void undo();
       virtual void redo();
+      virtual void invalidateEvents(Score*) const {}
       UNDO_NAME("AddTextStyle");
       };
 
@@ -892,6 +916,7 @@ class ChangeStretch : public UndoCommand {
       ChangeStretch(Measure*, qreal);
       virtual void undo() { flip(); }
       virtual void redo() { flip(); }
+      virtual void invalidateEvents(Score*) const {}
       UNDO_NAME("ChangeStretch");
       };
 
@@ -924,6 +949,7 @@ class ChangeChordStaffMove : public UndoCommand {
       ChangeChordStaffMove(Chord*, int);
       virtual void undo() { flip(); }
       virtual void redo() { flip(); }
+      virtual void invalidateEvents(Score*) const;
       UNDO_NAME("ChangeChordStaffMove");
       };
 
@@ -941,6 +967,7 @@ class ChangeVelocity : public UndoCommand {
       ChangeVelocity(Note*, MScore::ValueType, int);
       virtual void undo() { flip(); }
       virtual void redo() { flip(); }
+      virtual void invalidateEvents(Score*) const;
       UNDO_NAME("ChangeVelocity");
       };
 
@@ -958,6 +985,7 @@ class ChangeMStaffProperties : public UndoCommand {
       ChangeMStaffProperties(MStaff*, bool visible, bool slashStyle);
       virtual void undo() { flip(); }
       virtual void redo() { flip(); }
+      virtual void invalidateEvents(Score*) const {}
       UNDO_NAME("ChangeMStaffProperties");
       };
 
@@ -1002,6 +1030,7 @@ class ChangeNoteProperties : public UndoCommand {
       ChangeNoteProperties(Note*, MScore::ValueType, int, int, int);
       virtual void undo() { flip(); }
       virtual void redo() { flip(); }
+      virtual void invalidateEvents(Score*) const;
       UNDO_NAME("ChangeNoteProperties");
       };
 
@@ -1073,6 +1102,7 @@ class ChangeImage : public UndoCommand {
          : image(i), lockAspectRatio(l), autoScale(a), z(_z) {}
       virtual void undo() { flip(); }
       virtual void redo() { flip(); }
+      virtual void invalidateEvents(Score*) const {}
       UNDO_NAME("ChangeImage");
       };
 
@@ -1110,6 +1140,7 @@ class ChangeDuration : public UndoCommand {
       ChangeDuration(ChordRest* _cr, Fraction _d) : cr(_cr), d(_d) {}
       virtual void undo() { flip(); }
       virtual void redo() { flip(); }
+      virtual void invalidateEvents(Score*) const;
       UNDO_NAME("ChangeDuration");
       };
 
@@ -1155,6 +1186,7 @@ class ChangeBend : public UndoCommand {
       ChangeBend(Bend* b, QList<PitchValue> p) : bend(b), points(p) {}
       virtual void undo() { flip(); }
       virtual void redo() { flip(); }
+      virtual void invalidateEvents(Score*) const;
       UNDO_NAME("ChangeBend");
       };
 
@@ -1172,6 +1204,7 @@ class ChangeTremoloBar : public UndoCommand {
       ChangeTremoloBar(TremoloBar* b, QList<PitchValue> p) : bend(b), points(p) {}
       virtual void undo() { flip(); }
       virtual void redo() { flip(); }
+      virtual void invalidateEvents(Score*) const;
       UNDO_NAME("ChangeTremoloBar");
       };
 
@@ -1189,6 +1222,7 @@ class ChangeNoteEvents : public UndoCommand {
       ChangeNoteEvents(Chord* n, const QList<NoteEvent*>& l) : chord(n), events(l) {}
       virtual void undo() { flip(); }
       virtual void redo() { flip(); }
+      virtual void invalidateEvents(Score*) const;
       UNDO_NAME("ChangeNoteEvents");
       };
 
@@ -1230,6 +1264,7 @@ class ChangeBoxProperties : public UndoCommand {
          qreal, qreal);
       virtual void undo() { flip(); }
       virtual void redo() { flip(); }
+      virtual void invalidateEvents(Score*) const {}
       UNDO_NAME("ChangeBoxProperties");
       };
 
@@ -1247,6 +1282,7 @@ class SwapCR : public UndoCommand {
       SwapCR(ChordRest* a, ChordRest* b) : cr1(a), cr2(b) {}
       virtual void undo() { flip(); }
       virtual void redo() { flip(); }
+      virtual void invalidateEvents(Score*) const;
       UNDO_NAME("SwapCR");
       };
 
@@ -1300,6 +1336,7 @@ class ChangeDurationType : public UndoCommand {
          : cr(_cr), t(_t) {}
       virtual void undo() { flip(); }
       virtual void redo() { flip(); }
+      virtual void invalidateEvents(Score*) const;
       UNDO_NAME("ChangeDurationType");
       };
 
@@ -1337,6 +1374,7 @@ class ChangeStaffUserDist : public UndoCommand {
          : staff(s), dist(d) {}
       virtual void undo() { flip(); }
       virtual void redo() { flip(); }
+      virtual void invalidateEvents(Score*) const {}
       UNDO_NAME("ChangeStaffUserDist");
       };
 
@@ -1357,6 +1395,7 @@ class ChangeProperty : public UndoCommand {
       virtual void undo() { flip(); }
       virtual void redo() { flip(); }
       P_ID getId() const  { return id; }
+      virtual void invalidateEvents(Score*) const;
       UNDO_NAME("ChangeProperty");
       };
 
@@ -1375,6 +1414,7 @@ class ChangeMetaText : public UndoCommand {
       ChangeMetaText(Score* s, const QString& i, const QString& t) : score(s), id(i), text(t) {}
       virtual void undo() { flip(); }
       virtual void redo() { flip(); }
+      virtual void invalidateEvents(Score*) const {}
       UNDO_NAME("ChangeMetaText");
       };
 
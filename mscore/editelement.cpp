@@ -147,7 +147,7 @@ void ScoreView::endEdit()
             bool colorChanged = editObject->color() != origEditObject->color();
             if (!spanner->isEdited(original) && !colorChanged) {
                   UndoStack* undo = _score->undo();
-                  undo->current()->unwind();
+                  undo->current()->unwind(_score);
                   _score->select(editObject);
                   _score->addRefresh(editObject->canvasBoundingRect());
                   _score->addRefresh(origEditObject->canvasBoundingRect());
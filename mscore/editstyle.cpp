@@ -137,7 +137,7 @@ void EditStyle::buttonClicked(QAbstractButton* b)
                   break;
             default:
                   if(cs->undo() && cs->undo()->current()) {
-                        cs->undo()->current()->unwind();
+                        cs->undo()->current()->unwind(cs);
                         cs->setLayoutAll(true);
                         }
                   done(0);
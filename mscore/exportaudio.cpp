@@ -23,8 +23,9 @@
 #ifdef HAS_AUDIOFILE
 
 #include <sndfile.h>
+#include <QtCore/QTemporaryFile>
 #include "libmscore/score.h"
-#include "fluid/fluid.h"
+#include "msynth/render.h"
 // #include "libmscore/tempo.h"
 #include "libmscore/note.h"
 #include "musescore.h"
@@ -33,11 +34,32 @@
 #include "seq.h"
 #include "libmscore/mscore.h"
 
+//---------------------------------------------------------
+//   stemFileName
+//    <name>-<nn>-<part name>.<ext>
+//---------------------------------------------------------
+
+static QString stemFileName(const QString& name, int idx, const Part* part)
+      {
+      QFileInfo fi(name);
+      QString pn = part->partName();
+      for (int i = 0; i < pn.size(); ++i) {
+            if (!pn[i].isLetterOrNumber() && pn[i] != '-')
+                  pn[i] = '_';
+            }
+      return QString("%1/%2-%3-%4.%5").arg(fi.path()).arg(fi.completeBaseName())
+         .arg(idx + 1, 2, 10, QChar('0')).arg(pn).arg(fi.suffix());
+      }
+
 //---------------------------------------------------------
 //   saveAudio
+//    With stems, every part is written to its own file
+//    next to 'name'; AUDIO_STEMS_MIX also writes the full
+//    mix to 'name'. All files come from one rendering
+//    pass.
 //---------------------------------------------------------
 
-bool MuseScore::saveAudio(Score* score, const QString& name, const QString& ext)
+bool MuseScore::saveAudio(Score* score, const QString& name, const QString& ext, AudioStems stemMode)
       {
       int format;
       if (ext == "wav")
@@ -52,118 +74,150 @@ bool MuseScore::saveAudio(Score* score, const QString& name, const QString& ext)
             }
       int sampleRate = preferences.exportAudioSampleRate;
 
-      MasterSynth* synti = new MasterSynth();
-      synti->init(sampleRate);
-      synti->setState(score->syntiState());
-
-      int oldSampleRate = MScore::sampleRate;
-      MScore::sampleRate = sampleRate;
-
-      EventMap events;
-      score->toEList(&events);
+      //
+      // outputs: one per stem, the full mix last
+      //
+      QStringList fileNames;
+      int stems = 0;
+      if (stemMode != AUDIO_MIX) {
+            stems = score->parts().size();
+            for (int i = 0; i < stems; ++i)
+                  fileNames.append(stemFileName(name, i, score->parts().at(i)));
+            }
+      if (stemMode != AUDIO_STEMS)
+            fileNames.append(name);
+      const int outputs = fileNames.size();
+      if (outputs == 0)
+            return false;
 
       SF_INFO info;
       memset(&info, 0, sizeof(info));
       info.channels   = 2;
       info.samplerate = sampleRate;
       info.format     = format;
-      SNDFILE* sf     = sf_open(qPrintable(name), SFM_WRITE, &info);
-      if (sf == 0) {
-            qDebug("open soundfile failed: %s\n", sf_strerror(sf));
-            delete synti;
-            MScore::sampleRate = oldSampleRate;
-            return false;
+      QVector<SNDFILE*> sf;
+      foreach(const QString& fn, fileNames) {
+            SNDFILE* f = sf_open(qPrintable(fn), SFM_WRITE, &info);
+            if (f == 0) {
+                  qDebug("open soundfile <%s> failed: %s\n", qPrintable(fn), sf_strerror(f));
+                  foreach(SNDFILE* of, sf)
+                        sf_close(of);
+                  return false;
+                  }
+            sf.append(f);
+            }
+
+      static const int FRAMES = 512;
+      ScoreRenderer renderer(score, sampleRate, score->syntiState(), FRAMES,
+         preferences.synthSettings());
+      renderer.setRenderThreads(QThread::idealThreadCount());
+      renderer.setStems(stems > 0);
+
+      //
+      // The score is rendered once. When normalizing, the
+      // unscaled output of all outputs goes to one temporary
+      // float file, interleaved frame by frame, while the
+      // peak is measured; the gain is applied when the file
+      // is encoded in a second stage. All outputs get the
+      // same gain, so the stems still add up to the mix.
+      // Without normalization the output is written directly
+      // with the gain of the synthesizer state.
+      //
+      bool normalize = preferences.exportAudioNormalize;
+      bool ok        = true;
+      QTemporaryFile tmp;
+      if (normalize) {
+            if (!tmp.open()) {
+                  qDebug("cannot open temporary file for audio export\n");
+                  foreach(SNDFILE* f, sf)
+                        sf_close(f);
+                  return false;
+                  }
+            renderer.synth()->setGain(1.0);
             }
 
       QProgressBar* pBar = showProgressBar();
       pBar->reset();
 
-      float peak = 0.0;
-      double gain = 1.0;
-      EventMap::const_iterator endPos = events.constEnd();
-      --endPos;
-      const int et = (score->utick2utime(endPos.key()) + 1) * MScore::sampleRate;
-      for (int pass = 0; pass < 2; ++pass) {
-            EventMap::const_iterator playPos;
-            playPos = events.constBegin();
-            pBar->setRange(0, et);
-
-            //
-            // init instruments
-            //
-            foreach(const Part* part, score->parts()) {
-                  foreach(const Channel& a, part->instr()->channel()) {
-                        a.updateInitList();
-                        foreach(Event e, a.init) {
-                              if (e.type() == ME_INVALID)
-                                    continue;
-                              e.setChannel(a.channel);
-                              int syntiIdx= score->midiMapping(a.channel)->articulation->synti;
-                              synti->play(e, syntiIdx);
-                              }
+      const int blockSize = FRAMES * 2;
+      QVector<float> buffer((stems + 1) * blockSize);
+      QVector<float> frameBuffer(outputs * blockSize);     // all outputs interleaved
+      QVector<float*> out(renderer.outputs());
+      for (int i = 0; i < out.size(); ++i)
+            out[i] = buffer.data() + i * blockSize;
+      float peak   = 0.0;
+      const int et = renderer.frames();
+      pBar->setRange(0, normalize ? 2 * et : et);
+
+      while (int frames = renderer.render(out.data())) {
+            const int n = frames * 2;
+            if (stems && stemMode == AUDIO_STEMS_MIX) {
+                  float* mix = buffer.data() + stems * blockSize;
+                  memset(mix, 0, n * sizeof(float));
+                  for (int k = 0; k < stems; ++k) {
+                        const float* p = buffer.data() + k * blockSize;
+                        for (int i = 0; i < n; ++i)
+                              mix[i] += p[i];
                         }
                   }
-
-            static const unsigned FRAMES = 512;
-            float buffer[FRAMES * 2];
-            int playTime = 0;
-            synti->setGain(gain);
-
-            for (;;) {
-                  unsigned frames = FRAMES;
-                  //
-                  // collect events for one segment
-                  //
-                  memset(buffer, 0, sizeof(float) * FRAMES * 2);
-                  int endTime = playTime + frames;
-                  float* p = buffer;
-                  for (; playPos != events.constEnd(); ++playPos) {
-                        int f = score->utick2utime(playPos.key()) * MScore::sampleRate;
-                        if (f >= endTime)
-                              break;
-                        int n = f - playTime;
-                        synti->process(n, p);
-                        p         += 2 * n;
-
-                        playTime  += n;
-                        frames    -= n;
-                        const Event& e = playPos.value();
-                        if (e.isChannelEvent()) {
-                              int channelIdx = e.channel();
-                              Channel* c = score->midiMapping(channelIdx)->articulation;
-                              if (!c->mute) {
-                                    synti->play(e, c->synti);
-                                    }
+            if (normalize) {
+                  float* q = frameBuffer.data();
+                  for (int i = 0; i < frames; ++i) {
+                        for (int k = 0; k < outputs; ++k) {
+                              const float* p = buffer.data() + k * blockSize + i * 2;
+                              peak = qMax(peak, qMax(qAbs(p[0]), qAbs(p[1])));
+                              *q++ = p[0];
+                              *q++ = p[1];
                               }
                         }
-                  if (frames) {
-                        synti->process(frames, p);
-                        playTime += frames;
+                  qint64 len = qint64(n) * outputs * sizeof(float);
+                  if (tmp.write((const char*)frameBuffer.data(), len) != len) {
+                        qDebug("write to temporary file failed\n");
+                        ok = false;
+                        break;
                         }
-                  if (pass == 1)
-                        sf_writef_float(sf, buffer, FRAMES);
-                  else {
-                        for (unsigned i = 0; i < FRAMES * 2; ++i)
-                              peak = qMax(peak, qAbs(buffer[i]));
+                  }
+            else {
+                  for (int k = 0; k < outputs; ++k)
+                        sf_writef_float(sf[k], buffer.data() + k * blockSize, frames);
+                  }
+            pBar->setValue(renderer.position());
+            }
+
+      //
+      // encode the rendered frames with normalized gain
+      //
+      if (normalize && ok) {
+            float gain = peak > 0.0 ? 0.99 / peak : 1.0;
+            tmp.seek(0);
+            int pos = 0;
+            qint64 n;
+            while ((n = tmp.read((char*)frameBuffer.data(), frameBuffer.size() * sizeof(float))) > 0) {
+                  int frames     = n / (outputs * 2 * sizeof(float));
+                  const float* q = frameBuffer.data();
+                  for (int i = 0; i < frames; ++i) {
+                        for (int k = 0; k < outputs; ++k) {
+                              float* p = buffer.data() + k * blockSize + i * 2;
+                              p[0] = *q++ * gain;
+                              p[1] = *q++ * gain;
+                              }
                         }
-                  playTime = endTime;
-                  pBar->setValue(playTime);
-                  if (playTime >= et)
-                        break;
+                  for (int k = 0; k < outputs; ++k)
+                        sf_writef_float(sf[k], buffer.data() + k * blockSize, frames);
+                  pos += frames;
+                  pBar->setValue(et + pos);
                   }
-            gain = 0.99 / peak;
             }
 
       hideProgressBar();
 
-      MScore::sampleRate = oldSampleRate;
-      delete synti;
-      if (sf_close(sf)) {
-            qDebug("close soundfile failed\n");
-            return false;
+      foreach(SNDFILE* f, sf) {
+            if (sf_close(f)) {
+                  qDebug("close soundfile failed\n");
+                  ok = false;
+                  }
             }
-
-      return true;
+      return ok;
       }
 
 #endif // HAS_AUDIOFILE
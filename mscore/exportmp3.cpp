@@ -19,7 +19,7 @@
 //=============================================================================
 
 #include "libmscore/score.h"
-#include "fluid/fluid.h"
+#include "msynth/render.h"
 #include "libmscore/note.h"
 #include "musescore.h"
 #include "libmscore/part.h"
@@ -645,7 +645,6 @@ bool MuseScore::saveMp3(Score* score, const QString& name)
 
       int channels = 2;
 
-      int oldSampleRate = MScore::sampleRate;
       int sampleRate = preferences.exportAudioSampleRate;
 
       exporter.setMode(MODE_CBR);
@@ -660,7 +659,6 @@ bool MuseScore::saveMp3(Score* score, const QString& name)
                      QString::null, QString::null);
                   }
             qDebug("Unable to initialize MP3 stream\n");
-            MScore::sampleRate = oldSampleRate;
             return false;
             }
 
@@ -672,138 +670,98 @@ bool MuseScore::saveMp3(Score* score, const QString& name)
                      tr("Unable to open target file for writing"),
                      QString::null, QString::null);
                   }
-            MScore::sampleRate = oldSampleRate;
             return false;
             }
 
       int bufferSize   = exporter.getOutBufferSize();
       uchar* bufferOut = new uchar[bufferSize];
-      MasterSynth* synti = new MasterSynth();
-      synti->init(sampleRate);
-      synti->setState(score->syntiState());
-
-      EventMap events;
-      score->toEList(&events);
+      static const int FRAMES = 512;
+      ScoreRenderer renderer(score, sampleRate, score->syntiState(), FRAMES,
+         preferences.synthSettings());
+      renderer.setRenderThreads(QThread::idealThreadCount());
+
+      //
+      // rendered once; with normalization the unscaled output
+      // goes to a temporary float file while the peak is
+      // measured, and is scaled when the file is encoded
+      //
+      bool normalize = preferences.exportAudioNormalize;
+      QTemporaryFile tmp;
+      if (normalize) {
+            if (!tmp.open()) {
+                  qDebug("cannot open temporary file for mp3 export\n");
+                  delete[] bufferOut;
+                  return false;
+                  }
+            renderer.synth()->setGain(1.0);
+            }
 
       QProgressBar* pBar = showProgressBar();
       pBar->reset();
 
-      static const int FRAMES = 512;
+      float buffer[FRAMES * 2];
       float bufferL[FRAMES];
       float bufferR[FRAMES];
-
-      float  peak = 0.0;
-      double gain = 1.0;
-      for (int pass = 0; pass < 2; ++pass) {
-            EventMap::const_iterator playPos;
-            playPos = events.constBegin();
-            EventMap::const_iterator endPos = events.constEnd();
-            --endPos;
-            double et = score->utick2utime(endPos.key());
-            et += 1.0;   // add trailer (sec)
-            pBar->setRange(0, int(et));
-
-            //
-            // init instruments
-            //
-            foreach(const Part* part, score->parts()) {
-                  foreach(const Channel& a, part->instr()->channel()) {
-                        a.updateInitList();
-                        foreach(Event e, a.init) {
-                              if (e.type() == ME_INVALID)
-                                    continue;
-                              e.setChannel(a.channel);
-                              int syntiIdx= score->midiMapping(a.channel)->articulation->synti;
-                              synti->play(e, syntiIdx);
-                              }
-                        }
+      float* out   = buffer;
+      float peak   = 0.0;
+      float gain   = 1.0;
+      bool ok      = true;
+      const int et = renderer.frames();
+      pBar->setRange(0, normalize ? 2 * et : et);
+
+      for (int pass = normalize ? 0 : 1; ok && pass < 2; ++pass) {
+            if (pass == 1 && normalize) {
+                  gain = peak > 0.0 ? 0.99 / peak : 1.0;
+                  tmp.seek(0);
                   }
-
-            double playTime = 0.0;
-            synti->setGain(gain);
-
+            int pos = 0;
             for (;;) {
-                  unsigned frames = FRAMES;
-                  //
-                  // collect events for one segment
-                  //
-                  memset(bufferL, 0, sizeof(float) * FRAMES);
-                  memset(bufferR, 0, sizeof(float) * FRAMES);
-                  double endTime = playTime + double(frames)/double(sampleRate);
-
-                  float* l = bufferL;
-                  float* r = bufferR;
-
-                  for (; playPos != events.constEnd(); ++playPos) {
-                        double f = score->utick2utime(playPos.key());
-                        if (f >= endTime)
-                              break;
-                        int n = lrint((f - playTime) * sampleRate);
-                        if (n) {
-                              float bu[n * 2];
-                              memset(bu, 0, sizeof(float) * 2 * n);
-
-                              synti->process(n, bu);
-                              float* sp = bu;
-                              for (int i = 0; i < n; ++i) {
-                                    *l++ = *sp++;
-                                    *r++ = *sp++;
-                                    }
-                              playTime += double(n)/double(sampleRate);
-                              frames    -= n;
-                              }
-                        const Event& e = playPos.value();
-                        if (e.isChannelEvent()) {
-                              int channelIdx = e.channel();
-                              Channel* c = score->midiMapping(channelIdx)->articulation;
-                              if (!c->mute) {
-                                    synti->play(e, c->synti);
-                                    }
-                              }
-                        }
-                  if (frames) {
-                        float bu[frames * 2];
-                        memset(bu, 0, sizeof(float) * 2 * frames);
-                        synti->process(frames, bu);
-                        float* sp = bu;
-                        for (unsigned i = 0; i < frames; ++i) {
-                              *l++ = *sp++;
-                              *r++ = *sp++;
-                              }
-                        playTime += double(frames)/double(sampleRate);
-                        }
-                  if (pass == 1) {
-                        long bytes;
-                        if (FRAMES < inSamples)
-                              bytes = exporter.encodeRemainder(bufferL, bufferR,  FRAMES , bufferOut);
-                        else
-                              bytes = exporter.encodeBuffer(bufferL, bufferR, bufferOut);
-                        if (bytes < 0) {
-                              if (noGui)
-                                    printf("exportmp3: error from encoder: %ld\n", bytes);
-                              else {
-                                    QMessageBox::warning(0,
-                                       tr("Encoding error"),
-                                       tr("Error %1 returned from MP3 encoder").arg(bytes),
-                                       QString::null, QString::null);
+                  int frames;
+                  if (pass == 0 || !normalize) {
+                        frames = renderer.render(&out);
+                        if (pass == 0) {
+                              for (int i = 0; i < frames * 2; ++i)
+                                    peak = qMax(peak, qAbs(buffer[i]));
+                              qint64 n = frames * 2 * sizeof(float);
+                              if (tmp.write((const char*)buffer, n) != n) {
+                                    qDebug("write to temporary file failed\n");
+                                    ok = false;
                                     break;
                                     }
                               }
-                        else
-                              file.write((char*)bufferOut, bytes);
                         }
-                  else {
-                        for (int i = 0; i < FRAMES; ++i) {
-                              peak = qMax(peak, qAbs(bufferL[i]));
-                              peak = qMax(peak, qAbs(bufferR[i]));
+                  else
+                        frames = tmp.read((char*)buffer, sizeof(buffer)) / (2 * sizeof(float));
+                  if (frames <= 0)
+                        break;
+                  pos += frames;
+                  pBar->setValue(pass == 1 && normalize ? et + pos : pos);
+                  if (pass == 0)
+                        continue;
+
+                  for (int i = 0; i < frames; ++i) {
+                        bufferL[i] = buffer[i * 2]     * gain;
+                        bufferR[i] = buffer[i * 2 + 1] * gain;
+                        }
+                  long bytes;
+                  if (frames < inSamples)
+                        bytes = exporter.encodeRemainder(bufferL, bufferR, frames, bufferOut);
+                  else
+                        bytes = exporter.encodeBuffer(bufferL, bufferR, bufferOut);
+                  if (bytes < 0) {
+                        if (noGui)
+                              printf("exportmp3: error from encoder: %ld\n", bytes);
+                        else {
+                              QMessageBox::warning(0,
+                                 tr("Encoding error"),
+                                 tr("Error %1 returned from MP3 encoder").arg(bytes),
+                                 QString::null, QString::null);
+                              break;
                               }
                         }
-                  playTime = endTime;
-                  pBar->setValue(int(playTime));
-                  if (playTime > et)
-                        break;
+                  else
+                        file.write((char*)bufferOut, bytes);
                   }
-            gain = 0.99 / peak;
             }
 
       long bytes = exporter.finishStream(bufferOut);
@@ -811,10 +769,8 @@ bool MuseScore::saveMp3(Score* score, const QString& name)
             file.write((char*)bufferOut, bytes);
 
       hideProgressBar();
-      delete synti;
-      delete bufferOut;
+      delete[] bufferOut;
       file.close();
-      MScore::sampleRate = oldSampleRate;
-      return true;
+      return ok;
       }
 
@@ -240,6 +240,7 @@ public:
 //---------------------------------------------------------
 
 typedef QHash<const Chord*, const Trill*> TrillHash;
+typedef QList<int> IntVector;
 
 class ExportMusicXml {
       Score* score;
@@ -250,6 +251,7 @@ class ExportMusicXml {
       Attributes attr;
       TextLine const* bracket[MAX_BRACKETS];
       int div;
+      IntVector integers;           // time values collected by calcDivisions()
       double millimeters;
       int tenths;
       TrillHash trillStart;
@@ -730,13 +732,9 @@ static void findTrills(Measure* measure, int strack, int etrack, TrillHash& tril
 // helpers for ::calcDivisions
 //---------------------------------------------------------
 
-typedef QList<int> IntVector;
-static IntVector integers;
-static IntVector primes;
-
 // check if all integers can be divided by d
 
-static bool canDivideBy(int d)
+static bool canDivideBy(const IntVector& integers, int d)
       {
       bool res = true;
       for (int i = 0; i < integers.count(); i++) {
@@ -749,14 +747,14 @@ static bool canDivideBy(int d)
 
 // divide all integers by d
 
-static void divideBy(int d)
+static void divideBy(IntVector& integers, int d)
       {
       for (int i = 0; i < integers.count(); i++) {
             integers[i] /= d;
             }
       }
 
-static void addInteger(int len)
+static void addInteger(IntVector& integers, int len)
       {
       if (!integers.contains(len)) {
             integers.append(len);
@@ -773,13 +771,13 @@ void ExportMusicXml::calcDivMoveToTick(int t)
 #ifdef DEBUG_TICK
             qDebug("backup %d\n", tick - t);
 #endif
-            addInteger(tick - t);
+            addInteger(integers, tick - t);
             }
       else if (t > tick) {
 #ifdef DEBUG_TICK
             qDebug("forward %d\n", t - tick);
 #endif
-            addInteger(t - tick);
+            addInteger(integers, t - tick);
             }
       tick = t;
       }
@@ -806,8 +804,8 @@ static bool isTwoNoteTremolo(Chord* chord);
 void ExportMusicXml::calcDivisions()
       {
       // init
+      IntVector primes;
       integers.clear();
-      primes.clear();
       integers.append(MScore::division);
       primes.append(2);
       primes.append(3);
@@ -861,7 +859,7 @@ void ExportMusicXml::calcDivisions()
 #ifdef DEBUG_TICK
                                     qDebug("chordrest %d", l);
 #endif
-                                    addInteger(l);
+                                    addInteger(integers, l);
                                     tick += l;
                                     }
                               }
@@ -873,8 +871,8 @@ void ExportMusicXml::calcDivisions()
 
       // do it: divide by all primes as often as possible
       for (int u = 0; u < primes.count(); u++)
-            while (canDivideBy(primes[u]))
-                  divideBy(primes[u]);
+            while (canDivideBy(integers, primes[u]))
+                  divideBy(integers, primes[u]);
 
       div = MScore::division / integers[0];
 #ifdef DEBUG_TICK
@@ -1562,6 +1562,83 @@ bool MuseScore::exportFile()
       return saveAs(cs, true, fn, ext);
       }
 
+//---------------------------------------------------------
+//   PartExportJob
+//---------------------------------------------------------
+
+struct PartExportJob {
+      Score* score;
+      QString fn;
+      QString ext;
+      bool ok;
+      };
+
+//---------------------------------------------------------
+//   isConcurrentExport
+//    return true if the writer for ext has no gui or
+//    global state dependencies and can run in a
+//    worker thread
+//    The midi writer is not: it rebuilds the repeat list,
+//    which all excerpts share with the root score.
+//---------------------------------------------------------
+
+static bool isConcurrentExport(const QString& ext)
+      {
+      return ext == "xml" || ext == "mxl";
+      }
+
+//---------------------------------------------------------
+//   exportPartJob
+//    called from QtConcurrent worker threads
+//---------------------------------------------------------
+
+static void exportPartJob(PartExportJob& job)
+      {
+      if (job.ext == "xml")
+            job.ok = saveXml(job.score, job.fn);
+      else if (job.ext == "mxl")
+            job.ok = saveMxl(job.score, job.fn);
+      }
+
+//---------------------------------------------------------
+//   exportPartsConcurrent
+//    write all part scores in parallel; the writers only
+//    read their part score and the state it shares with
+//    the root score
+//    return true on success
+//---------------------------------------------------------
+
+bool MuseScore::exportPartsConcurrent(QList<PartExportJob>& jobs)
+      {
+      for (int i = 0; i < jobs.size(); ++i)
+            jobs[i].score->setSyntiState(synti->state());
+
+      QProgressDialog progress(tr("Exporting parts..."), tr("Cancel"), 0, jobs.size(), this);
+      progress.setWindowTitle(tr("MuseScore: Export Parts"));
+      progress.setWindowModality(Qt::WindowModal);
+
+      QFutureWatcher<void> watcher;
+      connect(&watcher,  SIGNAL(finished()), &progress, SLOT(reset()));
+      connect(&progress, SIGNAL(canceled()), &watcher,  SLOT(cancel()));
+      connect(&watcher,  SIGNAL(progressRangeChanged(int,int)), &progress, SLOT(setRange(int,int)));
+      connect(&watcher,  SIGNAL(progressValueChanged(int)), &progress, SLOT(setValue(int)));
+
+      watcher.setFuture(QtConcurrent::map(jobs, exportPartJob));
+      progress.exec();
+      watcher.waitForFinished();
+
+      if (watcher.isCanceled())
+            return false;
+      foreach(const PartExportJob& job, jobs) {
+            if (!job.ok) {
+                  QMessageBox::critical(this, tr("MuseScore: Export Parts"),
+                     tr("Cannot write part file\n%1").arg(job.fn));
+                  return false;
+                  }
+            }
+      return true;
+      }
+
 //---------------------------------------------------------
 //   exportParts
 //    return true on success
@@ -1610,6 +1687,7 @@ bool MuseScore::exportParts()
       if (thisScore->parentScore())
             thisScore = thisScore->parentScore();
 
+      QList<PartExportJob> jobs;
       foreach(Excerpt* e, thisScore->excerpts())  {
             Score* pScore = e->score();
             QString partfn = fn + QDir::separator() + thisScore->name() + "-" + pScore->name();
@@ -1638,9 +1716,26 @@ bool MuseScore::exportParts()
             if (fi.suffix() != ext)
                   partfn += "." + ext;
 
-            if (!saveAs(pScore, true, partfn, ext))
+            PartExportJob job;
+            job.score = pScore;
+            job.fn    = partfn;
+            job.ext   = ext;
+            job.ok    = false;
+            jobs.append(job);
+            }
+      if (jobs.isEmpty())
+            return false;
+
+      if (jobs.size() > 1 && isConcurrentExport(jobs.front().ext)) {
+            if (!exportPartsConcurrent(jobs))
                   return false;
             }
+      else {
+            foreach(const PartExportJob& job, jobs) {
+                  if (!saveAs(job.score, true, job.fn, job.ext))
+                        return false;
+                  }
+            }
       QMessageBox::information(this, tr("MuseScore: Export Parts"), tr("Parts were successfully exported"));
       return true;
       }
@@ -2254,6 +2349,7 @@ bool MuseScore::saveSvg(Score* score, const QString& saveName)
       {
       SvgGenerator printer;
       printer.setResolution(converterDpi);
+      printer.setOptimized(svgOptimized);
       QString title(score->metaTag("workTitle"));
       if(title.isEmpty())
             title = "MuseScore";
@@ -30,6 +30,20 @@ extern bool midiOutputTrace;  ///< debug option: dump midi output
 extern bool noGui;
 extern bool converterMode;
 extern double converterDpi;
+extern bool svgOptimized;     ///< write compact svg; cmd line option.
+
+//---------------------------------------------------------
+//   AudioStems
+//    what MuseScore::saveAudio() writes
+//---------------------------------------------------------
+
+enum AudioStems {
+      AUDIO_MIX,              // the full mix
+      AUDIO_STEMS,            // one file per part
+      AUDIO_STEMS_MIX         // one file per part and the full mix
+      };
+
+extern AudioStems audioStems; ///< audio export mode; cmd line option.
 
 //---------------------------------------------------------
 //    ScoreState
@@ -89,6 +89,7 @@
 #include "libmscore/lasso.h"
 
 #include "msynth/synti.h"
+#include "fluid/sfont.h"
 
 MuseScore* mscore;
 
@@ -103,6 +104,8 @@ bool externalIcons = false;
 static bool pluginMode = false;
 static bool startWithNewScore = false;
 double converterDpi = 0;
+bool svgOptimized = false;
+AudioStems audioStems = AUDIO_MIX;
 
 QString mscoreGlobalShare;
 static QStringList recentScores;
@@ -1319,12 +1322,16 @@ static void usage()
         "   -O        dump midi output\n"
         "   -o file   export to 'file'; format depends on file extension\n"
         "   -r dpi    set output resolution for image export\n"
+        "   -G        write compact svg with shared glyph definitions\n"
         "   -S style  load style file\n"
         "   -p name   execute named plugin\n"
         "   -F        use factory settings\n"
         "   -i        load icons from INSTALLPATH/icons\n"
         "   -e        enable experimental features\n"
         "   -c dir    override config/settings directory\n"
+        "   -C dir    cache decoded sf3 samples in 'dir'\n"
+        "   -T        audio export: write one file per part\n"
+        "   -X        audio export: write one file per part and the full mix\n"
         );
       exit(-1);
       }
@@ -2051,11 +2058,11 @@ static bool processNonGui()
                   return mscore->saveLilypond(cs, fn);
 #ifdef HAS_AUDIOFILE
             if (fn.endsWith(".wav"))
-                  return mscore->saveAudio(cs, fn, "wav");
+                  return mscore->saveAudio(cs, fn, "wav", audioStems);
             if (fn.endsWith(".ogg"))
-                  return mscore->saveAudio(cs, fn, "ogg");
+                  return mscore->saveAudio(cs, fn, "ogg", audioStems);
             if (fn.endsWith(".flac"))
-                  return mscore->saveAudio(cs, fn, "flac");
+                  return mscore->saveAudio(cs, fn, "flac", audioStems);
 #endif
             if (fn.endsWith(".mp3"))
                   return mscore->saveMp3(cs, fn);
@@ -2218,6 +2225,15 @@ int main(int argc, char* av[])
                               usage();
                         converterDpi = argv.takeAt(i + 1).toDouble();
                         break;
+                  case 'G':
+                        svgOptimized = true;
+                        break;
+                  case 'T':
+                        audioStems = AUDIO_STEMS;
+                        break;
+                  case 'X':
+                        audioStems = AUDIO_STEMS_MIX;
+                        break;
                   case 'S':
                         if (argv.size() - i < 2)
                               usage();
@@ -2242,6 +2258,11 @@ int main(int argc, char* av[])
                               }
                         }
                         break;
+                  case 'C':
+                        if (argv.size() - i < 2)
+                              usage();
+                        FluidS::SFont::setSampleCacheDir(argv.takeAt(i + 1));
+                        break;
                   default:
                         usage();
                   }
@@ -83,6 +83,7 @@ class MasterPalette;
 class PluginCreator;
 
 struct PluginDescription;
+struct PartExportJob;
 
 extern QString mscoreGlobalShare;
 static const int PROJECT_LIST_LEN = 6;
@@ -579,6 +580,7 @@ class MuseScore : public QMainWindow {
       void printFile();
       bool exportFile();
       bool exportParts();
+      bool exportPartsConcurrent(QList<PartExportJob>&);
       bool saveAs(Score*, bool saveCopy, const QString& path, const QString& ext);
       bool savePsPdf(const QString& saveName, QPrinter::OutputFormat format);
       bool savePsPdf(Score* cs, const QString& saveName, QPrinter::OutputFormat format);
@@ -591,7 +593,7 @@ class MuseScore : public QMainWindow {
       void addImage(Score*, Element*);
 
       bool savePng(Score*, const QString& name, bool screenshot, bool transparent, double convDpi, QImage::Format format);
-      bool saveAudio(Score*, const QString& name, const QString& type);
+      bool saveAudio(Score*, const QString& name, const QString& type, AudioStems stems = AUDIO_MIX);
       bool saveMp3(Score*, const QString& name);
       bool saveSvg(Score*, const QString& name);
       bool savePng(Score*, const QString& name);
@@ -128,6 +128,7 @@ void Navigator::setScoreView(ScoreView* v)
       _cv = QPointer<ScoreView>(v);
       if (v) {
             _score  = v->score();
+            pcl.clear();
             rescale();
             connect(this, SIGNAL(viewRectMoved(const QRectF&)), v, SLOT(setViewRect(const QRectF&)));
             connect(_cv,  SIGNAL(viewRectChanged()), this, SLOT(updateViewRect()));
@@ -315,8 +316,8 @@ static void createPixmap(PageCache* pc)
             return;
             }
 
-      pc->pm = QImage(pageRect.size(), QImage::Format_ARGB32_Premultiplied);
-      QPainter p(&pc->pm);
+      QImage pm(pageRect.size(), QImage::Format_ARGB32_Premultiplied);
+      QPainter p(&pm);
 
       QColor _fgColor(Qt::white);
       QColor _bgColor(Qt::darkGray);
@@ -334,11 +335,41 @@ static void createPixmap(PageCache* pc)
             p.setPen(QColor(0, 0, 255, 50));
             p.drawText(pc->page->bbox(), Qt::AlignCenter, QString("%1").arg(pc->page->no()+1));
             }
-      
+      p.end();
+
+      pc->pm    = pm;
+      pc->scale = pc->matrix.m11();
       pc->navigator->update(pageRect);
       pc->valid = true;
       }
 
+//---------------------------------------------------------
+//   fitPixmap
+//    try to reuse a thumbnail rendered at another zoom
+//    level; a larger one is scaled down, a smaller one is
+//    kept only as placeholder until the page is rendered
+//    again
+//    return true if the thumbnail is valid for the
+//    current scale
+//---------------------------------------------------------
+
+static bool fitPixmap(PageCache* pc)
+      {
+      if (pc->pm.isNull())
+            return false;
+      qreal scale = pc->matrix.m11();
+      if (qFuzzyCompare(pc->scale, scale))
+            return true;
+      if (pc->scale < scale)
+            return false;
+      QRect pageRect = pc->matrix.mapRect(pc->page->bbox()).toRect();
+      if (pageRect.width() == 0 || pageRect.height() == 0)
+            return false;
+      pc->pm    = pc->pm.scaled(pageRect.size(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+      pc->scale = scale;
+      return true;
+      }
+
 //---------------------------------------------------------
 //   layoutChanged
 //---------------------------------------------------------
@@ -358,13 +389,31 @@ void Navigator::layoutChanged()
       int n = _score->pages().size();
 //      if (n != pcl.size())
             rescale();
+
+      // keep the thumbnails of all pages the last layout
+      // did not change
+      QHash<Page*, int> oldIdx;
+      for (int i = 0; i < pcl.size(); ++i)
+            oldIdx.insert(pcl[i].page, i);
+      QList<PageCache> opcl(pcl);
       pcl.clear();
+
+      QReadLocker locker(_score->layoutLock());
       for (int i = 0; i < n; ++i) {
+            Page* page = _score->pages()[i];
             PageCache pc;
-            pc.page      = _score->pages()[i];
-            pc.matrix    = matrix;
-            pc.valid     = false;
-            pc.navigator = this;
+            pc.page       = page;
+            pc.layoutHash = page->layoutHash();
+            pc.scale      = 0.0;
+            pc.matrix     = matrix;
+            pc.valid      = false;
+            pc.navigator  = this;
+            int idx = oldIdx.value(page, -1);
+            if (idx != -1 && opcl[idx].layoutHash == pc.layoutHash) {
+                  pc.pm    = opcl[idx].pm;
+                  pc.scale = opcl[idx].scale;
+                  pc.valid = fitPixmap(&pc);
+                  }
             pcl.append(pc);
             }
       update();
@@ -406,11 +455,17 @@ void Navigator::paintEvent(QPaintEvent* ev)
                         if (pc.valid) {
                               QPixmap pm = QPixmap::fromImage(pc.pm);
                               p.drawPixmap(rr.topLeft(), pm);
+                              region -= rr;
                               }
                         else {
+                              // show thumbnail of the previous zoom step
+                              // until the page is rendered again
+                              if (!pc.pm.isNull()) {
+                                    p.drawImage(rr, pc.pm);
+                                    region -= rr;
+                                    }
                               npcl.append(&pcl[i]);
                               }
-                        region -= rr;
                         }
                   }
             }
@@ -47,6 +47,8 @@ class NScrollArea : public QScrollArea {
 struct PageCache {
       bool valid;
       Page* page;
+      uint layoutHash;        // Page::layoutHash() of the page when pm was rendered
+      qreal scale;            // scale pm was rendered with
       QImage pm;
       QTransform matrix;
       Navigator* navigator;
@@ -83,6 +83,7 @@ Palette::Palette(QWidget* parent)
       setSizeIncrement(QSize(hgrid, vgrid));
       setBaseSize(QSize(hgrid, vgrid));
       setReadOnly(false);
+      connect(&scaledImageCache, SIGNAL(imageReady(const QByteArray&)), SLOT(update()));
       }
 
 Palette::~Palette()
@@ -538,62 +539,93 @@ void Palette::paintEvent(QPaintEvent* event)
                   p.drawPixmap(x + (hhgrid - size) / 2, y + (vgrid - size) / 2, pm);
                   }
             else {
+                  PaletteCell* cell = cells[idx];
                   int row    = idx / columns();
                   int column = idx % columns();
 
-                  el->layout();
-                  el->setPos(0.0, 0.0);
-
-                  qreal cellMag = cells[idx]->mag * mag;
-                  if (drawStaff) {
-                        qreal y = r.y() + vgrid * .5 - dy + _yOffset * _spatium * cellMag;
-                        qreal x = r.x() + 3;
-                        qreal w = hhgrid - 6;
-                        for (int i = 0; i < 5; ++i) {
-                              qreal yy = y + PALETTE_SPATIUM * i * extraMag;
-                              p.drawLine(QLineF(x, yy, x + w, yy));
+                  QColor color;
+                  if (idx != selectedIdx) {
+                        // show voice colors for notes
+                        if (el->type() == Element::CHORD) {
+                              el->setSelected(true);
+                              color = el->curColor();
                               }
+                        else
+                              color = palette().color(QPalette::Normal, QPalette::Text);
                         }
-                  p.save();
-                  p.scale(cellMag, cellMag);
+                  else
+                        color = palette().color(QPalette::Normal, QPalette::HighlightedText);
 
+                  qreal cellMag = cell->mag * mag;
                   double gw = hhgrid / cellMag;
                   double gh = vgrid / cellMag;
-                  double gx = column * gw + cells[idx]->xoffset * _spatium;
-                  double gy = row    * gh + cells[idx]->yoffset * _spatium;
+
+                  //
+                  // the cell is rendered into cell->pixmap and only
+                  // rendered again if one of the parameters changes
+                  //
+#if QT_VERSION >= 0x050100
+                  qreal dpr = devicePixelRatio();
+#else
+                  qreal dpr = 1.0;
+#endif
+                  QString key = QString("%1 %2 %3 %4 %5 %6 %7 %8 %9 %10 %11")
+                     .arg(cellMag).arg(hhgrid).arg(vgrid).arg(color.rgba())
+                     .arg(cell->xoffset).arg(cell->yoffset).arg(_yOffset).arg(dpr)
+                     .arg(MScore::defaultStyleGeneration())
+                     .arg(pen.color().rgba()).arg(drawStaff);
+                  bool render = key != cell->pixmapKey;
+                  if (render) {
+                        el->layout();
+                        el->setPos(0.0, 0.0);
+                        }
 
                   double sw = el->width();
                   double sh = el->height();
+                  double sx = cell->xoffset * _spatium + (gw - sw) * .5 - el->bbox().x();
                   double sy;
-
                   if (drawStaff)
-                        sy = gy + gh * .5 - 2.0 * _spatium;
+                        sy = cell->yoffset * _spatium + gh * .5 - 2.0 * _spatium;
                   else
-                        sy  = gy + (gh - sh) * .5 - el->bbox().y();
-                  double sx  = gx + (gw - sw) * .5 - el->bbox().x();
-
+                        sy = cell->yoffset * _spatium + (gh - sh) * .5 - el->bbox().y();
                   sy += _yOffset * _spatium;
 
-                  p.translate(sx, sy);
-                  cells[idx]->x = sx;
-                  cells[idx]->y = sy;
-
-                  QColor color;
-                  if (idx != selectedIdx) {
-                        // show voice colors for notes
-                        if (el->type() == Element::CHORD) {
-                              el->setSelected(true);
-                              color = el->curColor();
+                  cell->x = column * gw + sx;
+                  cell->y = row    * gh + sy;
+
+                  if (render) {
+                        QPixmap pm(lrint(hhgrid * dpr), lrint(vgrid * dpr));
+                        pm.fill(Qt::transparent);
+#if QT_VERSION >= 0x050100
+                        pm.setDevicePixelRatio(dpr);
+#endif
+                        QPainter pp(&pm);
+                        pp.setRenderHint(QPainter::Antialiasing, true);
+                        pp.setPen(pen);
+                        if (drawStaff) {
+                              qreal y = vgrid * .5 - dy + _yOffset * _spatium * cellMag;
+                              qreal x = 3;
+                              qreal w = hhgrid - 6;
+                              for (int i = 0; i < 5; ++i) {
+                                    qreal yy = y + PALETTE_SPATIUM * i * extraMag;
+                                    pp.drawLine(QLineF(x, yy, x + w, yy));
+                                    }
                               }
-                        else
-                              color = palette().color(QPalette::Normal, QPalette::Text);
+                        pp.scale(cellMag, cellMag);
+                        pp.translate(sx, sy);
+                        pp.setPen(QPen(color));
+                        el->scanElements(&pp, paintPaletteElement);
+                        pp.end();
+                        cell->pixmap    = pm;
+                        //
+                        // do not keep a placeholder image; imageReady()
+                        // repaints the palette once the scaled image
+                        // is ready
+                        //
+                        if (el->type() != Element::IMAGE || !static_cast<Image*>(el)->placeholder())
+                              cell->pixmapKey = key;
                         }
-                  else
-                        color = palette().color(QPalette::Normal, QPalette::HighlightedText);
-
-                  p.setPen(QPen(color));
-                  el->scanElements(&p, paintPaletteElement);
-                  p.restore();
+                  p.drawPixmap(r.topLeft(), cell->pixmap);
                   }
             }
       }
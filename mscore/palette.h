@@ -44,6 +44,8 @@ struct PaletteCell {
       double xoffset, yoffset;      // in spatium units of "gscore"
       qreal mag;
       bool readOnly;
+      QPixmap pixmap;         // cached rendering of element
+      QString pixmapKey;      // render parameters of pixmap
       };
 
 //---------------------------------------------------------
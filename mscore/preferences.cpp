@@ -227,6 +227,7 @@ void Preferences::init()
 #endif
 
       exportAudioSampleRate   = exportAudioSampleRates[0];
+      exportAudioNormalize    = true;
 
       profile                 = "default";
 
@@ -359,6 +360,7 @@ void Preferences::write()
       s.setValue("vraster", MScore::vRaster());
       s.setValue("nativeDialogs", nativeDialogs);
       s.setValue("exportAudioSampleRate", exportAudioSampleRate);
+      s.setValue("exportAudioNormalize", exportAudioNormalize);
 
       s.setValue("profile", profile);
 
@@ -390,6 +392,23 @@ void Preferences::write()
       Shortcut::dirty = false;
       }
 
+//---------------------------------------------------------
+//   synthSettings
+//---------------------------------------------------------
+
+SynthSettings Preferences::synthSettings() const
+      {
+      SynthSettings s;
+      s.tuning         = tuning;
+      s.masterGain     = masterGain;
+      s.reverbRoomSize = reverbRoomSize;
+      s.reverbDamp     = reverbDamp;
+      s.reverbWidth    = reverbWidth;
+      s.reverbGain     = reverbGain;
+      s.chorusGain     = chorusGain;
+      return s;
+      }
+
 //---------------------------------------------------------
 //   read
 //---------------------------------------------------------
@@ -530,6 +549,7 @@ void Preferences::read()
 
       nativeDialogs    = s.value("nativeDialogs", nativeDialogs).toBool();
       exportAudioSampleRate = s.value("exportAudioSampleRate", exportAudioSampleRate).toInt();
+      exportAudioNormalize  = s.value("exportAudioNormalize", exportAudioNormalize).toBool();
 
       profile          = s.value("profile", profile).toString();
 
@@ -1004,6 +1024,7 @@ void PreferenceDialog::updateValues(Preferences* p)
       if (idx == n)     // if not found in table
             idx = 0;
       exportAudioSampleRate->setCurrentIndex(idx);
+      exportAudioNormalize->setChecked(p->exportAudioNormalize);
 
       //
       //  update plugin manager
@@ -1341,6 +1362,7 @@ void PreferenceDialog::apply()
       preferences.nativeDialogs      = nativeDialogs->isChecked();
       int idx = exportAudioSampleRate->currentIndex();
       preferences.exportAudioSampleRate = exportAudioSampleRates[idx];
+      preferences.exportAudioNormalize  = exportAudioNormalize->isChecked();
 
       preferences.showSplashScreen   = showSplashScreen->isChecked();
       preferences.midiExpandRepeats  = expandRepeats->isChecked();
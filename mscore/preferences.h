@@ -24,6 +24,8 @@
 #include "globals.h"
 #include "shortcut.h"
 
+struct SynthSettings;
+
 enum SessionStart {
       EMPTY_SESSION, LAST_SESSION, NEW_SESSION, SCORE_SESSION
       };
@@ -173,6 +175,7 @@ struct Preferences {
       bool nativeDialogs;
 
       int exportAudioSampleRate;
+      bool exportAudioNormalize;    // scale exported audio to full level
 
       QString profile;
 
@@ -191,6 +194,7 @@ struct Preferences {
       void read();
       void init();
       bool readDefaultStyle();
+      SynthSettings synthSettings() const;
       };
 
 //---------------------------------------------------------
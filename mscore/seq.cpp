@@ -74,40 +74,192 @@ static const int peakHoldTime = 1400;     // msec
 static const int peakHold     = (peakHoldTime * guiRefresh) / 1000;
 static OggVorbis_File vf;
 
-static const int AUDIO_BUFFER_SIZE = 1024 * 512;  // 2 MB
+static const int AUDIO_BUFFER_SIZE = 1024 * 512;  // 2 MB, must be power of two
+static const int RENDER_BLOCK      = 256;         // frames rendered at once
+static const int PRERENDER_FRAMES  = 8192;        // max. frames rendered ahead
+static const int PREDECODE_FRAMES  = 65536;       // max. frames of an audio track decoded ahead
 
 //---------------------------------------------------------
 //   RenderAudio
 //    the prerendering audio thread
+//
+//    While the sequencer plays, this thread owns the
+//    synthesizer and the play position. It processes the
+//    gui messages, plays the events and renders up to
+//    PRERENDER_FRAMES ahead into a lock free single
+//    producer/single consumer ring buffer. The driver
+//    callback (Seq::process()) only copies out of it.
+//    When the score plays its audio track instead, the
+//    thread owns the ogg decoder and decodes up to
+//    PREDECODE_FRAMES ahead.
+//
+//    - the render thread writes widx
+//    - the driver thread writes ridx
+//    - indices count frames and are never wrapped, the
+//      fifo position is index & mask
 //---------------------------------------------------------
 
 class RenderAudio : public QThread
       {
+      Seq* seq;
       float fifo[AUDIO_BUFFER_SIZE];
-      int ridx;               // read index
-      int widx;               // write index
-      volatile int counter;   // objects in fifo
+      float block[RENDER_BLOCK * 2];
+      static const unsigned mask = AUDIO_BUFFER_SIZE / 2 - 1;     // stereo frames
+
+      QAtomicInt ridx;        // read index (frames)
+      QAtomicInt widx;        // write index (frames)
+      QAtomicInt flushIdx;    // set by writer after seek, -1 = none
+      QAtomicInt active;      // render thread owns synthesizer
+      QAtomicInt busy;        // render thread is processing
+      QAtomicInt atEnd;       // all events are rendered
+      QAtomicInt quit;
+      int prerender;          // max. frames ahead
+      int _underruns;
+      bool stopping;          // driver thread: stopRendering() called, not yet released()
+
+      static int load(QAtomicInt& v) { return v.fetchAndAddAcquire(0); }
+
+      void write(const float* p, int n) {
+            unsigned w = load(widx);
+            for (int i = 0; i < n; ++i) {
+                  unsigned idx = ((w + i) & mask) * 2;
+                  fifo[idx]     = *p++;
+                  fifo[idx + 1] = *p++;
+                  }
+            widx.fetchAndStoreRelease(w + n);
+            }
 
-      void clear() {
-	      ridx    = 0;
-            widx    = 0;
-            counter = 0;
+   public:
+      RenderAudio(Seq* s) : QThread() {
+            seq        = s;
+            prerender  = PRERENDER_FRAMES;
+            _underruns = 0;
+            ridx       = 0;
+            widx       = 0;
+            flushIdx   = -1;
+            active     = 0;
+            busy       = 0;
+            atEnd      = 0;
+            quit       = 0;
+            stopping   = false;
             }
 
-      void push() {
-//            widx = (widx + 1) % maxCount;
-//            ++counter;
+      //---------------------------------------------
+      //   run
+      //    render thread
+      //---------------------------------------------
+
+      void run() {
+            while (!load(quit)) {
+                  busy.fetchAndStoreOrdered(1);
+                  if (!load(active)) {
+                        busy.fetchAndStoreOrdered(0);
+                        msleep(2);
+                        continue;
+                        }
+                  seq->processMessages();
+                  int n = unsigned(load(widx)) - unsigned(load(ridx));
+                  bool render = !load(atEnd) && (n + RENDER_BLOCK <= prerender);
+                  if (render) {
+                        memset(block, 0, sizeof(block));
+                        seq->renderPlayback(RENDER_BLOCK, block);
+                        write(block, RENDER_BLOCK);
+                        if (seq->playEnd())
+                              atEnd.fetchAndStoreRelease(1);
+                        }
+                  busy.fetchAndStoreOrdered(0);
+                  if (!render)
+                        usleep(500);
+                  }
             }
 
-      void pop() {
-//            ridx = (ridx + 1) % maxCount;
-//            --counter;
+      //---------------------------------------------
+      //   startRendering
+      //    called in driver thread; hands over the
+      //    synthesizer to the render thread, which
+      //    keeps up to frames ahead
+      //---------------------------------------------
+
+      void startRendering(int frames) {
+            prerender = frames;
+            ridx.fetchAndStoreOrdered(load(widx));
+            flushIdx.fetchAndStoreOrdered(-1);
+            atEnd.fetchAndStoreOrdered(0);
+            active.fetchAndStoreOrdered(1);
             }
 
-   public:
-      RenderAudio() : QThread() {
+      //---------------------------------------------
+      //   stopRendering
+      //    called in driver thread; asks the render
+      //    thread to give back the synthesizer, which
+      //    it owns until released() returns true
+      //---------------------------------------------
+
+      void stopRendering() {
+            active.fetchAndStoreOrdered(0);
+            stopping = true;
             }
-      void run() {
+
+      //---------------------------------------------
+      //   released
+      //    called in driver thread after stopRendering();
+      //    true once the render thread has left its
+      //    current block; all prerendered audio is
+      //    discarded then
+      //---------------------------------------------
+
+      bool released() {
+            if (load(busy))
+                  return false;
+            ridx.fetchAndStoreOrdered(load(widx));
+            flushIdx.fetchAndStoreOrdered(-1);
+            stopping = false;
+            return true;
+            }
+
+      //---------------------------------------------
+      //   flush
+      //    called in render thread after seek; audio
+      //    rendered so far is dropped by the reader
+      //---------------------------------------------
+
+      void flush() {
+            flushIdx.fetchAndStoreRelease(load(widx));
+            atEnd.fetchAndStoreRelease(0);
+            }
+
+      //---------------------------------------------
+      //   read
+      //    called in driver thread; copy n frames to p,
+      //    missing frames are left silent
+      //---------------------------------------------
+
+      int read(float* p, int n) {
+            int f = flushIdx.fetchAndStoreAcquire(-1);
+            if (f != -1)
+                  ridx.fetchAndStoreRelease(f);
+            unsigned r = load(ridx);
+            int avail  = unsigned(load(widx)) - r;
+            int nn     = qMin(n, avail);
+            for (int i = 0; i < nn; ++i) {
+                  unsigned idx = ((r + i) & mask) * 2;
+                  *p++ = fifo[idx];
+                  *p++ = fifo[idx + 1];
+                  }
+            ridx.fetchAndStoreRelease(r + nn);
+            if (nn < n && !load(atEnd))
+                  ++_underruns;
+            return nn;
+            }
+
+      bool isActive()      { return load(active);   }
+      bool isStopping() const { return stopping;    }
+      bool finished()      { return load(atEnd) && (load(widx) == load(ridx)); }
+      int latency()        { return unsigned(load(widx)) - unsigned(load(ridx)); }
+      int underruns() const { return _underruns; }
+      void stop() {
+            quit.fetchAndStoreOrdered(1);
+            wait();
             }
       };
 
@@ -186,6 +338,7 @@ static long ovTell(void* datasource)
 Seq::Seq()
       {
       running         = false;
+      endReached      = false;
       playlistChanged = false;
       cs              = 0;
       cv              = 0;
@@ -194,7 +347,9 @@ Seq::Seq()
       state    = TRANSPORT_STOP;
       oggInit  = false;
       driver   = 0;
-      playPos  = events.constBegin();
+      playList = new SeqPlayList;
+      playIdx  = 0;
+      guiPos   = 0;
 
       playTime  = 0;
       metronomeVolume = 0.3;
@@ -214,6 +369,8 @@ Seq::Seq()
       connect(noteTimer, SIGNAL(timeout()), this, SLOT(stopNotes()));
       noteTimer->stop();
 
+      renderAudio = new RenderAudio(this);
+
       connect(this, SIGNAL(toGui(int)), this, SLOT(seqMessage(int)), Qt::QueuedConnection);
       }
 
@@ -223,6 +380,10 @@ Seq::Seq()
 
 Seq::~Seq()
       {
+      if (renderAudio->isRunning())
+            renderAudio->stop();
+      delete renderAudio;
+      delete playList;
       delete synti;
       delete driver;
       }
@@ -249,14 +410,14 @@ void Seq::stopWait()
 
 void Seq::setScoreView(ScoreView* v)
       {
-      if (oggInit) {
-            ov_clear(&vf);
-            oggInit = false;
-            }
       if (cv !=v && cs) {
             cs->setSyntiState(synti->state());
             markedNotes.clear();
             stopWait();
+            if (oggInit) {
+                  ov_clear(&vf);
+                  oggInit = false;
+                  }
             }
       cv = v;
       cs = cv ? cv->score() : 0;
@@ -388,8 +549,10 @@ bool Seq::init()
       MScore::sampleRate = driver->sampleRate();
       synti->init(MScore::sampleRate);
 
+      renderAudio->start(QThread::TimeCriticalPriority);
       if (!driver->start()) {
             qDebug("Cannot start I/O");
+            renderAudio->stop();
             return false;
             }
       running = true;
@@ -409,6 +572,8 @@ void Seq::exit()
             delete driver;
             driver = 0;
             }
+      if (renderAudio->isRunning())
+            renderAudio->stop();
       }
 
 //---------------------------------------------------------
@@ -456,6 +621,12 @@ void Seq::start()
       if (events.empty() || cs->playlistDirty() || playlistChanged)
             collectEvents();
       if (cs->playMode() == PLAYMODE_AUDIO) {
+            if (oggInit && vorbisData.data.constData() != cs->audio()->data().constData()) {
+                  // the audio track was replaced
+                  stopWait();
+                  ov_clear(&vf);
+                  oggInit = false;
+                  }
             if (!oggInit) {
                   vorbisData.pos  = 0;
                   vorbisData.data = cs->audio()->data();
@@ -467,6 +638,7 @@ void Seq::start()
                   }
             }
       seek(cs->playPos());
+      synti->setWorkersParked(false);
       driver->startTransport();
       }
 
@@ -479,17 +651,13 @@ void Seq::stop()
       {
       if (state == TRANSPORT_STOP)
             return;
-      if (oggInit) {
-            ov_clear(&vf);
-            oggInit = false;
-            }
       if (!driver)
             return;
       driver->stopTransport();
       if (cv)
             cv->setCursorOn(false);
       if (cs) {
-            cs->setPlayPos(playPos.key());
+            cs->setPlayPos(playUtick());
             cs->setLayoutAll(false);
             cs->setUpdateAll();
             cs->end();
@@ -555,7 +723,11 @@ void Seq::guiStop()
 void Seq::seqMessage(int msg)
       {
       switch(msg) {
+            case '2':         // STOP at end of score
+                  rewindStart();
+                  // fall through
             case '0':         // STOP
+                  synti->setWorkersParked(true);
                   guiStop();
 //                  heartBeatTimer->stop();
                   if (driver && mscore->getSynthControl()) {
@@ -570,6 +742,7 @@ void Seq::seqMessage(int msg)
                   break;
 
             case '1':         // PLAY
+                  synti->setWorkersParked(false);    // also if jack transport was started elsewhere
                   emit started();
 //                  heartBeatTimer->start(1000/guiRefresh);
                   break;
@@ -589,16 +762,33 @@ void Seq::seqMessage(int msg)
 void Seq::stopTransport()
       {
       state = TRANSPORT_STOP;
+      bool end = endReached;
+      endReached = false;
+      if (renderAudio->isActive())
+            renderAudio->stopRendering();
       if (cs == 0)
             return;
+      // with prerendering the sound is stopped in process() once
+      // the render thread has released the synthesizer
+      if (!renderAudio->isStopping())
+            stopSound();
+      emit toGui(end ? '2' : '0');      // the gui rewinds at end of score
+      }
+
+//---------------------------------------------------------
+//   stopSound
+//    stop all notes and send sustain off
+//    executed in realtime environment
+//---------------------------------------------------------
+
+void Seq::stopSound()
+      {
       stopNotes();
-      // send sustain off
       Event e;
       e.setType(ME_CONTROLLER);
       e.setController(CTRL_SUSTAIN);
       e.setValue(0);
       putEvent(e);
-      emit toGui('0');
       }
 
 //---------------------------------------------------------
@@ -611,6 +801,13 @@ void Seq::startTransport()
       {
       emit toGui('1');
       state = TRANSPORT_PLAY;
+      if (cs) {
+            // hand over pending messages (seek) and the synthesizer
+            // or the ogg decoder to the render thread
+            processMessages();
+            renderAudio->startRendering(cs->playMode() == PLAYMODE_AUDIO
+               ? PREDECODE_FRAMES : PRERENDER_FRAMES);
+            }
       }
 
 //---------------------------------------------------------
@@ -618,7 +815,7 @@ void Seq::startTransport()
 //    send one event to the synthesizer
 //---------------------------------------------------------
 
-void Seq::playEvent(const Event& event)
+void Seq::playEvent(const ChannelEvent& event)
       {
       int type = event.type();
       if (type == ME_NOTEON) {
@@ -652,22 +849,14 @@ void Seq::processMessages()
             SeqMsg msg = toSeq.dequeue();
             switch(msg.id) {
                   case SEQ_TEMPO_CHANGE:
-                        {
-                        if (playTime != 0) {
-                              int tick = cs->utime2utick(qreal(playTime) / qreal(MScore::sampleRate));
-                              cs->tempomap()->setRelTempo(msg.data.realVal);
-                              cs->repeatList()->update();
-                              playTime = cs->utick2utime(tick) * MScore::sampleRate;
-                              }
-                        else
-                              cs->tempomap()->setRelTempo(msg.data.realVal);
-                        }
+                  case SEQ_PLAYLIST:
+                        setPlayList(msg.data.playList, msg.id == SEQ_TEMPO_CHANGE);
                         break;
                   case SEQ_PLAY:
                         putEvent(msg.event);
                         break;
                   case SEQ_SEEK:
-                        setPos(msg.data.intVal);
+                        setPos(msg.data.pos.utick, msg.data.pos.frame);
                         break;
                   }
             }
@@ -709,85 +898,41 @@ void Seq::metronome(unsigned n, float* p)
       }
 
 //---------------------------------------------------------
-//   process
+//   renderPlayback
+//    play events and render or decode n frames of the
+//    current playlist into p; called in the render thread
 //---------------------------------------------------------
 
-void Seq::process(unsigned n, float* buffer)
+void Seq::renderPlayback(unsigned n, float* p)
       {
       unsigned frames = n;
-      int driverState = driver->getState();
-
-      if (driverState != state) {
-            if (state == TRANSPORT_STOP && driverState == TRANSPORT_PLAY)
-                  startTransport();
-            else if (state == TRANSPORT_PLAY && driverState == TRANSPORT_STOP)
-                  stopTransport();
-            else if (state != driverState)
-                  qDebug("Seq: state transition %d -> %d ?\n",
-                     state, driverState);
-            }
-
-      memset(buffer, 0, sizeof(float) * n * 2);
-      float* p = buffer;
-      processMessages();
-
-      if (state == TRANSPORT_PLAY) {
-            //
-            // play events for one segment
-            //
-            unsigned framePos = 0;
-            int endTime = playTime + frames;
-            for (; playPos != events.constEnd(); ++playPos) {
-                  int f = cs->utick2utime(playPos.key()) * MScore::sampleRate;
-                  if (f >= endTime)
-                        break;
-                  int n = f - playTime;
-                  if (n < 0) {
-                        qDebug("%d:  %d - %d\n", playPos.key(), f, playTime);
-      			n = 0;
-                        }
-                  if (n) {
-                        if (cs->playMode() == PLAYMODE_SYNTHESIZER) {
-                              metronome(n, p);
-                              synti->process(n, p);
-                              p += n * 2;
-                              playTime  += n;
-                              frames    -= n;
-                              framePos  += n;
-                              }
-                        else {
-                              while (n > 0) {
-                                    int section;
-                                    float** pcm;
-                                    long rn = ov_read_float(&vf, &pcm, n, &section);
-                                    if (rn == 0)
-                                          break;
-                                    for (int i = 0; i < rn; ++i) {
-                                          *p++ = pcm[0][i];
-                                          *p++ = pcm[1][i];
-                                          }
-                                    playTime += rn;
-                                    frames   -= rn;
-                                    framePos += rn;
-                                    n        -= rn;
-                                    }
-                              }
-                        }
-                  const Event& event = playPos.value();
-                  playEvent(event);
-                  if (event.type() == ME_TICK1)
-                        tickRest = tickLength;
-                  else if (event.type() == ME_TICK2)
-                        tackRest = tackLength;
+      //
+      // play events for one segment
+      //
+      unsigned framePos = 0;
+      int endTime = playTime + frames;
+      const PlayEvent* pl = playList->list.constData();
+      int size = playList->list.size();
+      for (; playIdx < size; ++playIdx) {
+            const PlayEvent& pe = pl[playIdx];
+            int f = pe.frame;
+            if (f >= endTime)
+                  break;
+            int n = f - playTime;
+            if (n < 0) {
+                  qDebug("%d:  %d - %d\n", pe.utick, f, playTime);
+                  n = 0;
                   }
-            if (frames) {
+            if (n) {
                   if (cs->playMode() == PLAYMODE_SYNTHESIZER) {
-                        metronome(frames, p);
-                        synti->process(frames, p);
-                        playTime += frames;
+                        metronome(n, p);
+                        synti->process(n, p);
+                        p += n * 2;
+                        playTime  += n;
+                        frames    -= n;
+                        framePos  += n;
                         }
                   else {
-                        int n = frames;
                         while (n > 0) {
                               int section;
                               float** pcm;
@@ -805,13 +950,94 @@ void Seq::process(unsigned n, float* buffer)
                               }
                         }
                   }
-            if (playPos == events.constEnd()) {
+            const ChannelEvent& event = *pe.event;
+            playEvent(event);
+            if (event.type() == ME_TICK1)
+                  tickRest = tickLength;
+            else if (event.type() == ME_TICK2)
+                  tackRest = tackLength;
+            }
+      if (frames) {
+            if (cs->playMode() == PLAYMODE_SYNTHESIZER) {
+                  metronome(frames, p);
+                  synti->process(frames, p);
+                  playTime += frames;
+                  }
+            else {
+                  int n = frames;
+                  while (n > 0) {
+                        int section;
+                        float** pcm;
+                        long rn = ov_read_float(&vf, &pcm, n, &section);
+                        if (rn == 0)
+                              break;
+                        for (int i = 0; i < rn; ++i) {
+                              *p++ = pcm[0][i];
+                              *p++ = pcm[1][i];
+                              }
+                        playTime += rn;
+                        frames   -= rn;
+                        framePos += rn;
+                        n        -= rn;
+                        }
+                  }
+            }
+      }
+
+//---------------------------------------------------------
+//   process
+//---------------------------------------------------------
+
+void Seq::process(unsigned n, float* buffer)
+      {
+      unsigned frames = n;
+      memset(buffer, 0, sizeof(float) * n * 2);
+
+      if (renderAudio->isStopping()) {
+            // the render thread owns the synthesizer until it has
+            // left its current block; play silence meanwhile
+            if (!renderAudio->released())
+                  return;
+            if (cs)
+                  stopSound();
+            }
+
+      int driverState = driver->getState();
+
+      if (driverState != state) {
+            if (state == TRANSPORT_STOP && driverState == TRANSPORT_PLAY)
+                  startTransport();
+            else if (state == TRANSPORT_PLAY && driverState == TRANSPORT_STOP)
+                  stopTransport();
+            else if (state != driverState)
+                  qDebug("Seq: state transition %d -> %d ?\n",
+                     state, driverState);
+            }
+      if (renderAudio->isStopping())
+            return;           // transport just stopped, see above
+
+      if (state == TRANSPORT_PLAY && renderAudio->isActive()) {
+            //
+            // the render thread owns the synthesizer; only
+            // copy out prerendered audio
+            //
+            renderAudio->read(buffer, n);
+            if (renderAudio->finished()) {
+                  endReached = true;
                   driver->stopTransport();
-                  rewindStart();
                   }
             }
       else {
-            synti->process(frames, p);
+            processMessages();
+            if (state == TRANSPORT_PLAY) {
+                  renderPlayback(frames, buffer);
+                  if (playEnd()) {
+                        endReached = true;
+                        driver->stopTransport();
+                        }
+                  }
+            else
+                  synti->process(frames, buffer);
             }
       //
       // metering
@@ -863,17 +1089,16 @@ void Seq::collectEvents()
       events.clear();
 
       cs->toEList(&events);
+      prefetchPrograms(synti, cs, events);
       endTick = 0;
-      if (!events.empty()) {
-            EventMap::const_iterator e = events.constEnd();
-            --e;
-            endTick = e.key();
-            }
+      if (!events.empty())
+            endTick = events.last().tick();
+      bool sent = sendPlayList(SEQ_PLAYLIST);
 
       PlayPanel* pp = mscore->getPlayPanel();
       if (pp)
             pp->setEndpos(endTick);
-      playlistChanged = false;
+      playlistChanged = !sent;      // try again on next start
       cs->setPlaylistDirty(false);
       }
 
@@ -898,14 +1123,17 @@ void Seq::processToGuiMessages()
             if (fromSeq.isEmpty())
                   break;
             SeqMsg msg = fromSeq.dequeue();
-            if (msg.id == SEQ_MIDI_INPUT_EVENT) {
-                  int type = msg.event.type();
+            if (msg.id == SEQ_FREE_PLAYLIST)
+                  delete msg.data.playList;
+            else if (msg.id == SEQ_MIDI_INPUT_EVENT) {
+                  const ChannelEvent& e = msg.event;
+                  int type = e.type();
                   if (type == ME_NOTEON)
-                        mscore->midiNoteReceived(msg.event.channel(), msg.event.pitch(), msg.event.velo());
+                        mscore->midiNoteReceived(e.channel(), e.pitch(), e.velo());
                   else if (type == ME_NOTEOFF)
-                        mscore->midiNoteReceived(msg.event.channel(), msg.event.pitch(), 0);
+                        mscore->midiNoteReceived(e.channel(), e.pitch(), 0);
                   else if (type == ME_CONTROLLER)
-                        mscore->midiCtrlReceived(msg.event.controller(), msg.event.value());
+                        mscore->midiCtrlReceived(e.controller(), e.value());
                   }
             }
       }
@@ -917,12 +1145,12 @@ void Seq::processToGuiMessages()
 
 void Seq::setRelTempo(double relTempo)
       {
-      SeqMsg msg;
-      msg.data.realVal = relTempo;
-      msg.id    = SEQ_TEMPO_CHANGE;
-      guiToSeq(msg);
+      cs->tempomap()->setRelTempo(relTempo);
+      cs->repeatList()->update();
+      if (!sendPlayList(SEQ_TEMPO_CHANGE))
+            playlistChanged = true;
 
-      double t = cs->tempomap()->tempo(playPos.key()) * relTempo;
+      double t = cs->tempomap()->tempo(playUtick()) * relTempo;
 
       PlayPanel* pp = mscore->getPlayPanel();
       if (pp) {
@@ -931,19 +1159,131 @@ void Seq::setRelTempo(double relTempo)
             }
       }
 
+//---------------------------------------------------------
+//   sendPlayList
+//    create a new play list for the current playlist and
+//    tempo and pass it to the sequencer; returns false
+//    if the sequencer still plays the old list
+//    gui thread
+//---------------------------------------------------------
+
+bool Seq::sendPlayList(int msgId)
+      {
+      SeqPlayList* pl = new SeqPlayList;
+      pl->events = events;          // shared until the gui changes its events
+      createPlayList(&pl->list, cs, pl->events, MScore::sampleRate);
+      if (!driver || !running) {
+            // there is no sequencer thread to hand over to
+            SeqPlayList* opl = playList;
+            playList = pl;
+            delete opl;
+            return true;
+            }
+      SeqMsg msg;
+      msg.id            = msgId;
+      msg.data.playList = pl;
+      if (!guiToSeq(msg)) {
+            // fifo overflow: the sequencer keeps its list
+            delete pl;
+            return false;
+            }
+      return true;
+      }
+
+//---------------------------------------------------------
+//   setPlayList
+//    install new play list; if keepPosition is set the
+//    list only differs in tempo and the current position is
+//    mapped into it
+//    realtime environment
+//---------------------------------------------------------
+
+void Seq::setPlayList(SeqPlayList* pl, bool keepPosition)
+      {
+      SeqPlayList* opl = playList;
+      int size = opl->list.size();
+      if (keepPosition && pl->list.size() == size && playTime) {
+            const PlayEvent* o = opl->list.constData();
+            const PlayEvent* n = pl->list.constData();
+            if (playIdx >= size) {
+                  if (size)
+                        playTime = n[size-1].frame + (playTime - o[size-1].frame);
+                  }
+            else {
+                  int of0 = playIdx ? o[playIdx-1].frame : 0;
+                  int nf0 = playIdx ? n[playIdx-1].frame : 0;
+                  int of1 = o[playIdx].frame;
+                  int nf1 = n[playIdx].frame;
+                  if (of1 > of0)
+                        playTime = nf0 + qint64(playTime - of0) * (nf1 - nf0) / (of1 - of0);
+                  else
+                        playTime = nf0;
+                  }
+            }
+      else if (!keepPosition || pl->list.size() != size) {
+            playIdx  = 0;
+            playTime = 0;
+            }
+      playList = pl;
+      SeqMsg msg;
+      msg.id            = SEQ_FREE_PLAYLIST;
+      msg.data.playList = opl;
+      if (!fromSeq.enqueue(msg))
+            qDebug("===SeqMsgFifo: overflow\n");
+      }
+
+//---------------------------------------------------------
+//   playUtick
+//    utick of the next event to play
+//---------------------------------------------------------
+
+int Seq::playUtick() const
+      {
+      if (playEnd())
+            return playList->list.isEmpty() ? 0 : playList->list.last().utick;
+      return playList->list.at(playIdx).utick;
+      }
+
+//---------------------------------------------------------
+//   playPos
+//    playlist position of the next event to play
+//    gui thread
+//---------------------------------------------------------
+
+int Seq::playPos() const
+      {
+      if (playEnd())
+            return events.size();
+      return events.lowerBound(playUtick());
+      }
+
 //---------------------------------------------------------
 //   setPos
 //    seek
 //    realtime environment
 //---------------------------------------------------------
 
-void Seq::setPos(int utick)
+void Seq::setPos(int utick, int frame)
       {
       stopNotes();
 
-      playTime  = cs->utick2utime(utick) * MScore::sampleRate;
-      playPos   = events.lowerBound(utick);
-      guiPos    = playPos;
+      playTime  = frame;
+      playIdx   = 0;
+      int n     = playList->list.size();
+      const PlayEvent* pl = playList->list.constData();
+      while (n > 0) {               // lower bound of utick
+            int half = n / 2;
+            if (pl[playIdx + half].utick < utick) {
+                  playIdx += half + 1;
+                  n       -= half + 1;
+                  }
+            else
+                  n = half;
+            }
+      if (oggInit && cs && cs->playMode() == PLAYMODE_AUDIO)
+            ov_pcm_seek(&vf, frame);    // the decoder belongs to this thread
+      if (renderAudio->isActive())
+            renderAudio->flush();     // drop audio rendered before seek
       }
 
 //---------------------------------------------------------
@@ -963,16 +1303,13 @@ void Seq::seek(int utick)
       cs->setPlayPos(utick);
       cs->setLayoutAll(false);
       cs->end();
-      
-      if (cs->playMode() == PLAYMODE_AUDIO) {
-            ogg_int64_t sp = cs->utick2utime(utick) * MScore::sampleRate;
-            ov_pcm_seek(&vf, sp);
-            }
 
       SeqMsg msg;
-      msg.data.intVal = utick;
+      msg.data.pos.utick = utick;
+      msg.data.pos.frame = cs->utick2utime(utick) * MScore::sampleRate;
       msg.id   = SEQ_SEEK;
       guiToSeq(msg);
+      guiPos = events.lowerBound(utick);
       mscore->setPos(utick);
       foreach(const Note* n, markedNotes) {
             ((Note*)n)->setSelected(false);     // HACK
@@ -1069,17 +1406,15 @@ void Seq::sendEvent(const Event& ev)
 
 void Seq::nextMeasure()
       {
-      EventMap::const_iterator i = playPos;
+      if (events.isEmpty())
+            return;
+      int i = qMin(playPos(), events.size() - 1);
       const Note* note = 0;
-      for (;;) {
-            if (i.value().type() == ME_NOTEON) {
-                  const Event& n = i.value();
-                  note = n.note();
+      for (; i >= 0; --i) {
+            if (events[i].type() == ME_NOTEON) {
+                  note = events[i].note();
                   break;
                   }
-            if (i == events.begin())
-                  break;
-            --i;
             }
       if (!note)
             return;
@@ -1087,7 +1422,7 @@ void Seq::nextMeasure()
       m = m->nextMeasure();
       if (m) {
             int rtick = m->tick() - note->chord()->tick();
-            seek(playPos.key() + rtick);
+            seek(playUtick() + rtick);
             }
       }
 
@@ -1097,13 +1432,13 @@ void Seq::nextMeasure()
 
 void Seq::nextChord()
       {
-      int tick = playPos.key();
-      for (EventMap::const_iterator i = playPos; i != events.constEnd(); ++i) {
-            if (i.value().type() != ME_NOTEON)
+      int tick = playUtick();
+      for (int i = playPos(); i < events.size(); ++i) {
+            const ChannelEvent& n = events[i];
+            if (n.type() != ME_NOTEON)
                   continue;
-            const Event& n = i.value();
-            if (i.key() > tick && n.velo()) {
-                  seek(i.key());
+            if (n.tick() > tick && n.velo()) {
+                  seek(n.tick());
                   break;
                   }
             }
@@ -1115,16 +1450,15 @@ void Seq::nextChord()
 
 void Seq::prevMeasure()
       {
-      EventMap::const_iterator i = playPos;
+      if (events.isEmpty())
+            return;
+      int i = qMin(playPos(), events.size() - 1);
       const Note* note = 0;
-      for (;;) {
-            if (i.value().type() == ME_NOTEON) {
-                  note = i.value().note();
+      for (; i >= 0; --i) {
+            if (events[i].type() == ME_NOTEON) {
+                  note = events[i].note();
                   break;
                   }
-            if (i == events.begin())
-                  break;
-            --i;
             }
       if (!note)
             return;
@@ -1133,7 +1467,7 @@ void Seq::prevMeasure()
 
       if (m) {
             int rtick = note->chord()->tick() - m->tick();
-            seek(playPos.key() - rtick);
+            seek(playUtick() - rtick);
             }
       else
             seek(0);
@@ -1145,35 +1479,27 @@ void Seq::prevMeasure()
 
 void Seq::prevChord()
       {
-      int tick  = playPos.key();
+      if (events.isEmpty())
+            return;
+      int tick  = playUtick();
+      int start = qMin(playPos(), events.size() - 1);
       //find the chord just before playpos
-      EventMap::const_iterator i = playPos;
-      for (;;) {
-            if (i.value().type() == ME_NOTEON) {
-                  const Event& n = i.value();
-                  if (i.key() < tick && n.velo()) {
-                        tick = i.key();
-                        break;
-                        }
-                  }
-            if (i == events.constBegin())
+      int i = start;
+      for (; i > 0; --i) {
+            const ChannelEvent& n = events[i];
+            if (n.type() == ME_NOTEON && n.tick() < tick && n.velo()) {
+                  tick = n.tick();
                   break;
-            --i;
+                  }
             }
       //go the previous chord
-      if (i != events.constBegin()) {
-            i = playPos;
-            for (;;) {
-                  if (i.value().type() == ME_NOTEON) {
-                        const Event& n = i.value();
-                        if (i.key() < tick && n.velo()) {
-                              seek(i.key());
-                              break;
-                              }
-                        }
-                  if (i == events.constBegin())
+      if (i > 0) {
+            for (i = start; i >= 0; --i) {
+                  const ChannelEvent& n = events[i];
+                  if (n.type() == ME_NOTEON && n.tick() < tick && n.velo()) {
+                        seek(n.tick());
                         break;
-                  --i;
+                        }
                   }
             }
       }
@@ -1191,11 +1517,24 @@ void Seq::seekEnd()
 //   guiToSeq
 //---------------------------------------------------------
 
-void Seq::guiToSeq(const SeqMsg& msg)
+bool Seq::guiToSeq(const SeqMsg& msg)
       {
       if (!driver || !running)
-            return;
-      toSeq.enqueue(msg);
+            return false;
+      // the gui may wait for the sequencer to catch up
+      QMutex mutex;
+      QWaitCondition qwc;
+      mutex.lock();
+      for (int i = 0; i < 50; ++i) {
+            if (toSeq.enqueue(msg)) {
+                  mutex.unlock();
+                  return true;
+                  }
+            qwc.wait(&mutex, 100);
+            }
+      mutex.unlock();
+      qDebug("===SeqMsgFifo: overflow\n");
+      return false;
       }
 
 //---------------------------------------------------------
@@ -1207,7 +1546,8 @@ void Seq::eventToGui(Event e)
       SeqMsg msg;
       msg.event = e;
       msg.id    = SEQ_MIDI_INPUT_EVENT;
-      fromSeq.enqueue(msg);
+      if (!fromSeq.enqueue(msg))
+            qDebug("===SeqMsgFifo: overflow\n");
       }
 
 //---------------------------------------------------------
@@ -1243,25 +1583,13 @@ SeqMsgFifo::SeqMsgFifo()
 //   enqueue
 //---------------------------------------------------------
 
-void SeqMsgFifo::enqueue(const SeqMsg& msg)
+bool SeqMsgFifo::enqueue(const SeqMsg& msg)
       {
-      int i = 0;
-      int n = 50;
-
-      QMutex mutex;
-      QWaitCondition qwc;
-      mutex.lock();
-      for (; i < n; ++i) {
-            if (!isFull())
-                  break;
-            qwc.wait(&mutex,100);
-            }
-      if (i == n) {
-            qDebug("===SeqMsgFifo: overflow\n");
-            return;
-            }
+      if (isFull())
+            return false;
       messages[widx] = msg;
       push();
+      return true;
       }
 
 //---------------------------------------------------------
@@ -1298,7 +1626,7 @@ float Seq::gain() const
 //   putEvent
 //---------------------------------------------------------
 
-void Seq::putEvent(const Event& event)
+void Seq::putEvent(const ChannelEvent& event)
       {
       if (!cs)
             return;
@@ -1344,17 +1672,23 @@ void Seq::heartBeat()
       if (state != TRANSPORT_PLAY)
             return;
       PlayPanel* pp = mscore->getPlayPanel();
-      int endTime = playTime;
+      int endTime  = playTime;
+      int endUtick = playEnd() ? endTick + 1 : playUtick();
+      if (renderAudio->isActive()) {
+            // follow what is audible, not what is rendered
+            endTime  = qMax(0, endTime - renderAudio->latency());
+            endUtick = cs->utime2utick(qreal(endTime) / qreal(MScore::sampleRate));
+            }
       if (pp)
             pp->heartBeat2(endTime);
 
       for (;;) {
-            EventMap::const_iterator p = guiPos + 1;
-            if ((p == events.constEnd()) || (p.key() >= playPos.key()))
+            int p = guiPos + 1;
+            if ((p >= events.size()) || (events[p].tick() >= endUtick))
                   break;
             guiPos = p;
-            if (guiPos.value().type() == ME_NOTEON) {
-                  Event n = guiPos.value();
+            if (events[guiPos].type() == ME_NOTEON) {
+                  const ChannelEvent& n = events[guiPos];
                   const Note* note1 = n.note();
                   if (n.velo()) {
                         while (note1) {
@@ -1376,7 +1710,7 @@ void Seq::heartBeat()
                   }
             }
 
-      int utick = guiPos.key();
+      int utick = guiPos < events.size() ? events[guiPos].tick() : 0;
       int tick = cs->repeatList()->utick2tick(utick);
       mscore->currentScoreView()->moveCursor(tick);
       mscore->setPos(tick);
@@ -26,6 +26,7 @@
 #include "driver.h"
 #include "libmscore/fifo.h"
 #include "libmscore/tempo.h"
+#include "msynth/render.h"
 
 class Note;
 class QTimer;
@@ -37,14 +38,29 @@ class Part;
 struct Channel;
 class ScoreView;
 class MasterSynth;
+class RenderAudio;
 
 //---------------------------------------------------------
 //   SeqMsg
-//    message format for gui -> sequencer messages
+//    message format for gui <-> sequencer messages
+//    plain data only (no implicitly shared members), it is
+//    copied in and out of SeqMsgFifo
 //---------------------------------------------------------
 
 enum { SEQ_NO_MESSAGE, SEQ_TEMPO_CHANGE, SEQ_PLAY, SEQ_SEEK,
-       SEQ_MIDI_INPUT_EVENT
+       SEQ_MIDI_INPUT_EVENT, SEQ_PLAYLIST, SEQ_FREE_PLAYLIST
+      };
+
+//---------------------------------------------------------
+//   SeqPlayList
+//    play list together with the sequencer's own copy of
+//    the events it points into; the gui may regenerate its
+//    events at any time
+//---------------------------------------------------------
+
+struct SeqPlayList {
+      ChannelEventList events;
+      PlayList list;
       };
 
 struct SeqMsg {
@@ -52,8 +68,13 @@ struct SeqMsg {
       union {
             int intVal;
             qreal realVal;
+            SeqPlayList* playList;
+            struct {
+                  int utick;
+                  int frame;
+                  } pos;
             } data;
-      Event event;
+      ChannelEvent event;
       };
 
 //---------------------------------------------------------
@@ -68,7 +89,7 @@ class SeqMsgFifo : public FifoBase {
    public:
       SeqMsgFifo();
       virtual ~SeqMsgFifo()     {}
-      void enqueue(const SeqMsg&);        // put object on fifo
+      bool enqueue(const SeqMsg&);        // put object on fifo, false if full
       SeqMsg dequeue();                   // remove object from fifo
       };
 
@@ -97,13 +118,15 @@ class Seq : public QObject, public Sequencer {
       double meterPeakValue[2];
       int peakTimer[2];
 
-      EventMap events;                    // playlist
+      ChannelEventList events;            // playlist
 
       int playTime;                       // current play position in samples
       int endTick;
 
-      EventMap::const_iterator playPos;   // moved in real time thread
-      EventMap::const_iterator guiPos;    // moved in gui thread
+      SeqPlayList* playList;              // events of playlist stamped with sample position
+      int playIdx;                        // next entry of playList, moved in real time thread
+      int guiPos;                         // index into events, moved in gui thread
+      bool endReached;                    // stopped at end of score, realtime thread
       QList<const Note*> markedNotes;     // notes marked as sounding
 
       uint tackRest;     // metronome state
@@ -112,14 +135,19 @@ class Seq : public QObject, public Sequencer {
 
       QTimer* heartBeatTimer;
       QTimer* noteTimer;
+      RenderAudio* renderAudio;           // prerenders synthesizer output or the audio track while playing
 
       void collectMeasureEvents(Measure*, int staffIdx);
 
       void stopTransport();
+      void stopSound();
       void startTransport();
-      void setPos(int);
-      void playEvent(const Event&);
-      void guiToSeq(const SeqMsg& msg);
+      void setPos(int utick, int frame);
+      void setPlayList(SeqPlayList*, bool keepPosition);
+      bool sendPlayList(int msgId);
+      int playPos() const;
+      void playEvent(const ChannelEvent&);
+      bool guiToSeq(const SeqMsg& msg);
       void metronome(unsigned n, float* l);
 
    private slots:
@@ -169,6 +197,9 @@ class Seq : public QObject, public Sequencer {
 
       void processMessages();
       void process(unsigned, float*);
+      void renderPlayback(unsigned, float*);
+      bool playEnd() const      { return playIdx >= playList->list.size(); }
+      int playUtick() const;
       QList<QString> inputPorts();
       int getEndTick() const    { return endTick;  }
       bool isRealtime() const   { return true;     }
@@ -189,7 +220,7 @@ class Seq : public QObject, public Sequencer {
 
       int synthNameToIndex(const QString&) const;
       QString synthIndexToName(int) const;
-      void putEvent(const Event&);
+      void putEvent(const ChannelEvent&);
       void startNoteTimer(int duration);
       void startNote(int channel, int, int, double nt);
       void eventToGui(Event);
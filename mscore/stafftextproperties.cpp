@@ -349,6 +349,7 @@ void StaffTextProperties::saveValues()
                   }
             }
 
+      staffText->score()->clearEventCache();
       staffText->score()->updateChannel();
       staffText->score()->setPlaylistDirty(true);
       }
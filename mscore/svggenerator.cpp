@@ -42,6 +42,11 @@
 #include "svggenerator.h"
 #include "paintengine_p.h"
 
+// number of decimals written for coordinates and transformation
+// matrix scale factors in optimized mode
+static const int SVG_PRECISION        = 2;
+static const int SVG_MATRIX_PRECISION = 5;
+
 #if QT_POINTER_SIZE == 8 // 64-bit versions
 
 static uint INTERPOLATE_PIXEL_256(uint x, uint a, uint y, uint b) {
@@ -148,6 +153,8 @@ public:
 
         afterFirstUpdate = false;
         numGradients = 0;
+        optimized = false;
+        numGlyphs = 0;
     }
 
     QSize size;
@@ -175,6 +182,26 @@ public:
     QString currentGradientName;
     int numGradients;
 
+    // optimized mode: glyph outlines are written once as
+    // <path> in <defs> and referenced by <use>; the document
+    // is streamed directly to the output device
+    bool optimized;
+    QHash<QString, QString> glyphNames;
+    int numGlyphs;
+
+    QString glyphName(const QString& key, bool* created) {
+        QHash<QString, QString>::const_iterator i = glyphNames.constFind(key);
+        if (i != glyphNames.constEnd()) {
+            *created = false;
+            return i.value();
+        }
+        ++numGlyphs;
+        QString name = QString::fromLatin1("g%1").arg(numGlyphs);
+        glyphNames.insert(key, name);
+        *created = true;
+        return name;
+    }
+
     struct _attributes {
         QString document_title;
         QString document_description;
@@ -220,6 +247,8 @@ public:
     void drawPolygon(const QPointF *points, int pointCount, PolygonDrawMode mode);
     void drawImage(const QRectF &r, const QImage &pm, const QRectF &sr,
                    Qt::ImageConversionFlag = Qt::AutoColor);
+    void drawTextItem(const QPointF &p, const QTextItem &textItem);
+    void writePathData(const QPainterPath &path);
 
     QPaintEngine::Type type() const { return QPaintEngine::SVG; }
 
@@ -256,6 +285,12 @@ public:
         Q_ASSERT(!isActive());
         d_func()->resolution = resolution;
     }
+
+    bool optimized() const { return d_func()->optimized; }
+    void setOptimized(bool val) {
+        Q_ASSERT(!isActive());
+        d_func()->optimized = val;
+    }
     void saveLinearGradientBrush(const QGradient *g)
     {
         QTextStream str(&d_func()->defs, QIODevice::Append);
@@ -271,7 +306,7 @@ public:
 
         str << QLatin1String("id=\"") << d_func()->generateGradientName() << QLatin1String("\">\n");
         saveGradientStops(str, g);
-        str << QLatin1String("</linearGradient>") <<endl;
+        str << QLatin1String("</linearGradient>") << '\n';
     }
     void saveRadialGradientBrush(const QGradient *g)
     {
@@ -288,7 +323,7 @@ public:
         }
         str << QLatin1String("xml:id=\"") <<d_func()->generateGradientName()<< QLatin1String("\">\n");
         saveGradientStops(str, g);
-        str << QLatin1String("</radialGradient>") << endl;
+        str << QLatin1String("</radialGradient>") << '\n';
     }
     void saveConicalGradientBrush(const QGradient *)
     {
@@ -536,7 +571,7 @@ public:
                       "font-size=\"" << d->attributes.font_size << "\" "
                       "font-weight=\"" << d->attributes.font_weight << "\" "
                       "font-style=\"" << d->attributes.font_style << "\" "
-                   << endl;
+                   << '\n';
     }
 };
 
@@ -808,6 +843,35 @@ void SvgGenerator::setResolution(int dpi)
     d->engine->setResolution(dpi);
 }
 
+/*!
+    \property SvgGenerator::optimized
+    \brief write compact SVG
+
+    In optimized mode every distinct glyph (font, size and text) is
+    written once as a path in \c{<defs>} and referenced with
+    \c{<use>}, coordinates are written with fixed precision and the
+    document is streamed to the output device while painting instead
+    of being accumulated in memory.
+
+    \note It is not possible to change this property while a
+    QPainter is active on the generator.
+*/
+bool SvgGenerator::optimized() const
+{
+    Q_D(const SvgGenerator);
+    return d->engine->optimized();
+}
+
+void SvgGenerator::setOptimized(bool val)
+{
+    Q_D(SvgGenerator);
+    if (d->engine->isActive()) {
+        qWarning("SvgGenerator::setOptimized(), cannot change mode while SVG is being generated");
+        return;
+    }
+    d->engine->setOptimized(val);
+}
+
 /*!
     Returns the paint engine used to render graphics to be converted to SVG
     format information.
@@ -876,42 +940,54 @@ bool SvgPaintEngine::begin(QPaintDevice *)
         return false;
     }
 
-    d->stream = new QTextStream(&d->header);
+    d->glyphNames.clear();
+    d->numGlyphs = 0;
+    if (d->optimized) {
+        d->stream = new QTextStream(d->outputDevice);
+#ifndef QT_NO_TEXTCODEC
+        d->stream->setCodec(QTextCodec::codecForName("UTF-8"));
+#endif
+        d->stream->setRealNumberNotation(QTextStream::FixedNotation);
+        d->stream->setRealNumberPrecision(SVG_PRECISION);
+    }
+    else
+        d->stream = new QTextStream(&d->header);
 
     // stream out the header...
-    *d->stream << "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"no\"?>" << endl << "<svg";
+    *d->stream << "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"no\"?>" << '\n' << "<svg";
 
     if (d->size.isValid()) {
         qreal wmm = d->size.width() * 25.4 / d->resolution;
         qreal hmm = d->size.height() * 25.4 / d->resolution;
-        *d->stream << " width=\"" << wmm << "mm\" height=\"" << hmm << "mm\"" << endl;
+        *d->stream << " width=\"" << wmm << "mm\" height=\"" << hmm << "mm\"" << '\n';
     }
 
     if (d->viewBox.isValid()) {
         *d->stream << " viewBox=\"" << d->viewBox.left() << ' ' << d->viewBox.top();
-        *d->stream << ' ' << d->viewBox.width() << ' ' << d->viewBox.height() << '\"' << endl;
+        *d->stream << ' ' << d->viewBox.width() << ' ' << d->viewBox.height() << '\"' << '\n';
     }
 
     *d->stream << " xmlns=\"http://www.w3.org/2000/svg\""
                   " xmlns:xlink=\"http://www.w3.org/1999/xlink\" "
-                  " version=\"1.2\" baseProfile=\"tiny\">" << endl;
+                  " version=\"1.2\" baseProfile=\"tiny\">" << '\n';
 
     if (!d->attributes.document_title.isEmpty()) {
-        *d->stream << "<title>" << d->attributes.document_title << "</title>" << endl;
+        *d->stream << "<title>" << d->attributes.document_title << "</title>" << '\n';
     }
 
     if (!d->attributes.document_description.isEmpty()) {
-        *d->stream << "<desc>" << d->attributes.document_description << "</desc>" << endl;
+        *d->stream << "<desc>" << d->attributes.document_description << "</desc>" << '\n';
     }
 
-    d->stream->setString(&d->defs);
-    *d->stream << "<defs>\n";
-
-    d->stream->setString(&d->body);
+    if (!d->optimized) {
+        d->stream->setString(&d->defs);
+        *d->stream << "<defs>\n";
+        d->stream->setString(&d->body);
+    }
     // Start the initial graphics state...
     *d->stream << "<g ";
     generateQtDefaults();
-    *d->stream << endl;
+    *d->stream << '\n';
 
     return true;
 }
@@ -920,6 +996,20 @@ bool SvgPaintEngine::end()
 {
     Q_D(SvgPaintEngine);
 
+    if (d->optimized) {
+        if (d->afterFirstUpdate)
+            *d->stream << "</g>" << '\n'; // close the updateState
+        *d->stream << "</g>" << '\n';     // close the Qt defaults
+        // gradients; forward references are allowed in svg
+        if (!d->defs.isEmpty())
+            *d->stream << "<defs>\n" << d->defs << "</defs>\n";
+        *d->stream << "</svg>" << '\n';
+        d->stream->flush();
+        delete d->stream;
+        d->defs.clear();
+        return true;
+    }
+
     d->stream->setString(&d->defs);
     *d->stream << "</defs>\n";
 
@@ -932,10 +1022,10 @@ bool SvgPaintEngine::end()
     *d->stream << d->defs;
     *d->stream << d->body;
     if (d->afterFirstUpdate)
-        *d->stream << "</g>" << endl; // close the updateState
+        *d->stream << "</g>" << '\n'; // close the updateState
 
-    *d->stream << "</g>" << endl // close the Qt defaults
-               << "</svg>" << endl;
+    *d->stream << "</g>" << '\n' // close the Qt defaults
+               << "</svg>" << '\n';
 
     delete d->stream;
 
@@ -997,12 +1087,17 @@ void SvgPaintEngine::updateState(const QPaintEngineState &state)
 
     if (flags & QPaintEngine::DirtyTransform) {
         d->matrix = state.matrix();
+        // scale factors need more digits than coordinates
+        if (d->optimized)
+            d->stream->setRealNumberPrecision(SVG_MATRIX_PRECISION);
         *d->stream << "transform=\"matrix(" << d->matrix.m11() << ','
                    << d->matrix.m12() << ','
-                   << d->matrix.m21() << ',' << d->matrix.m22() << ','
-                   << d->matrix.dx() << ',' << d->matrix.dy()
+                   << d->matrix.m21() << ',' << d->matrix.m22() << ',';
+        if (d->optimized)
+            d->stream->setRealNumberPrecision(SVG_PRECISION);
+        *d->stream << d->matrix.dx() << ',' << d->matrix.dy()
                    << ")\""
-                   << endl;
+                   << '\n';
     }
 
     if (flags & QPaintEngine::DirtyFont) {
@@ -1014,11 +1109,50 @@ void SvgPaintEngine::updateState(const QPaintEngineState &state)
             stream() << "opacity=\""<<state.opacity()<<"\" ";
     }
 
-    *d->stream << '>' << endl;
+    *d->stream << '>' << '\n';
 
     d->afterFirstUpdate = true;
 }
 
+/*!
+    In optimized mode the outline of every distinct text item is
+    written once into \c{<defs>}; all occurrences are emitted as
+    \c{<use>} elements filled with the pen color.
+    Otherwise the QPaintEngine default (text as path) is used.
+*/
+void SvgPaintEngine::drawTextItem(const QPointF &p, const QTextItem &textItem)
+{
+    Q_D(SvgPaintEngine);
+
+    if (!d->optimized) {
+        QPaintEngine::drawTextItem(p, textItem);
+        return;
+    }
+    const QFont font(textItem.font());
+    const QString text(textItem.text());
+    if (text.isEmpty())
+        return;
+
+    bool created;
+    QString name = d->glyphName(font.key() + QLatin1Char('|') + text, &created);
+    if (created) {
+        QPainterPath path;
+        path.setFillRule(Qt::WindingFill);
+        path.addText(QPointF(0.0, 0.0), font, text);
+        *d->stream << "<defs><path id=\"" << name << "\" d=\"";
+        writePathData(path);
+        *d->stream << "\"/></defs>" << '\n';
+    }
+
+    QString color, colorOpacity;
+    translate_color(state->pen().color(), &color, &colorOpacity);
+    *d->stream << "<use xlink:href=\"#" << name << "\" x=\"" << p.x()
+               << "\" y=\"" << p.y() << "\" fill=\"" << color << "\" stroke=\"none\"";
+    if (state->pen().color().alpha() != 255)
+        *d->stream << " fill-opacity=\"" << colorOpacity << '"';
+    *d->stream << "/>" << '\n';
+}
+
 void SvgPaintEngine::drawPath(const QPainterPath &p)
 {
     Q_D(SvgPaintEngine);
@@ -1029,6 +1163,14 @@ void SvgPaintEngine::drawPath(const QPainterPath &p)
                << (p.fillRule() == Qt::OddEvenFill ? "evenodd" : "nonzero")
                << "\" d=\"";
 
+    writePathData(p);
+    *d->stream << "\"/>" << '\n';
+}
+
+void SvgPaintEngine::writePathData(const QPainterPath &p)
+{
+    Q_D(SvgPaintEngine);
+
     for (int i=0; i<p.elementCount(); ++i) {
         const QPainterPath::Element &e = p.elementAt(i);
         switch (e.type) {
@@ -1059,8 +1201,6 @@ void SvgPaintEngine::drawPath(const QPainterPath &p)
             *d->stream << ' ';
         }
     }
-
-    *d->stream << "\"/>" << endl;
 }
 
 void SvgPaintEngine::drawPolygon(const QPointF *points, int pointCount,
@@ -1082,7 +1222,7 @@ void SvgPaintEngine::drawPolygon(const QPointF *points, int pointCount,
             const QPointF &pt = points[i];
             stream() << pt.x() << ',' << pt.y() << ' ';
         }
-        stream() << "\" />" <<endl;
+        stream() << "\" />" << '\n';
     } else {
         path.closeSubpath();
         drawPath(path);
@@ -88,6 +88,9 @@ public:
 
     void setResolution(int dpi);
     int resolution() const;
+
+    bool optimized() const;
+    void setOptimized(bool);
 protected:
     QPaintEngine *paintEngine() const;
     int metric(QPaintDevice::PaintDeviceMetric metric) const;
@@ -105,7 +105,7 @@ void TextStyleDialog::buttonClicked(QAbstractButton* b)
                   break;
             default:
                   if (cs->undo()->current()) {
-                        cs->undo()->current()->unwind();
+                        cs->undo()->current()->unwind(cs);
                         cs->setLayoutAll(true);
                         }
                   done(0);
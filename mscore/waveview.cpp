@@ -25,8 +25,6 @@ struct VorbisData {
       QByteArray data;
       };
 
-static VorbisData vorbisData;
-
 static size_t ovRead(void* ptr, size_t size, size_t nmemb, void* datasource);
 static int ovSeek(void* datasource, ogg_int64_t offset, int whence);
 static long ovTell(void* datasource);
@@ -86,91 +84,171 @@ static long ovTell(void* datasource)
 
 
 //---------------------------------------------------------
-//   WaveView
+//   peakValue
 //---------------------------------------------------------
 
-WaveView::WaveView(QWidget* parent)
-   : QWidget(parent)
+static inline char peakValue(float v)
       {
-      _xpos   = 0;
-      _xmag   = 0.1;
-      _timeType = TICKS;      // FRAMES
-      setMinimumHeight(50);
+      return qMin(255, int(lrintf(v * 255.0f)));
       }
 
-static const int WSCALE = 10;
-
 //---------------------------------------------------------
-//   setAudio
+//   scanAudio
+//    decode the ogg stream in data and build its peak
+//    pyramid; runs in a worker thread
 //---------------------------------------------------------
 
-void WaveView::setAudio(Audio* audio)
+static WavePeaks scanAudio(QByteArray data, QAtomicInt* abort)
       {
-      waves.clear();
+      WavePeaks wp;
+      VorbisData vd;
+      vd.pos  = 0;
+      vd.data = data;
       OggVorbis_File vf;
-      vorbisData.pos  = 0;
-      vorbisData.data = audio->data();
-      int rv = ov_open_callbacks(&vorbisData, &vf, 0, 0, ovCallbacks);
+      int rv = ov_open_callbacks(&vd, &vf, 0, 0, ovCallbacks);
       if (rv < 0) {
             printf("ogg open failed: %d\n", rv);
-            return;
+            return wp;
             }
-      int rn = 0;
-      const int n = 10000 / WSCALE;
-      uchar dst[n];
-      float* r = 0;
-      float* l = 0;
-      for (;;) {
-            for (int i = 0; i < n; ++i) {
-                  float val = 0;
-                  for (int k = 0; k < WSCALE; ++k) {
-                        if (rn == 0) {
-                              float** pcm;
-                              int section;
-                              rn = ov_read_float(&vf, &pcm, 1000, &section);
-                              if (rn == 0) {
-                                    for (; i < n; ++i)
-                                          dst[i] = 0;
-                                    waves.append((char*)dst, n);
-                                    ov_clear(&vf);
-                                    return;
-                                    }
-                              r = pcm[0];
-                              l = pcm[1];
-                              }
-                        val += fabsf(*r++) + fabsf(*l++);
-                        --rn;
+      int channels = ov_info(&vf, -1)->channels;
+
+      QByteArray level;
+      float peak = 0.0f;
+      int n      = 0;
+      while (!abort->fetchAndAddAcquire(0)) {
+            float** pcm;
+            int section;
+            long rn = ov_read_float(&vf, &pcm, 4096, &section);
+            if (rn == OV_HOLE)      // interruption in the data, go on
+                  continue;
+            if (rn <= 0)            // end of stream, or damaged file
+                  break;
+            for (int i = 0; i < rn; ++i) {
+                  for (int k = 0; k < channels; ++k)
+                        peak = qMax(peak, fabsf(pcm[k][i]));
+                  if (++n == WavePeaks::PEAK_FRAMES) {
+                        level.append(peakValue(peak));
+                        peak = 0.0f;
+                        n    = 0;
                         }
-                  unsigned int v = lrint(val * 128);
-                  if (v > 255)
-                        v = 255;
-                  dst[i] = v;
                   }
-            waves.append((char*)dst, n);
+            wp.frames += rn;
             }
+      ov_clear(&vf);
+      if (n)
+            level.append(peakValue(peak));
+      if (level.isEmpty())
+            return wp;
+
+      wp.levels.append(level);
+      while (level.size() > 1) {
+            int size = (level.size() + 1) / 2;
+            QByteArray up(size, 0);
+            for (int i = 0; i < size; ++i) {
+                  uchar a = level.at(i * 2);
+                  uchar b = (i * 2 + 1 < level.size()) ? uchar(level.at(i * 2 + 1)) : 0;
+                  up[i] = qMax(a, b);
+                  }
+            wp.levels.append(up);
+            level = up;
+            }
+      return wp;
       }
 
 //---------------------------------------------------------
-//   pegel
+//   peak
+//    peak level (0 - 255) between frame1 and frame2
+//
+//    The level is chosen so that the range covers at most
+//    three of its entries, at any zoom; the peak may come
+//    from frames up to one such entry outside the range.
 //---------------------------------------------------------
 
-int WaveView::pegel(int frame1, int frame2)
+int WavePeaks::peak(int frame1, int frame2) const
       {
+      if (levels.isEmpty())
+            return 0;
       if (frame1 < 0)
             frame1 = 0;
       if (frame1 > frame2)
             return 0;
-      frame1 = (frame1 + WSCALE/2) / WSCALE;
-      frame2 = (frame2 + WSCALE/2) / WSCALE;
-      if (frame2 >= waves.size())
-            frame2 = waves.size()-1;
+      int b1 = frame1 / PEAK_FRAMES;
+      int b2 = frame2 / PEAK_FRAMES;
+      int n  = levels[0].size();
+      if (b1 >= n)
+            return 0;
+      if (b2 >= n)
+            b2 = n - 1;
+      int d     = b2 - b1;
+      int level = d ? 31 - __builtin_clz(d) : 0;
+      if (level >= levels.size())
+            level = levels.size() - 1;
+      const QByteArray& l = levels[level];
       int p = 0;
-      for (int i = frame1; i <= frame2; ++i)
-            p += uchar(waves[i]);
-      p /= (frame2 - frame1 + 1);
+      for (int i = b1 >> level; i <= (b2 >> level); ++i)
+            p = qMax(p, int(uchar(l[i])));
       return p;
       }
 
+//---------------------------------------------------------
+//   WaveView
+//---------------------------------------------------------
+
+WaveView::WaveView(QWidget* parent)
+   : QWidget(parent)
+      {
+      _xpos   = 0;
+      _xmag   = 0.1;
+      _timeType = TICKS;      // FRAMES
+      abortScan = 0;
+      setMinimumHeight(50);
+      connect(&scanner, SIGNAL(finished()), SLOT(scanFinished()));
+      }
+
+WaveView::~WaveView()
+      {
+      stopScan();
+      }
+
+//---------------------------------------------------------
+//   stopScan
+//---------------------------------------------------------
+
+void WaveView::stopScan()
+      {
+      scanner.cancel();             // drop the result of a running scan
+      abortScan.fetchAndStoreOrdered(1);
+      scanner.waitForFinished();
+      abortScan.fetchAndStoreOrdered(0);
+      }
+
+//---------------------------------------------------------
+//   setAudio
+//    the waveform is built in the background and shown
+//    when it is complete
+//---------------------------------------------------------
+
+void WaveView::setAudio(Audio* audio)
+      {
+      stopScan();
+      peaks = WavePeaks();
+      if (audio)
+            scanner.setFuture(QtConcurrent::run(scanAudio, audio->data(), &abortScan));
+      update();
+      }
+
+//---------------------------------------------------------
+//   scanFinished
+//---------------------------------------------------------
+
+void WaveView::scanFinished()
+      {
+      if (scanner.isCanceled())
+            return;
+      peaks = scanner.result();
+      update();
+      }
+
 //---------------------------------------------------------
 //   setXpos
 //---------------------------------------------------------
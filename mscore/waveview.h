@@ -18,6 +18,24 @@
 class Audio;
 class Score;
 
+//---------------------------------------------------------
+//   WavePeaks
+//    waveform overview of an audio track as a peak
+//    pyramid: level 0 holds the peak of every PEAK_FRAMES
+//    frames, each further level the peak of two entries of
+//    the level below
+//---------------------------------------------------------
+
+struct WavePeaks {
+      static const int PEAK_FRAMES = 16;
+
+      int frames;
+      QList<QByteArray> levels;
+
+      WavePeaks() : frames(0) {}
+      int peak(int frame1, int frame2) const;
+      };
+
 //---------------------------------------------------------
 //   WaveView
 //---------------------------------------------------------
@@ -28,7 +46,9 @@ class WaveView : public QWidget
       Pos _cursor;
       Pos* _locator;
       Score* _score;
-      QByteArray waves;
+      WavePeaks peaks;
+      QFutureWatcher<WavePeaks> scanner;  // builds peaks in the background
+      QAtomicInt abortScan;
 
       TType _timeType;
       int magStep;
@@ -39,7 +59,11 @@ class WaveView : public QWidget
       Pos pix2pos(int x) const;
       virtual void paintEvent(QPaintEvent*);
       virtual QSize sizeHint() const { return QSize(50, 50); }
-      int pegel(int frame1, int frame2);
+      int pegel(int frame1, int frame2) const { return peaks.peak(frame1, frame2); }
+      void stopScan();
+
+   private slots:
+      void scanFinished();
 
    public slots:
       void setMag(double,double);
@@ -47,6 +71,7 @@ class WaveView : public QWidget
 
    public:
       WaveView(QWidget* parent = 0);
+      ~WaveView();
       void setAudio(Audio*);
       void setXpos(int);
       void setScore(Score* s, Pos* lc);
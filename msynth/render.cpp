@@ -0,0 +1,249 @@
+//=============================================================================
+//  MuseScore
+//  Music Composition & Notation
+//  $Id:$
+//
+//  Copyright (C) 2012 Werner Schweer and others
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//=============================================================================
+
+#include "render.h"
+#include "libmscore/score.h"
+#include "libmscore/part.h"
+#include "libmscore/instrument.h"
+
+//---------------------------------------------------------
+//   createPlayList
+//    stamp all events with their sample position;
+//    must be recreated on every tempo change
+//---------------------------------------------------------
+
+void createPlayList(PlayList* pl, Score* score, const ChannelEventList& events, int sampleRate)
+      {
+      pl->clear();
+      pl->reserve(events.size());
+      int lastUtick = -1;
+      int frame     = 0;
+      const ChannelEvent* e = events.constData();
+      for (int i = 0; i < events.size(); ++i) {
+            PlayEvent pe;
+            pe.utick = e[i].tick();
+            if (pe.utick != lastUtick) {
+                  frame     = score->utick2utime(pe.utick) * sampleRate;
+                  lastUtick = pe.utick;
+                  }
+            pe.frame = frame;
+            pe.event = &e[i];
+            pl->append(pe);
+            }
+      }
+
+//---------------------------------------------------------
+//   prefetchPrograms
+//    ask the synthesizers to load the samples of every
+//    program the score selects, so that playback does not
+//    start with silent instruments
+//---------------------------------------------------------
+
+void prefetchPrograms(MasterSynth* synti, Score* score, const ChannelEventList& events)
+      {
+      QHash<int, int> bank;         // channel -> current bank
+      foreach(const MidiMapping& mm, *score->midiMapping()) {
+            const Channel* a = mm.articulation;
+            bank[a->channel] = a->bank;
+            if (a->program != -1)
+                  synti->prefetchProgram(a->synti, a->bank, a->program);
+            }
+      foreach(const ChannelEvent& e, events) {
+            if (e.type() != ME_CONTROLLER || e.channel() >= score->midiMapping()->size())
+                  continue;
+            int ch = e.channel();
+            switch (e.controller()) {
+                  case CTRL_HBANK:
+                        bank[ch] = (e.value() << 7) + (bank[ch] & 0x7f);
+                        break;
+                  case CTRL_LBANK:
+                        bank[ch] = (bank[ch] & ~0x7f) + (e.value() & 0x7f);
+                        break;
+                  case CTRL_PROGRAM:
+                        synti->prefetchProgram(score->midiMapping(ch)->articulation->synti,
+                           bank[ch], e.value());
+                        break;
+                  }
+            }
+      }
+
+//---------------------------------------------------------
+//   ScoreRenderer
+//    prepares the synthesizers and the play list; the
+//    samples of all programs used by the score are loaded
+//    before the constructor returns
+//---------------------------------------------------------
+
+ScoreRenderer::ScoreRenderer(Score* s, int sampleRate, SyntiState& state, int blockSize,
+   const SynthSettings& settings)
+      {
+      score       = s;
+      _sampleRate = sampleRate;
+      _blockSize  = qBound(1, blockSize, int(MAX_BLOCK));
+      playTime    = 0;
+      playIdx     = 0;
+      _stems      = 0;
+      out.resize(1);
+
+      synti = new MasterSynth();
+      synti->create(sampleRate, settings);
+      synti->setState(state);
+
+      score->toEList(&events);
+      prefetchPrograms(synti, score, events);
+      synti->waitPrefetch();
+      createPlayList(&playList, score, events, sampleRate);
+      _frames = (playList.isEmpty() ? 0 : playList.last().frame) + sampleRate;
+
+      //
+      // init instruments
+      //
+      foreach(const Part* part, score->parts()) {
+            foreach(const Channel& a, part->instr()->channel()) {
+                  a.updateInitList();
+                  foreach(Event e, a.init) {
+                        if (e.type() == ME_INVALID)
+                              continue;
+                        e.setChannel(a.channel);
+                        int syntiIdx= score->midiMapping(a.channel)->articulation->synti;
+                        synti->play(e, syntiIdx);
+                        }
+                  }
+            }
+      }
+
+ScoreRenderer::~ScoreRenderer()
+      {
+      delete synti;
+      }
+
+//---------------------------------------------------------
+//   setRenderThreads
+//---------------------------------------------------------
+
+void ScoreRenderer::setRenderThreads(int n)
+      {
+      synti->setRenderThreads(n);
+      }
+
+//---------------------------------------------------------
+//   setStems
+//    render one output per part instead of the full mix;
+//    must be set before rendering starts
+//---------------------------------------------------------
+
+void ScoreRenderer::setStems(bool val)
+      {
+      channelStem.clear();
+      synthStem.clear();
+      _stems = 0;
+      if (val) {
+            const QList<Part*>& parts = score->parts();
+            const QList<MidiMapping>* mm = score->midiMapping();
+            for (int i = 0; i < mm->size(); ++i) {
+                  int stem  = parts.indexOf(mm->at(i).part);
+                  int synth = mm->at(i).articulation->synti;
+                  channelStem.append(stem);
+                  while (synthStem.size() <= synth)
+                        synthStem.append(-1);
+                  if (synthStem[synth] == -1)
+                        synthStem[synth] = stem;
+                  }
+            _stems = parts.size();
+            }
+      out.resize(outputs());
+      }
+
+//---------------------------------------------------------
+//   renderFrames
+//    render n frames into out[] and advance the pointers
+//---------------------------------------------------------
+
+void ScoreRenderer::renderFrames(unsigned n)
+      {
+      if (_stems)
+            synti->processStems(n, out.data(), channelStem, synthStem);
+      else
+            synti->process(n, out[0]);
+      for (int i = 0; i < out.size(); ++i)
+            out[i] += 2 * n;
+      }
+
+//---------------------------------------------------------
+//   render
+//    render the next block into o[0] ... o[outputs()-1];
+//    every buffer must hold blockSize() stereo frames.
+//    Returns the number of frames rendered, 0 at the end
+//    of the score.
+//---------------------------------------------------------
+
+int ScoreRenderer::render(float** o)
+      {
+      if (atEnd())
+            return 0;
+      int frames = qMin(_blockSize, _frames - playTime);
+      for (int i = 0; i < out.size(); ++i) {
+            memset(o[i], 0, frames * 2 * sizeof(float));
+            out[i] = o[i];
+            }
+      int endTime = playTime + frames;
+      for (; playIdx < playList.size(); ++playIdx) {
+            const PlayEvent& pe = playList.at(playIdx);
+            if (pe.frame >= endTime)
+                  break;
+            int n = pe.frame - playTime;
+            if (n > 0) {
+                  renderFrames(n);
+                  playTime += n;
+                  }
+            const ChannelEvent& e = *pe.event;
+            if (e.isChannelEvent()) {
+                  Channel* c = score->midiMapping(e.channel())->articulation;
+                  if (!c->mute)
+                        synti->play(e, c->synti);
+                  }
+            }
+      if (playTime < endTime) {
+            renderFrames(endTime - playTime);
+            playTime = endTime;
+            }
+      return frames;
+      }
+
+//---------------------------------------------------------
+//   run
+//    render the whole score block by block; returns false
+//    if the callback stopped rendering
+//---------------------------------------------------------
+
+bool ScoreRenderer::run(Callback cb, void* data)
+      {
+      const int n = outputs();
+      QVector<float> buffer(n * _blockSize * 2);
+      QVector<float*> o(n);
+      for (int i = 0; i < n; ++i)
+            o[i] = buffer.data() + i * _blockSize * 2;
+      while (int frames = render(o.data())) {
+            if (!cb(o.data(), n, frames, data))
+                  return false;
+            }
+      return true;
+      }
+
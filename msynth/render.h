@@ -0,0 +1,103 @@
+//=============================================================================
+//  MuseScore
+//  Music Composition & Notation
+//  $Id:$
+//
+//  Copyright (C) 2012 Werner Schweer and others
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//=============================================================================
+
+#ifndef __RENDER_H__
+#define __RENDER_H__
+
+#include "libmscore/event.h"
+#include "synti.h"
+
+class Score;
+
+//---------------------------------------------------------
+//   PlayEvent
+//    playlist entry with precomputed sample position
+//---------------------------------------------------------
+
+struct PlayEvent {
+      int frame;              // absolute position in samples
+      int utick;
+      const ChannelEvent* event;    // points into the list the play list was created from
+      };
+
+typedef QVector<PlayEvent> PlayList;
+
+extern void createPlayList(PlayList*, Score*, const ChannelEventList&, int sampleRate);
+extern void prefetchPrograms(MasterSynth*, Score*, const ChannelEventList&);
+
+//---------------------------------------------------------
+//   ScoreRenderer
+//    Offline rendering of a score, faster than real time.
+//    The renderer owns its synthesizers and does not touch
+//    global state or gui objects, so several renderers can
+//    run at once in different threads, each on its own
+//    score.
+//    Audio is pulled block by block with render(), or
+//    pushed to a callback by run(). Every output gets
+//    interleaved stereo frames: the full mix, or one output
+//    per part with setStems().
+//---------------------------------------------------------
+
+class ScoreRenderer {
+   public:
+      // returns false to stop rendering
+      typedef bool (*Callback)(float** out, int outputs, int frames, void* data);
+
+   private:
+      Score* score;
+      MasterSynth* synti;
+      int _sampleRate;
+      int _blockSize;
+      int _frames;                  // length including one second trailer
+      int playTime;                 // frames rendered so far
+      int playIdx;
+      ChannelEventList events;
+      PlayList playList;
+      int _stems;
+      QVector<int> channelStem;
+      QVector<int> synthStem;
+      QVector<float*> out;
+
+      void renderFrames(unsigned n);
+
+   public:
+      static const int MAX_BLOCK = 4096;  // max frames processed by the synthesizers at once
+
+      ScoreRenderer(Score*, int sampleRate, SyntiState& state, int blockSize = 512,
+         const SynthSettings& = SynthSettings());
+      ~ScoreRenderer();
+
+      MasterSynth* synth() const    { return synti;       }
+      int sampleRate() const        { return _sampleRate; }
+      int blockSize() const         { return _blockSize;  }
+      int frames() const            { return _frames;     }
+      int position() const          { return playTime;    }
+      bool atEnd() const            { return playTime >= _frames; }
+
+      void setRenderThreads(int n);
+      void setStems(bool);
+      int outputs() const           { return qMax(_stems, 1); }
+
+      int render(float** out);
+      bool run(Callback, void* data);
+      };
+
+#endif
+
@@ -39,6 +39,171 @@ void Synth::reset()
       _active = false;
       }
 
+//---------------------------------------------------------
+//   SynthWorker
+//    Renders one synthesizer into a private buffer for
+//    MasterSynth::process(). The audio thread never takes
+//    a lock or makes a system call to hand over a block:
+//    startBlock() only stores an atomic state. While the
+//    transport plays, the worker spins briefly after each
+//    block and then polls the state with short sleeps.
+//    While it is stopped, the gui parks the worker on a
+//    wait condition. A block which the worker has not
+//    picked up when the audio thread reaches the barrier
+//    is rendered by the audio thread itself, so a sleeping
+//    or parked worker costs no more than serial rendering.
+//---------------------------------------------------------
+
+class SynthWorker : public QThread {
+      enum { IDLE, START, RUNNING, DONE };
+
+      static const int SPIN        = 200;    // polls before the worker sleeps
+      static const int IDLE_USLEEP = 100;
+
+      Synth* synth;
+      QAtomicInt state;
+      QAtomicInt quit;
+      QAtomicInt parked;            // written by the gui under parkMutex
+      QMutex parkMutex;
+      QWaitCondition unpark;
+      unsigned frames;
+      float gain;
+      float* buffer;
+
+      virtual void run();
+      void render();
+
+   public:
+      static const unsigned MAX_FRAMES = 4096;
+
+      SynthWorker(Synth* s);
+      ~SynthWorker();
+      void startBlock(unsigned n, float g);
+      void waitBlock();
+      void setParked(bool);
+      const float* data() const { return buffer; }
+      };
+
+SynthWorker::SynthWorker(Synth* s)
+   : QThread()
+      {
+      synth  = s;
+      frames = 0;
+      gain   = 1.0;
+      buffer = new float[MAX_FRAMES * 2];
+      state.fetchAndStoreRelaxed(IDLE);
+      parked.fetchAndStoreRelaxed(1);
+      }
+
+SynthWorker::~SynthWorker()
+      {
+      quit.fetchAndStoreRelease(1);
+      setParked(false);
+      wait();
+      delete[] buffer;
+      }
+
+//---------------------------------------------------------
+//   render
+//    render the block; called by whichever thread moved
+//    the state from START to RUNNING
+//---------------------------------------------------------
+
+void SynthWorker::render()
+      {
+      memset(buffer, 0, frames * 2 * sizeof(float));
+      synth->process(frames, buffer, gain);
+      state.fetchAndStoreRelease(DONE);
+      }
+
+//---------------------------------------------------------
+//   run
+//---------------------------------------------------------
+
+void SynthWorker::run()
+      {
+      int idle = 0;
+      while (!quit.fetchAndAddAcquire(0)) {
+            if (state.testAndSetAcquire(START, RUNNING)) {
+                  render();
+                  idle = 0;
+                  }
+            else if (idle < SPIN) {
+                  ++idle;
+                  yieldCurrentThread();
+                  }
+            else if (parked.fetchAndAddAcquire(0)) {
+                  parkMutex.lock();
+                  while (parked.fetchAndAddAcquire(0) && !quit.fetchAndAddAcquire(0))
+                        unpark.wait(&parkMutex);
+                  parkMutex.unlock();
+                  idle = 0;
+                  }
+            else
+                  usleep(IDLE_USLEEP);
+            }
+      }
+
+//---------------------------------------------------------
+//   setParked
+//    called by the gui thread when the transport stops or
+//    starts; never by the audio thread
+//---------------------------------------------------------
+
+void SynthWorker::setParked(bool val)
+      {
+      QMutexLocker locker(&parkMutex);
+      parked.fetchAndStoreRelease(val);
+      if (!val)
+            unpark.wakeAll();
+      }
+
+//---------------------------------------------------------
+//   startBlock
+//    called by the audio thread
+//---------------------------------------------------------
+
+void SynthWorker::startBlock(unsigned n, float g)
+      {
+      frames = n;
+      gain   = g;
+      state.fetchAndStoreRelease(START);
+      }
+
+//---------------------------------------------------------
+//   waitBlock
+//    the barrier at the end of the block, called by the
+//    audio thread; a block the worker did not pick up yet
+//    is rendered here, otherwise the audio thread spins
+//    until the worker is done
+//---------------------------------------------------------
+
+void SynthWorker::waitBlock()
+      {
+      if (state.testAndSetAcquire(START, RUNNING)) {
+            render();
+            return;
+            }
+      while (state.fetchAndAddAcquire(0) != DONE)
+            QThread::yieldCurrentThread();
+      }
+
+//---------------------------------------------------------
+//   SynthSettings
+//    defaults as in the preferences
+//---------------------------------------------------------
+
+SynthSettings::SynthSettings()
+      {
+      tuning         = 440.0;
+      masterGain     = 0.2;
+      reverbRoomSize = 0.5;
+      reverbDamp     = 0.5;
+      reverbWidth    = 1.0;
+      reverbGain     = 0.5;
+      chorusGain     = 0.5;
+      }
+
 //---------------------------------------------------------
 //   MasterSynth
 //---------------------------------------------------------
@@ -54,51 +219,179 @@ MasterSynth::MasterSynth()
 
 MasterSynth::~MasterSynth()
       {
+      setParallel(false);
       foreach(Synth* s, syntis)
             delete s;
       }
 
 //---------------------------------------------------------
 //   init
+//    create the synthesizers with the settings from the
+//    preferences; there are none without an audio driver
 //---------------------------------------------------------
 
 void MasterSynth::init(int sampleRate)
       {
-      if (preferences.useJackAudio
+      if (!(preferences.useJackAudio
          || preferences.useJackMidi
          || preferences.useAlsaAudio
          || preferences.usePortaudioAudio
-         || preferences.usePulseAudio) {
-            syntis.append(new FluidS::Fluid());
+         || preferences.usePulseAudio))
+            return;
+      create(sampleRate, preferences.synthSettings());
+      // only the live synthesizer renders in parallel;
+      // offline renderers are faster than real time anyway
+      setParallel(syntis.size() > 1 && QThread::idealThreadCount() > 1);
+      }
+
+//---------------------------------------------------------
+//   create
+//    create and initialize all synthesizers; does not
+//    depend on the preferences
+//---------------------------------------------------------
+
+void MasterSynth::create(int sampleRate, const SynthSettings& ss)
+      {
+      syntis.append(new FluidS::Fluid());
 #ifdef AEOLUS
-            syntis.append(new Aeolus());
+      syntis.append(new Aeolus());
 #endif
-            }
       foreach(Synth* s, syntis)
             s->init(sampleRate);
       foreach(Synth* s, syntis) {
-            s->setMasterTuning(preferences.tuning);
-            s->setParameter(SParmId(FLUID_ID, 1, 0).val, preferences.reverbRoomSize);
-            s->setParameter(SParmId(FLUID_ID, 1, 1).val, preferences.reverbDamp);
-            s->setParameter(SParmId(FLUID_ID, 1, 2).val, preferences.reverbWidth);
-            s->setParameter(SParmId(FLUID_ID, 1, 3).val, preferences.reverbGain);
-            s->setParameter(SParmId(FLUID_ID, 2, 4).val, preferences.chorusGain);
+            s->setMasterTuning(ss.tuning);
+            s->setParameter(SParmId(FLUID_ID, 1, 0).val, ss.reverbRoomSize);
+            s->setParameter(SParmId(FLUID_ID, 1, 1).val, ss.reverbDamp);
+            s->setParameter(SParmId(FLUID_ID, 1, 2).val, ss.reverbWidth);
+            s->setParameter(SParmId(FLUID_ID, 1, 3).val, ss.reverbGain);
+            s->setParameter(SParmId(FLUID_ID, 2, 4).val, ss.chorusGain);
+            }
+      _gain = ss.masterGain;
+      }
+
+//---------------------------------------------------------
+//   setParallel
+//    render the synthesizers concurrently, one worker
+//    thread for every synthesizer but the first, which
+//    the calling thread renders; must not be called while
+//    process() is running. The workers start parked.
+//---------------------------------------------------------
+
+void MasterSynth::setParallel(bool val)
+      {
+      if (val == parallel())
+            return;
+      if (val) {
+            workers.append(0);
+            for (int i = 1; i < syntis.size(); ++i) {
+                  SynthWorker* w = new SynthWorker(syntis[i]);
+                  w->start(QThread::TimeCriticalPriority);
+                  workers.append(w);
+                  }
+            }
+      else {
+            qDeleteAll(workers);
+            workers.clear();
+            }
+      }
+
+//---------------------------------------------------------
+//   setWorkersParked
+//    park the workers while the transport is stopped, so
+//    they do not poll; called by the gui thread
+//---------------------------------------------------------
+
+void MasterSynth::setWorkersParked(bool val)
+      {
+      foreach(SynthWorker* w, workers) {
+            if (w)
+                  w->setParked(val);
             }
-      _gain = preferences.masterGain;
       }
 
 //---------------------------------------------------------
 //   process
+//    With more than one active synthesizer, all but the
+//    first run on their workers while the calling thread
+//    renders the first one. The worker buffers are added
+//    in synthesizer order, so the result is the same as
+//    from serial rendering.
 //---------------------------------------------------------
 
 void MasterSynth::process(unsigned n, float* p)
       {
-      foreach(Synth* s, syntis) {
+      QVarLengthArray<int, 8> active;
+      for (int i = 0; i < syntis.size(); ++i) {
+            if (syntis[i]->active())
+                  active.append(i);
+            }
+      if (active.size() < 2 || workers.isEmpty() || n > SynthWorker::MAX_FRAMES) {
+            for (int i = 0; i < active.size(); ++i)
+                  syntis[active[i]]->process(n, p, _gain);
+            return;
+            }
+      for (int i = 1; i < active.size(); ++i)
+            workers[active[i]]->startBlock(n, _gain);
+      syntis[active[0]]->process(n, p, _gain);
+      for (int i = 1; i < active.size(); ++i) {
+            SynthWorker* w = workers[active[i]];
+            w->waitBlock();
+            const float* b = w->data();
+            for (unsigned k = 0; k < n * 2; ++k)
+                  p[k] += b[k];
+            }
+      }
+
+//---------------------------------------------------------
+//   processStems
+//    channelStem: stem of every midi channel
+//    synthStem:   stem for synthesizers which render all
+//                 channels into one output
+//---------------------------------------------------------
+
+void MasterSynth::processStems(unsigned n, float** stems, const QVector<int>& channelStem,
+   const QVector<int>& synthStem)
+      {
+      for (int i = 0; i < syntis.size(); ++i) {
+            Synth* s = syntis[i];
             if (s->active())
-                  s->process(n, p, _gain);
+                  s->processStems(n, stems, channelStem, i < synthStem.size() ? synthStem[i] : -1, _gain);
             }
       }
 
+//---------------------------------------------------------
+//   setRenderThreads
+//    let the synthesizers spread their work over n threads;
+//    used for offline rendering
+//---------------------------------------------------------
+
+void MasterSynth::setRenderThreads(int n)
+      {
+      foreach(Synth* s, syntis)
+            s->setRenderThreads(n);
+      }
+
+//---------------------------------------------------------
+//   prefetchProgram
+//---------------------------------------------------------
+
+void MasterSynth::prefetchProgram(int syntiIdx, int bank, int program)
+      {
+      if (syntiIdx >= 0 && syntiIdx < syntis.size())
+            syntis[syntiIdx]->prefetchProgram(bank, program);
+      }
+
+//---------------------------------------------------------
+//   waitPrefetch
+//    wait until all prefetched programs are loaded
+//---------------------------------------------------------
+
+void MasterSynth::waitPrefetch()
+      {
+      foreach(Synth* s, syntis)
+            s->waitPrefetch();
+      }
+
 //---------------------------------------------------------
 //   reset
 //---------------------------------------------------------
@@ -113,7 +406,7 @@ void MasterSynth::reset()
 //   play
 //---------------------------------------------------------
 
-void MasterSynth::play(const Event& event, int syntiIdx)
+void MasterSynth::play(const ChannelEvent& event, int syntiIdx)
       {
       syntis[syntiIdx]->setActive(true);
       syntis[syntiIdx]->play(event);
@@ -22,8 +22,9 @@
 #define __SYNTI_H__
 
 struct MidiPatch;
-class Event;
+struct ChannelEvent;
 class Synth;
+class SynthWorker;
 
 #include "libmscore/sparm.h"
 
@@ -53,7 +54,23 @@ class Synth {
       virtual QStringList soundFonts() const = 0;
 
       virtual void process(unsigned, float*, float) = 0;
-      virtual void play(const Event&) = 0;
+      virtual void play(const ChannelEvent&) = 0;
+
+      // offline rendering of one output per channel group: channel c
+      // goes to stems[channelStem[c]]; synthesizers which cannot
+      // separate their channels write all to stems[defaultStem]
+      virtual void processStems(unsigned n, float** stems, const QVector<int>& /*channelStem*/,
+         int defaultStem, float gain) {
+            if (defaultStem >= 0)
+                  process(n, stems[defaultStem], gain);
+            }
+
+      // number of threads used by process(); for offline rendering only
+      virtual void setRenderThreads(int) {}
+
+      // load the samples of a program in the background before it is used
+      virtual void prefetchProgram(int /*bank*/, int /*program*/) {}
+      virtual void waitPrefetch() {}
 
       virtual const QList<MidiPatch*>& getPatchInfo() const = 0;
 
@@ -73,21 +90,48 @@ class Synth {
       virtual void allNotesOff(int /*channel*/) {}
       };
 
+//---------------------------------------------------------
+//   SynthSettings
+//    initial settings of all synthesizers; the gui takes
+//    them from the preferences
+//---------------------------------------------------------
+
+struct SynthSettings {
+      double tuning;
+      double masterGain;
+      double reverbRoomSize;
+      double reverbDamp;
+      double reverbWidth;
+      double reverbGain;
+      double chorusGain;
+
+      SynthSettings();
+      };
+
 //---------------------------------------------------------
 //   MasterSynth
 //---------------------------------------------------------
 
 class MasterSynth {
       QList<Synth*> syntis;
+      QList<SynthWorker*> workers;  // one per synthesizer but the first, empty: render serially
       float _gain;
 
    public:
       MasterSynth();
       ~MasterSynth();
       void init(int sampleRate);
+      void create(int sampleRate, const SynthSettings&);
 
       void process(unsigned, float*);
-      void play(const Event&, int);
+      void setParallel(bool);
+      void setWorkersParked(bool);
+      bool parallel() const   { return !workers.isEmpty(); }
+      void processStems(unsigned, float**, const QVector<int>& channelStem, const QVector<int>& synthStem);
+      void play(const ChannelEvent&, int);
+      void setRenderThreads(int n);
+      void prefetchProgram(int syntiIdx, int bank, int program);
+      void waitPrefetch();
 
       double gain() const     { return _gain; }
       void setGain(float val) { _gain = val;  }
@@ -0,0 +1,391 @@
+//=============================================================================
+//  MuseScore
+//  Music Composition & Notation
+//  $Id:$
+//
+//  Copyright (C) 2012 Werner Schweer
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2
+//  as published by the Free Software Foundation and appearing in
+//  the file LICENCE.GPL
+//=============================================================================
+
+#include <QtTest/QtTest>
+
+#include "aeolus/aeolus/addsynth.h"
+#include "aeolus/aeolus/asection.h"
+#include "aeolus/aeolus/division.h"
+#include "aeolus/aeolus/rankwave.h"
+#include "aeolus/aeolus/scales.h"
+#include "aeolus/aeolus/v4sf.h"
+
+static const int SAMPLERATE = 44100;
+static const int SECOND     = SAMPLERATE / PERIOD;   // periods per second
+
+//---------------------------------------------------------
+//   stops of the full organ: footage as fraction of 8'
+//---------------------------------------------------------
+
+static const struct {
+      int fn, fd;
+      int pan;
+      } stops[] = {
+      { 1, 2, 'C' },    // 16'
+      { 1, 1, 'C' },    // 8'
+      { 1, 1, 'L' },    // 8'
+      { 2, 1, 'C' },    // 4'
+      { 2, 1, 'R' },    // 4'
+      { 3, 1, 'L' },    // 2 2/3'
+      { 4, 1, 'C' },    // 2'
+      { 5, 1, 'R' },    // 1 3/5'
+      { 6, 1, 'L' },    // 1 1/3'
+      { 8, 1, 'C' },    // 1'
+      { 12, 1, 'R' },   // mixture
+      { 16, 1, 'L' },   // mixture
+      };
+
+static const int NSTOPS = sizeof(stops) / sizeof(*stops);
+
+// a wide chord over the whole keyboard
+
+static const int chord[] = { 36, 43, 48, 52, 55, 60, 64, 67, 72, 76, 79, 84 };
+static const int NCHORD  = sizeof(chord) / sizeof(*chord);
+
+//---------------------------------------------------------
+//   Organ
+//    one division with all stops on its own section
+//---------------------------------------------------------
+
+struct Organ {
+      Asection* asect;
+      Division* division;
+      Rankwave* ranks[NSTOPS];
+      float W[PERIOD], X[PERIOD], Y[PERIOD], R[PERIOD];
+
+      Organ();
+      ~Organ();
+      void noteOn(int note);
+      void noteOff(int note);
+      void render(int periods);
+      };
+
+//---------------------------------------------------------
+//   Organ
+//    generate the wavetables of all stops; the stops have
+//    no random components, so every organ sounds the same
+//---------------------------------------------------------
+
+Organ::Organ()
+      {
+      asect    = new Asection(SAMPLERATE);
+      asect->set_size(0.075f);
+      division = new Division(asect, SAMPLERATE);
+
+      Addsynth synth;
+      for (int h = 0; h < 16; ++h)
+            synth._h_lev.setv(h, 0, -6.0f - 3.0f * h);
+      for (int i = 0; i < NSTOPS; ++i) {
+            synth._fn = stops[i].fn;
+            synth._fd = stops[i].fd;
+            ranks[i] = new Rankwave(NOTE_MIN, NOTE_MAX);
+            ranks[i]->gen_waves(&synth, SAMPLERATE, 440.0f, scales[5]._data);
+            division->set_rank(i, ranks[i], stops[i].pan, 0);
+            }
+      }
+
+Organ::~Organ()
+      {
+      delete division;
+      delete asect;
+      for (int i = 0; i < NSTOPS; ++i)
+            delete ranks[i];
+      }
+
+void Organ::noteOn(int note)
+      {
+      for (int i = 0; i < NSTOPS; ++i)
+            ranks[i]->note_on(note);
+      }
+
+void Organ::noteOff(int note)
+      {
+      for (int i = 0; i < NSTOPS; ++i)
+            ranks[i]->note_off(note);
+      }
+
+//---------------------------------------------------------
+//   render
+//    run the division and its section as Aeolus::process()
+//    does, one period at a time
+//---------------------------------------------------------
+
+void Organ::render(int periods)
+      {
+      for (int i = 0; i < periods; ++i) {
+            memset(W, 0, sizeof(W));
+            memset(X, 0, sizeof(X));
+            memset(Y, 0, sizeof(Y));
+            memset(R, 0, sizeof(R));
+            division->process();
+            asect->process(1.0f, W, X, Y, R);
+            }
+      }
+
+//---------------------------------------------------------
+//   scalar references
+//    the loops the kernels in v4sf.h replace
+//---------------------------------------------------------
+
+static float refRamp(float* q, const float* r, int n, float g, float dg)
+      {
+      for (int i = 0; i < n; i++) {
+            q[i] += g * r[i];
+            g -= dg;
+            }
+      return g;
+      }
+
+static float* refInterp(float* q, float* r, int n, int s,
+   float& y, float dy, float& g, float dg)
+      {
+      for (int i = 0; i < n; i++) {
+            q[i] += g * (r[0] + y * (r[1] - r[0]));
+            g -= dg;
+            y += dy;
+            r += s;
+            }
+      return r;
+      }
+
+static void refMatrix(const float* p, int stride, int n,
+   float gr, float gw, float gx1, float gx2, float gy1, float gy2,
+   float* R, float* W, float* x, float* y)
+      {
+      for (int i = 0; i < n; i++) {
+            float t0 = p[0 * stride];
+            float t1 = p[1 * stride];
+            float t2 = p[2 * stride];
+            float t3 = p[3 * stride];
+            p++;
+            float s = t0 + t1 + t2 + t3;
+            R[i] += gr * s;
+            W[i] += gw * s;
+            x[i] = gx1 * (t3 + t0) + gx2 * (t2 + t1);
+            y[i] = gy1 * (t3 - t0) + gy2 * (t2 - t1);
+            }
+      }
+
+static void refRotate(float* X, float* Y, const float* x, const float* y,
+   int n, float c, float s)
+      {
+      for (int i = 0; i < n; i++) {
+            X[i] += c * x[i] + s * y[i];
+            Y[i] += c * y[i] - s * x[i];
+            }
+      }
+
+//---------------------------------------------------------
+//   noise
+//    fill a buffer with noise in [-1, 1)
+//---------------------------------------------------------
+
+static void noise(float* p, int n)
+      {
+      for (int i = 0; i < n; i++)
+            p[i] = 2.0f * qrand() / RAND_MAX - 1.0f;
+      }
+
+//---------------------------------------------------------
+//   maxError
+//---------------------------------------------------------
+
+static float maxError(const float* a, const float* b, int n)
+      {
+      float err = 0.0f;
+      for (int i = 0; i < n; i++)
+            err = qMax(err, qAbs(a[i] - b[i]));
+      return err;
+      }
+
+//---------------------------------------------------------
+//   TestRankwave
+//---------------------------------------------------------
+
+class TestRankwave : public QObject
+      {
+      Q_OBJECT
+      Organ* organ;
+
+   private slots:
+      void initTestCase();
+      void cleanupTestCase();
+      void fullOrgan();
+      void addRamp();
+      void addInterp();
+      void add();
+      void matrix();
+      void rotate();
+      void fullOrganBenchmark();
+      };
+
+//---------------------------------------------------------
+//   initTestCase
+//    hold the chord on the full organ
+//---------------------------------------------------------
+
+void TestRankwave::initTestCase()
+      {
+      organ = new Organ;
+      for (int k = 0; k < NCHORD; ++k)
+            organ->noteOn(chord[k]);
+      }
+
+void TestRankwave::cleanupTestCase()
+      {
+      delete organ;
+      }
+
+//---------------------------------------------------------
+//   fullOrgan
+//    the held chord produces a finite, audible signal
+//---------------------------------------------------------
+
+void TestRankwave::fullOrgan()
+      {
+      organ->render(SECOND);
+      float peak = 0.0f;
+      for (int i = 0; i < PERIOD; ++i) {
+            QVERIFY(qIsFinite(organ->W[i]) && qIsFinite(organ->X[i]) && qIsFinite(organ->Y[i]));
+            peak = qMax(peak, qAbs(organ->W[i]));
+            }
+      QVERIFY(peak > 1e-4f);
+      }
+
+//---------------------------------------------------------
+//   addRamp
+//    the kernels compute their ramps as start + i * step,
+//    so they only have to match the scalar loops within
+//    rounding; odd lengths exercise the scalar tail
+//---------------------------------------------------------
+
+void TestRankwave::addRamp()
+      {
+      static const int lengths[] = { PERIOD, 1, 3, 37 };
+      float r[PERIOD], q[PERIOD], ref[PERIOD];
+      for (unsigned k = 0; k < sizeof(lengths) / sizeof(*lengths); k++) {
+            int n = lengths[k];
+            noise(r, n);
+            noise(q, n);
+            memcpy(ref, q, n * sizeof(float));
+            float g  = add_ramp(q, r, n, 0.8f, 0.01f);
+            float rg = refRamp(ref, r, n, 0.8f, 0.01f);
+            QVERIFY(maxError(q, ref, n) < 1e-5f);
+            QVERIFY(qAbs(g - rg) < 1e-5f);
+            }
+      }
+
+//---------------------------------------------------------
+//   addInterp
+//    contiguous (s == 1) and strided wavetable reads
+//---------------------------------------------------------
+
+void TestRankwave::addInterp()
+      {
+      static const int lengths[] = { PERIOD, 1, 3, 37 };
+      float r[3 * PERIOD + 1], q[PERIOD], ref[PERIOD];
+      noise(r, 3 * PERIOD + 1);
+      for (int s = 1; s <= 3; s += 2) {
+            for (unsigned k = 0; k < sizeof(lengths) / sizeof(*lengths); k++) {
+                  int n = lengths[k];
+                  noise(q, n);
+                  memcpy(ref, q, n * sizeof(float));
+                  float y  = 0.25f, g  = 0.9f;
+                  float ry = 0.25f, rg = 0.9f;
+                  float* p  = add_interp(q, r, n, s, y, 0.002f, g, 0.003f);
+                  float* rp = refInterp(ref, r, n, s, ry, 0.002f, rg, 0.003f);
+                  QCOMPARE(p, rp);
+                  QVERIFY(maxError(q, ref, n) < 1e-5f);
+                  QVERIFY(qAbs(y - ry) < 1e-5f);
+                  QVERIFY(qAbs(g - rg) < 1e-5f);
+                  }
+            }
+      }
+
+//---------------------------------------------------------
+//   add
+//---------------------------------------------------------
+
+void TestRankwave::add()
+      {
+      float p[PERIOD], q[PERIOD], ref[PERIOD];
+      noise(p, PERIOD);
+      noise(q, PERIOD);
+      for (int i = 0; i < PERIOD; i++)
+            ref[i] = q[i] + p[i];
+      add4(q, p, PERIOD);
+      QCOMPARE(maxError(q, ref, PERIOD), 0.0f);
+      }
+
+//---------------------------------------------------------
+//   matrix
+//---------------------------------------------------------
+
+void TestRankwave::matrix()
+      {
+      enum { STRIDE = 2 * PERIOD };
+      float p[4 * STRIDE];
+      float R[PERIOD], W[PERIOD], x[PERIOD], y[PERIOD];
+      float rR[PERIOD], rW[PERIOD], rx[PERIOD], ry[PERIOD];
+      noise(p, 4 * STRIDE);
+      noise(R, PERIOD);
+      noise(W, PERIOD);
+      memcpy(rR, R, sizeof(R));
+      memcpy(rW, W, sizeof(W));
+      matrix4(p, STRIDE, PERIOD, 0.3f, 0.7f, 0.4f, 0.6f, 0.2f, 0.5f, R, W, x, y);
+      refMatrix(p, STRIDE, PERIOD, 0.3f, 0.7f, 0.4f, 0.6f, 0.2f, 0.5f, rR, rW, rx, ry);
+      QVERIFY(maxError(R, rR, PERIOD) < 1e-5f);
+      QVERIFY(maxError(W, rW, PERIOD) < 1e-5f);
+      QVERIFY(maxError(x, rx, PERIOD) < 1e-5f);
+      QVERIFY(maxError(y, ry, PERIOD) < 1e-5f);
+      }
+
+//---------------------------------------------------------
+//   rotate
+//---------------------------------------------------------
+
+void TestRankwave::rotate()
+      {
+      float x[PERIOD], y[PERIOD], X[PERIOD], Y[PERIOD], rX[PERIOD], rY[PERIOD];
+      noise(x, PERIOD);
+      noise(y, PERIOD);
+      noise(X, PERIOD);
+      noise(Y, PERIOD);
+      memcpy(rX, X, sizeof(X));
+      memcpy(rY, Y, sizeof(Y));
+      float c = cosf(0.8f);
+      float s = sinf(0.8f);
+      rotate4(X, Y, x, y, PERIOD, c, s);
+      refRotate(rX, rY, x, y, PERIOD, c, s);
+      QVERIFY(maxError(X, rX, PERIOD) < 1e-5f);
+      QVERIFY(maxError(Y, rY, PERIOD) < 1e-5f);
+      }
+
+//---------------------------------------------------------
+//   fullOrganBenchmark
+//    one second of the sustained chord on all stops; to keep
+//    up with 64 frame buffers this must stay well below one
+//    second
+//---------------------------------------------------------
+
+void TestRankwave::fullOrganBenchmark()
+      {
+      QBENCHMARK {
+            organ->render(SECOND);
+            }
+      }
+
+QTEST_MAIN(TestRankwave)
+
+#include "tst_rankwave.moc"
+
@@ -0,0 +1,124 @@
+//=============================================================================
+//  MuseScore
+//  Music Composition & Notation
+//  $Id:$
+//
+//  Copyright (C) 2012 Werner Schweer
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2
+//  as published by the Free Software Foundation and appearing in
+//  the file LICENCE.GPL
+//=============================================================================
+
+#include <QtTest/QtTest>
+
+#include "fluid/cmdfifo.h"
+
+using namespace FluidS;
+
+static const int WRITERS  = 4;
+static const int COMMANDS = 200000;
+
+//---------------------------------------------------------
+//   Writer
+//---------------------------------------------------------
+
+class Writer : public QThread {
+      CommandFifo* fifo;
+      int id;
+
+   public:
+      Writer(CommandFifo* f, int n) : fifo(f), id(n) {}
+      void run() {
+            FluidCommand cmd;
+            cmd.chan = id;
+            for (int i = 0; i < COMMANDS; ++i) {
+                  cmd.value = i;
+                  cmd.count = i * 3;
+                  while (!fifo->enqueue(cmd))
+                        ;
+                  }
+            }
+      };
+
+//---------------------------------------------------------
+//   TestCmdFifo
+//---------------------------------------------------------
+
+class TestCmdFifo : public QObject
+      {
+      Q_OBJECT
+
+   private slots:
+      void fifo1();
+      void fifo2();
+      };
+
+//---------------------------------------------------------
+//   fifo1
+//    single thread: fill, overflow, drain, several rounds
+//---------------------------------------------------------
+
+void TestCmdFifo::fifo1()
+      {
+      CommandFifo* fifo = new CommandFifo;
+      FluidCommand cmd;
+      QVERIFY(!fifo->dequeue(&cmd));
+      for (int round = 0; round < 3; ++round) {
+            for (int i = 0; i < CMD_FIFO_SIZE; ++i) {
+                  cmd.value = i;
+                  QVERIFY(fifo->enqueue(cmd));
+                  }
+            QVERIFY(!fifo->enqueue(cmd));
+            for (int i = 0; i < CMD_FIFO_SIZE; ++i) {
+                  QVERIFY(fifo->dequeue(&cmd));
+                  QCOMPARE(cmd.value, i);
+                  }
+            QVERIFY(!fifo->dequeue(&cmd));
+            }
+      delete fifo;
+      }
+
+//---------------------------------------------------------
+//   fifo2
+//    several writer threads, reader in this thread; the
+//    commands of every writer have to arrive complete and
+//    in order
+//---------------------------------------------------------
+
+void TestCmdFifo::fifo2()
+      {
+      CommandFifo* fifo = new CommandFifo;
+      QList<Writer*> writers;
+      for (int i = 0; i < WRITERS; ++i)
+            writers.append(new Writer(fifo, i));
+      foreach(Writer* w, writers)
+            w->start();
+
+      int next[WRITERS];
+      memset(next, 0, sizeof(next));
+      int errors = 0;
+      for (int n = 0; n < WRITERS * COMMANDS;) {
+            FluidCommand cmd;
+            if (!fifo->dequeue(&cmd))
+                  continue;
+            if (cmd.chan < 0 || cmd.chan >= WRITERS || cmd.value != next[cmd.chan]
+               || cmd.count != cmd.value * 3)
+                  ++errors;
+            else
+                  ++next[cmd.chan];
+            ++n;
+            }
+      foreach(Writer* w, writers)
+            w->wait();
+      qDeleteAll(writers);
+      QCOMPARE(errors, 0);
+      FluidCommand cmd;
+      QVERIFY(!fifo->dequeue(&cmd));
+      delete fifo;
+      }
+
+QTEST_MAIN(TestCmdFifo)
+
+#include "tst_cmdfifo.moc"
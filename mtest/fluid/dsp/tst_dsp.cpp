@@ -0,0 +1,250 @@
+//=============================================================================
+//  MuseScore
+//  Music Composition & Notation
+//  $Id:$
+//
+//  Copyright (C) 2012 Werner Schweer
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2
+//  as published by the Free Software Foundation and appearing in
+//  the file LICENCE.GPL
+//=============================================================================
+
+#include <QtTest/QtTest>
+
+#include "fluid/fluid.h"
+#include "fluid/voice.h"
+#include "fluid/sfont.h"
+
+using namespace FluidS;
+
+static const int SAMPLE_LEN = 20000;
+static const int BLOCKS     = 200;
+static const int VOICES     = 64;
+
+static const int methods[] = {
+      FLUID_INTERP_NONE, FLUID_INTERP_LINEAR, FLUID_INTERP_4THORDER, FLUID_INTERP_7THORDER
+      };
+
+//---------------------------------------------------------
+//   TestDsp
+//---------------------------------------------------------
+
+class TestDsp : public QObject
+      {
+      Q_OBJECT
+      Sample* sample;
+      QList<DspKernelType> kernels;
+
+      Voice* createVoice(float pitch, int sampleMode);
+      int render(Voice*, int method, unsigned n, float* buf, int blocks);
+      void compare(DspKernelType);
+
+   private slots:
+      void initTestCase();
+      void cleanupTestCase();
+      void sse2();
+      void avx2();
+      void voicesPerCore();
+      void benchmark_data();
+      void benchmark();
+      };
+
+//---------------------------------------------------------
+//   initTestCase
+//    a sample of random noise, looped in the middle
+//---------------------------------------------------------
+
+void TestDsp::initTestCase()
+      {
+      Voice::dsp_float_config();
+      sample       = new Sample(0);
+      sample->data = new short[SAMPLE_LEN];
+      qsrand(1);
+      for (int i = 0; i < SAMPLE_LEN; ++i)
+            sample->data[i] = short(qrand() & 0xffff);
+      sample->start     = 8;
+      sample->end       = SAMPLE_LEN - 1;
+      sample->loopstart = 1000;
+      sample->loopend   = 1500;
+
+      kernels.append(DSP_SCALAR);
+      if (Voice::setDspKernels(DSP_SSE2))
+            kernels.append(DSP_SSE2);
+      if (Voice::setDspKernels(DSP_AVX2))
+            kernels.append(DSP_AVX2);
+      }
+
+void TestDsp::cleanupTestCase()
+      {
+      delete sample;
+      Voice::dsp_float_config();
+      }
+
+//---------------------------------------------------------
+//   createVoice
+//---------------------------------------------------------
+
+Voice* TestDsp::createVoice(float pitch, int sampleMode)
+      {
+      Voice* v = new Voice(0);
+      v->sample         = sample;
+      v->start          = sample->start;
+      v->end            = sample->end;
+      v->loopstart      = sample->loopstart;
+      v->loopend        = sample->loopend;
+      v->has_looped     = false;
+      v->volenv_section = 0;
+      v->amp            = 0.1f;
+      v->amp_incr       = 1e-5f;
+      v->phase_incr     = pitch;
+      v->phase.setInt(sample->start);
+      v->gen[GEN_SAMPLEMODE].val = sampleMode;
+      return v;
+      }
+
+//---------------------------------------------------------
+//   render
+//    returns the number of samples written to buf
+//---------------------------------------------------------
+
+int TestDsp::render(Voice* v, int method, unsigned n, float* buf, int blocks)
+      {
+      int total = 0;
+      for (int i = 0; i < blocks; ++i) {
+            v->dsp_buf = buf + total;
+            int count = 0;
+            switch (method) {
+                  case FLUID_INTERP_NONE:
+                        count = v->dsp_float_interpolate_none(n);
+                        break;
+                  case FLUID_INTERP_LINEAR:
+                        count = v->dsp_float_interpolate_linear(n);
+                        break;
+                  case FLUID_INTERP_4THORDER:
+                        count = v->dsp_float_interpolate_4th_order(n);
+                        break;
+                  case FLUID_INTERP_7THORDER:
+                        count = v->dsp_float_interpolate_7th_order(n);
+                        break;
+                  }
+            total += count;
+            if (count < int(n))
+                  break;
+            }
+      return total;
+      }
+
+//---------------------------------------------------------
+//   compare
+//    render with the scalar reference and the vector
+//    kernels; the output has to be bit identical
+//---------------------------------------------------------
+
+void TestDsp::compare(DspKernelType type)
+      {
+      if (!kernels.contains(type)) {
+            qDebug("kernels not available on this cpu");
+            return;
+            }
+
+      static const float pitches[]  = { 1.0f, 0.37f, 1.5f, 2.913f, 7.1f, 0.0031f };
+      static const unsigned sizes[] = { 64, 61, 3 };
+      QVector<float> ref(BLOCKS * 64);
+      QVector<float> tst(BLOCKS * 64);
+
+      for (int m = 0; m < 4; ++m) {
+            for (unsigned p = 0; p < sizeof(pitches)/sizeof(*pitches); ++p) {
+                  for (int mode = FLUID_UNLOOPED; mode <= FLUID_LOOP_DURING_RELEASE; ++mode) {
+                        for (unsigned s = 0; s < sizeof(sizes)/sizeof(*sizes); ++s) {
+                              ref.fill(0.0f);
+                              tst.fill(0.0f);
+                              Voice::setDspKernels(DSP_SCALAR);
+                              Voice* v1 = createVoice(pitches[p], mode);
+                              int n1    = render(v1, methods[m], sizes[s], ref.data(), BLOCKS);
+                              Voice::setDspKernels(type);
+                              Voice* v2 = createVoice(pitches[p], mode);
+                              int n2    = render(v2, methods[m], sizes[s], tst.data(), BLOCKS);
+                              QCOMPARE(n2, n1);
+                              QVERIFY(memcmp(ref.data(), tst.data(), n1 * sizeof(float)) == 0);
+                              QCOMPARE(v2->phase.data, v1->phase.data);
+                              QCOMPARE(v2->amp, v1->amp);
+                              delete v1;
+                              delete v2;
+                              }
+                        }
+                  }
+            }
+      }
+
+void TestDsp::sse2()
+      {
+      compare(DSP_SSE2);
+      }
+
+void TestDsp::avx2()
+      {
+      compare(DSP_AVX2);
+      }
+
+//---------------------------------------------------------
+//   voicesPerCore
+//    number of looping voices one core can interpolate in
+//    real time at 44.1kHz, for every kernel set and
+//    interpolation method
+//---------------------------------------------------------
+
+void TestDsp::voicesPerCore()
+      {
+      float buf[64];
+      foreach(DspKernelType type, kernels) {
+            Voice::setDspKernels(type);
+            for (int m = 0; m < 4; ++m) {
+                  QList<Voice*> voices;
+                  for (int i = 0; i < VOICES; ++i)
+                        voices.append(createVoice(0.5f + i * 0.031f, FLUID_LOOP_DURING_RELEASE));
+                  QElapsedTimer timer;
+                  timer.start();
+                  qint64 samples = 0;
+                  for (int i = 0; i < 2000; ++i) {
+                        foreach(Voice* v, voices)
+                              samples += render(v, methods[m], 64, buf, 1);
+                        }
+                  qint64 ns = timer.nsecsElapsed();
+                  qDebug("%-6s interpolation %d: %6.0f voices/core", Voice::dspKernelName(),
+                     methods[m], double(samples) / (ns * 1e-9) / 44100.0);
+                  qDeleteAll(voices);
+                  }
+            }
+      Voice::dsp_float_config();
+      }
+
+//---------------------------------------------------------
+//   benchmark
+//---------------------------------------------------------
+
+void TestDsp::benchmark_data()
+      {
+      QTest::addColumn<int>("method");
+      QTest::newRow("none")   << int(FLUID_INTERP_NONE);
+      QTest::newRow("linear") << int(FLUID_INTERP_LINEAR);
+      QTest::newRow("4th")    << int(FLUID_INTERP_4THORDER);
+      QTest::newRow("7th")    << int(FLUID_INTERP_7THORDER);
+      }
+
+void TestDsp::benchmark()
+      {
+      QFETCH(int, method);
+      float buf[64];
+      Voice* v = createVoice(1.37f, FLUID_LOOP_DURING_RELEASE);
+      QBENCHMARK {
+            for (int i = 0; i < VOICES; ++i)
+                  render(v, method, 64, buf, 1);
+            }
+      delete v;
+      }
+
+QTEST_MAIN(TestDsp)
+
+#include "tst_dsp.moc"
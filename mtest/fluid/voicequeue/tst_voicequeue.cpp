@@ -0,0 +1,149 @@
+//=============================================================================
+//  MuseScore
+//  Music Composition & Notation
+//  $Id:$
+//
+//  Copyright (C) 2012 Werner Schweer
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2
+//  as published by the Free Software Foundation and appearing in
+//  the file LICENCE.GPL
+//=============================================================================
+
+#include <QtTest/QtTest>
+
+#include "fluid/fluid.h"
+#include "fluid/voice.h"
+#include "fluid/voicequeue.h"
+
+using namespace FluidS;
+
+static const int VOICES = 300;
+
+//---------------------------------------------------------
+//   TestVoiceQueue
+//---------------------------------------------------------
+
+class TestVoiceQueue : public QObject
+      {
+      Q_OBJECT
+      QList<Voice*> voices;
+
+      void randomize(Voice*);
+      Voice* lowest(const QList<Voice*>&) const;
+
+   private slots:
+      void init();
+      void cleanup();
+      void order();
+      void update();
+      };
+
+//---------------------------------------------------------
+//   randomize
+//    give the voice a random state which affects its
+//    steal priority
+//---------------------------------------------------------
+
+void TestVoiceQueue::randomize(Voice* v)
+      {
+      static const unsigned char states[] = {
+            FLUID_VOICE_ON, FLUID_VOICE_ON, FLUID_VOICE_SUSTAINED
+            };
+      v->chan           = (qrand() % 8) ? qrand() % 16 : NO_CHANNEL;
+      v->status         = states[qrand() % 3];
+      v->volenv_section = qrand() % FLUID_VOICE_ENVFINISHED;
+      v->volenv_val     = (qrand() % 1000) / 1000.0f;
+      }
+
+//---------------------------------------------------------
+//   lowest
+//    linear search, as done by the old
+//    Fluid::free_voice_by_kill()
+//---------------------------------------------------------
+
+Voice* TestVoiceQueue::lowest(const QList<Voice*>& vl) const
+      {
+      Voice* best = 0;
+      foreach(Voice* v, vl) {
+            if (best == 0 || v->stealPriority() < best->stealPriority())
+                  best = v;
+            }
+      return best;
+      }
+
+void TestVoiceQueue::init()
+      {
+      qsrand(7);
+      for (int i = 0; i < VOICES; ++i) {
+            Voice* v = new Voice(0);
+            v->id = i;
+            randomize(v);
+            voices.append(v);
+            }
+      }
+
+void TestVoiceQueue::cleanup()
+      {
+      qDeleteAll(voices);
+      voices.clear();
+      }
+
+//---------------------------------------------------------
+//   order
+//    voices leave the queue in steal priority order
+//---------------------------------------------------------
+
+void TestVoiceQueue::order()
+      {
+      VoiceQueue q;
+      foreach(Voice* v, voices)
+            q.insert(v);
+      QCOMPARE(q.size(), VOICES);
+
+      QList<Voice*> vl = voices;
+      while (!q.isEmpty()) {
+            Voice* v = q.top();
+            QCOMPARE(v->stealPriority(), lowest(vl)->stealPriority());
+            q.remove(v);
+            QCOMPARE(v->queueIndex, -1);
+            vl.removeOne(v);
+            }
+      QVERIFY(vl.isEmpty());
+      }
+
+//---------------------------------------------------------
+//   update
+//    change voices and remove voices from the middle of
+//    the queue
+//---------------------------------------------------------
+
+void TestVoiceQueue::update()
+      {
+      VoiceQueue q;
+      foreach(Voice* v, voices)
+            q.insert(v);
+
+      QList<Voice*> vl = voices;
+      for (int i = 0; i < 1000; ++i) {
+            Voice* v = vl[qrand() % vl.size()];
+            if (i % 7 == 0) {
+                  q.remove(v);
+                  vl.removeOne(v);
+                  }
+            else {
+                  randomize(v);
+                  q.update(v);
+                  }
+            QCOMPARE(q.size(), vl.size());
+            QCOMPARE(q.top()->stealPriority(), lowest(vl)->stealPriority());
+            }
+      q.clear();
+      foreach(Voice* v, voices)
+            QCOMPARE(v->queueIndex, -1);
+      }
+
+QTEST_MAIN(TestVoiceQueue)
+
+#include "tst_voicequeue.moc"
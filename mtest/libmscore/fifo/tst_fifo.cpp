@@ -0,0 +1,136 @@
+//=============================================================================
+//  MuseScore
+//  Music Composition & Notation
+//  $Id:$
+//
+//  Copyright (C) 2012 Werner Schweer
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2
+//  as published by the Free Software Foundation and appearing in
+//  the file LICENCE.GPL
+//=============================================================================
+
+#include <QtTest/QtTest>
+
+#include "libmscore/fifo.h"
+
+static const int FIFO_SIZE = 64;
+static const int MESSAGES  = 2000000;
+
+//---------------------------------------------------------
+//   Msg
+//---------------------------------------------------------
+
+struct Msg {
+      int serial;
+      int a;
+      double b;
+      };
+
+//---------------------------------------------------------
+//   MsgFifo
+//---------------------------------------------------------
+
+class MsgFifo : public FifoBase {
+      Msg messages[FIFO_SIZE];
+
+   public:
+      MsgFifo() { maxCount = FIFO_SIZE; clear(); }
+      bool enqueue(const Msg& msg) {
+            if (isFull())
+                  return false;
+            messages[widx] = msg;
+            push();
+            return true;
+            }
+      Msg dequeue() {
+            Msg msg = messages[ridx];
+            pop();
+            return msg;
+            }
+      };
+
+//---------------------------------------------------------
+//   Writer
+//---------------------------------------------------------
+
+class Writer : public QThread {
+      MsgFifo* fifo;
+
+   public:
+      Writer(MsgFifo* f) : fifo(f) {}
+      void run() {
+            for (int i = 0; i < MESSAGES; ++i) {
+                  Msg msg;
+                  msg.serial = i;
+                  msg.a      = i * 7;
+                  msg.b      = i * 0.5;
+                  while (!fifo->enqueue(msg))
+                        ;
+                  }
+            }
+      };
+
+//---------------------------------------------------------
+//   TestFifo
+//---------------------------------------------------------
+
+class TestFifo : public QObject
+      {
+      Q_OBJECT
+
+   private slots:
+      void fifo1();
+      void fifo2();
+      };
+
+//---------------------------------------------------------
+//   fifo1
+//    single thread: fill, overflow, drain
+//---------------------------------------------------------
+
+void TestFifo::fifo1()
+      {
+      MsgFifo fifo;
+      QVERIFY(fifo.isEmpty());
+      Msg msg;
+      for (int i = 0; i < FIFO_SIZE; ++i) {
+            msg.serial = i;
+            QVERIFY(fifo.enqueue(msg));
+            }
+      QVERIFY(fifo.isFull());
+      QVERIFY(!fifo.enqueue(msg));
+      for (int i = 0; i < FIFO_SIZE; ++i)
+            QCOMPARE(fifo.dequeue().serial, i);
+      QVERIFY(fifo.isEmpty());
+      QCOMPARE(fifo.count(), 0);
+      }
+
+//---------------------------------------------------------
+//   fifo2
+//    one writer thread, reader in this thread; every
+//    message has to arrive complete and in order
+//---------------------------------------------------------
+
+void TestFifo::fifo2()
+      {
+      MsgFifo fifo;
+      Writer writer(&fifo);
+      writer.start();
+      int errors = 0;
+      for (int i = 0; i < MESSAGES; ++i) {
+            while (fifo.isEmpty())
+                  ;
+            Msg msg = fifo.dequeue();
+            if (msg.serial != i || msg.a != i * 7 || msg.b != i * 0.5)
+                  ++errors;
+            }
+      writer.wait();
+      QCOMPARE(errors, 0);
+      QVERIFY(fifo.isEmpty());
+      }
+
+QTEST_MAIN(TestFifo)
+
+#include "tst_fifo.moc"
@@ -14,6 +14,7 @@
 #include <QtTest/QtTest>
 #include "mtest/testutils.h"
 #include "libmscore/score.h"
+#include "libmscore/event.h"
 
 #define DIR QString("libmscore/layout/")
 
@@ -32,6 +33,8 @@ class TestBenchmark : public QObject, public MTest
       void initTestCase();
       void benchmark1();
       void benchmark2();
+      void benchmark3();
+      void benchmark4();
       };
 
 //---------------------------------------------------------
@@ -64,6 +67,62 @@ void TestBenchmark::benchmark2()
       }
 
 
+//---------------------------------------------------------
+//   benchmark3
+//    render score to playback events
+//---------------------------------------------------------
+
+void TestBenchmark::benchmark3()
+      {
+      ChannelEventList events;
+      QBENCHMARK {                        // cold run
+            score->clearEventCache();
+            events.clear();
+            score->toEList(&events);
+            }
+      QVERIFY(!events.isEmpty());
+      }
+
+//---------------------------------------------------------
+//   sameEvents
+//---------------------------------------------------------
+
+static bool sameEvents(const ChannelEventList& l1, const ChannelEventList& l2)
+      {
+      if (l1.size() != l2.size())
+            return false;
+      for (int i = 0; i < l1.size(); ++i) {
+            const ChannelEvent& a = l1[i];
+            const ChannelEvent& b = l2[i];
+            if (a.tick() != b.tick() || a.type() != b.type() || a.channel() != b.channel()
+               || a.dataA() != b.dataA() || a.dataB() != b.dataB()
+               || a.tuning() != b.tuning() || a.note() != b.note())
+                  return false;
+            }
+      return true;
+      }
+
+//---------------------------------------------------------
+//   benchmark4
+//    cached rendering must give the same events as a
+//    cold run
+//---------------------------------------------------------
+
+void TestBenchmark::benchmark4()
+      {
+      ChannelEventList cold;
+      score->clearEventCache();
+      score->toEList(&cold);
+
+      ChannelEventList events;
+      QBENCHMARK {                        // warm run, measures cached
+            events.clear();
+            score->toEList(&events);
+            }
+      QVERIFY(!events.isEmpty());
+      QVERIFY(sameEvents(events, cold));
+      }
+
 QTEST_MAIN(TestBenchmark)
 #include "tst_benchmark.moc"
 